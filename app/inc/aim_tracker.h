@@ -0,0 +1,52 @@
+#ifndef AIM_TRACKER_H
+#define AIM_TRACKER_H
+
+#include <stdint.h>
+
+/*
+ * Constant velocity Kalman tracker of the auto aim target, run by the gimbal group:
+ *  - each new Orin offset added to the gimbal attitude at its capture tick is a measurement of
+ *    the target's world yaw and pitch, taken at that tick,
+ *  - yaw and pitch are tracked separately as an angle and an angular rate driven by white
+ *    acceleration noise,
+ *  - every gimbal tick the target is predicted forward to the current tick, so the gimbal gets
+ *    a fresh setpoint between camera frames instead of holding the last one,
+ *  - a measurement further than AIM_TRACKER_GATE from the prediction is another target (the
+ *    Orin switched plates or robots) and starts a new track,
+ *  - the target is valid from the first measurement until the Orin reports no target or no
+ *    measurement came for AIM_TRACKER_TIMEOUT.
+ * Comment out to slew to the last offset until the next one arrives.
+ */
+#define AIM_TRACKER_ENABLED
+
+#define AIM_TRACKER_ACCELERATION_NOISE (8.0f) // (rad/s^2)^2 s, spectral density of the target acceleration
+#define AIM_TRACKER_MEASUREMENT_NOISE (0.003f) // rad, one sigma of a camera measurement
+#define AIM_TRACKER_INITIAL_RATE (1.0f)       // rad/s, one sigma of the rate of a new target
+#define AIM_TRACKER_GATE (0.1f)               // rad off the prediction, on either axis
+#define AIM_TRACKER_TIMEOUT (100)             // ms after the last capture before the target is dropped
+
+typedef struct
+{
+    float angle;   // rad at the last measurement
+    float rate;    // rad/s
+    float p[2][2]; // covariance of (angle, rate)
+} Aim_Tracker_Axis_t;
+
+typedef struct
+{
+    Aim_Tracker_Axis_t yaw; // world frame, the IMU's
+    Aim_Tracker_Axis_t pitch;
+    uint32_t tick; // ms, capture tick of the last measurement
+    uint8_t target_valid;
+    uint32_t measurements;
+    uint32_t targets;  // tracks started, switches included
+    uint32_t timeouts; // tracks dropped for lack of measurements
+} Aim_Tracker_t;
+
+void Aim_Tracker_Measure(uint32_t tick, float yaw, float pitch);
+void Aim_Tracker_Drop(void);
+uint8_t Aim_Tracker_Predict(uint32_t tick, float *yaw, float *pitch);
+
+extern Aim_Tracker_t g_aim_tracker;
+
+#endif // AIM_TRACKER_H
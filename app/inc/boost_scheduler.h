@@ -0,0 +1,61 @@
+#ifndef BOOST_SCHEDULER_H
+#define BOOST_SCHEDULER_H
+
+#include <stdint.h>
+
+/*
+ * Speed boost on the supercap's stored energy, updated by the chassis task before the command
+ * is scaled:
+ *  - the stored energy is g_supercap.supercap_percent of BOOST_SUPERCAP_ENERGY,
+ *  - while the driver asks for it (IS_SUPER_CAPACITOR_ENABLED, Shift or the dial wheel held
+ *    back with the flywheels off) the cap output is enabled and the SWERVE_MAX_SPEED and
+ *    SPIN_TOP_OMEGA envelope is raised, fully down to BOOST_FULL_PERCENT, then tapering to none
+ *    at BOOST_EMPTY_PERCENT. The cap output comes back once it is charged to BOOST_REARM_PERCENT,
+ *  - the envelope moves at most BOOST_SCALE_RATE per second, so a drained cap slows the robot
+ *    down instead of cutting its speed,
+ *  - the power limiter may spend the power the cap can supply on top of the referee limit,
+ *    BOOST_CAP_POWER tapering the same way, the referee only sees what the cap board draws,
+ *  - the energy is accounted per match (an enabled stretch), the debug task logs the totals
+ *    once the robot is disabled.
+ * Comment out to keep the envelope at SWERVE_MAX_SPEED and SPIN_TOP_OMEGA with the cap off.
+ */
+#define BOOST_SCHEDULER_ENABLED
+
+#define BOOST_SUPERCAP_ENERGY (1300.0f) // J at 100 %, 6 F between 12 V and 24 V
+#define BOOST_FULL_PERCENT (40.0f)      // full boost at and above
+#define BOOST_EMPTY_PERCENT (10.0f)     // no boost at and below, the cap output is turned off
+#define BOOST_REARM_PERCENT (20.0f)     // cap output allowed again after running empty
+#define BOOST_MAX_SPEED_SCALE (1.6f)    // on SWERVE_MAX_SPEED
+#define BOOST_MAX_OMEGA_SCALE (1.5f)    // on SPIN_TOP_OMEGA
+#define BOOST_SCALE_RATE (1.0f)         // per second
+#define BOOST_CAP_POWER (150.0f)        // W the cap board supplies on top of the referee limit
+#define BOOST_ACCOUNT_STEP (2.0f)       // % the reading moves before it is accounted
+
+typedef struct
+{
+    uint32_t duration_ms;
+    uint32_t boost_ms;       // with the full envelope
+    uint32_t taper_ms;       // with part of it, the cap running low or the envelope moving
+    uint32_t empty_ms;       // boost asked for with the cap output off
+    float spent_translation; // J out of the cap while translating
+    float spent_spintop;     // J out of the cap while spinning
+    float recharged;         // J back into the cap
+    float min_percent;
+} Boost_Match_t;
+
+typedef struct
+{
+    float speed_scale; // on SWERVE_MAX_SPEED
+    float omega_scale; // on SPIN_TOP_OMEGA
+    float cap_power;   // W the power limiter may take from the cap
+    float percent;     // last accounted supercap reading
+    uint8_t cap_armed; // 0 from running empty until recharged to BOOST_REARM_PERCENT
+    uint32_t matches;
+    Boost_Match_t match; // the current match, or the last one while disabled
+} Boost_Scheduler_t;
+
+void Boost_Scheduler_Update(uint32_t period_ms);
+
+extern Boost_Scheduler_t g_boost_scheduler;
+
+#endif // BOOST_SCHEDULER_H
@@ -0,0 +1,40 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+
+/*
+ * Staged start up with a trace. Robot_Init marks the power on reference with Boot_Begin,
+ * the command task runs the stage table with Boot_Run and only leaves STARTING_UP once
+ * every stage is done. Each stage records when it started and how long it took, relative
+ * to Boot_Begin, so the debug report shows where power cycle to drivable time goes.
+ */
+#define BOOT_MAX_STAGES (16)
+
+typedef struct
+{
+    const char *name;
+    void (*init)(void);
+} Boot_Stage_t;
+
+typedef struct
+{
+    const char *name;
+    uint32_t start_us;    // since Boot_Begin
+    uint32_t duration_us;
+} Boot_Trace_t;
+
+typedef struct
+{
+    Boot_Trace_t stages[BOOT_MAX_STAGES];
+    uint8_t stage_count;
+    uint32_t ready_us; // Boot_Run returning, 0 while still booting
+} Boot_Report_t;
+
+void Boot_Begin(void);
+void Boot_Mark(const char *name);
+void Boot_Run(const Boot_Stage_t *stages, uint8_t stage_count);
+
+extern Boot_Report_t g_boot_report;
+
+#endif // BOOT_H
@@ -0,0 +1,60 @@
+#ifndef CAN_TX_SCHEDULER_H
+#define CAN_TX_SCHEDULER_H
+
+#include <stdint.h>
+#include "dji_motor.h"
+
+/*
+ * Transmit scheduler in front of CAN_Transmit (linked with -Wl,--wrap=CAN_Transmit,...).
+ * Frames the motor task queues between CAN_TX_Scheduler_Begin and CAN_TX_Scheduler_Flush
+ * are staged per bus and identifier block (0x200, 0x1FF, ...) instead of going straight
+ * to a mailbox. On flush, frames whose payload did not change are only refreshed every
+ * CAN_TX_REFRESH_PERIOD ms (CAN_TX_IDLE_PERIOD ms when all zero, i.e. motors disabled), with
+ * the refresh of CAN2 offset by half a period from CAN1 and the blocks of a bus staggered.
+ * CAN2 carries the chassis, seven ESCs whose 1 kHz feedback alone takes about 80 % of it, so
+ * its blocks take turns: each goes out at most every CAN_TX_CAN2_PERIOD ms, the chassis group
+ * period, one block per ms. Priority blocks (the gimbal) are submitted first. Frames that find
+ * no free mailbox stay staged for their next turn.
+ * Comment out to send every frame as it is queued; bus load is accounted either way.
+ */
+#define CAN_TX_SCHEDULER_ENABLED
+
+#define CAN_TX_BUS_COUNT (2)
+#define CAN_TX_MAX_SLOTS (8)            // staged identifiers per bus
+#define CAN_TX_REFRESH_PERIOD (4)       // ms, resend an unchanged frame at least this often
+#define CAN_TX_IDLE_PERIOD (20)         // ms, resend an all zero frame at least this often
+#define CAN_TX_CAN2_PERIOD (2)          // ms between frames of one block on CAN2, divides the two above
+#define CAN_TX_BITRATE (1000000U)       // bit/s, both buses
+#define CAN_TX_LOAD_WINDOW (1000)       // ms over which utilization is computed
+#define CAN_TX_MAILBOXES (3)
+
+typedef struct
+{
+    uint32_t frames_sent;
+    uint32_t frames_skipped;      // frames not sent this period: unchanged, or not their turn on CAN2
+    uint32_t frames_rx;           // estimated, registered DJI feedback at 1 kHz
+    uint32_t mailbox_full;        // submissions deferred because all mailboxes were busy
+    uint32_t frames_dropped;      // staged frames overwritten before a mailbox was free
+    uint32_t tx_errors;           // CAN_Transmit returned an error
+    uint32_t window_bits;         // TX bits (without stuff bits) in the current window
+    uint8_t feedback_devices;     // registered devices broadcasting DJI feedback
+    float load_percent;           // TX + RX utilization over the last complete window
+    float peak_load_percent;
+} CAN_TX_Bus_Stats_t;
+
+typedef struct
+{
+    CAN_TX_Bus_Stats_t bus[CAN_TX_BUS_COUNT];
+    uint32_t flushes;
+    uint32_t max_priority_latency; // cycles from flush start to the last priority frame submitted
+} CAN_TX_Stats_t;
+
+void CAN_TX_Scheduler_Init(void);
+void CAN_TX_Scheduler_Prioritize_Motor(DJI_Motor_Handle_t *motor_handle);
+void CAN_TX_Scheduler_Begin(void);
+uint8_t *CAN_TX_Scheduler_Staged_Motor_Data(const DJI_Motor_Handle_t *motor_handle);
+void CAN_TX_Scheduler_Flush(void);
+
+extern CAN_TX_Stats_t g_can_tx_stats;
+
+#endif // CAN_TX_SCHEDULER_H
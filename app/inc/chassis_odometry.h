@@ -0,0 +1,58 @@
+#ifndef CHASSIS_ODOMETRY_H
+#define CHASSIS_ODOMETRY_H
+
+#include <stdint.h>
+#include "snapshot.h"
+#include "swerve_locomotion.h"
+
+/*
+ * Wheel odometry, updated by the chassis group every cycle, enabled or not:
+ *  - each module's velocity over the floor is its drive speed along its measured azimuth,
+ *  - the chassis velocity is the least squares fit of all four, [v_x v_y omega]' = K+ m with
+ *    K the 8x3 inverse kinematics matrix and K+ = (K'K)^-1 K' computed once at init,
+ *  - heading is the IMU's less the yaw motor's angle, the IMU sits on the gimbal, and the
+ *    pose integrates the translation along the heading half way through the cycle,
+ *  - the gyro's yaw rate less the yaw motor's checks the fitted one, it is only as fine as
+ *    the motor's whole rpm (0.1 rad/s). The wheels slip when the two are more than
+ *    CHASSIS_ODOMETRY_SLIP_OMEGA apart, the gyro's then replaces the fitted one and the
+ *    translation is refit with it, or when a module is more than CHASSIS_ODOMETRY_SLIP_SPEED
+ *    off the fit. Wheels slipping together, or sliding sideways, still fit and go unnoticed.
+ * Published in g_chassis_odometry_snapshot. Comment out to leave the chassis unobserved.
+ */
+#define CHASSIS_ODOMETRY_ENABLED
+
+#define CHASSIS_ODOMETRY_SLIP_OMEGA (0.2f) // rad/s between the fitted and the gyro's yaw rate
+#define CHASSIS_ODOMETRY_SLIP_SPEED (0.05f) // m/s between a module and the fit
+
+#define CHASSIS_ODOMETRY_NO_MODULE (0xFF)
+
+typedef struct
+{
+    float v_x;     // m/s, chassis frame
+    float v_y;     // m/s
+    float omega;   // rad/s, fitted, the gyro's while the wheels slip
+    float x;       // m, world frame, the chassis frame at start up
+    float y;       // m
+    float heading; // rad, chassis in the world frame
+    uint8_t slip;  // the wheels slipped this cycle
+} Chassis_Odometry_State_t;
+
+typedef struct
+{
+    Chassis_Odometry_State_t state;
+    float fit_omega;          // rad/s, the wheels' yaw rate
+    float gyro_omega;         // rad/s, the gyro's less the yaw motor's
+    float max_module_error;   // m/s, the module furthest off the refit
+    uint8_t slip_module;      // furthest off the fit while slipping, CHASSIS_ODOMETRY_NO_MODULE if not
+    uint32_t slip_cycles;
+    uint32_t module_slips[NUMBER_OF_MODULES]; // slipping cycles each module was furthest off
+    float distance;           // m travelled
+} Chassis_Odometry_t;
+
+void Chassis_Odometry_Init(void);
+void Chassis_Odometry_Update(float dt);
+
+extern Chassis_Odometry_t g_chassis_odometry;
+extern Snapshot_t g_chassis_odometry_snapshot; // Chassis_Odometry_State_t for other tasks
+
+#endif // CHASSIS_ODOMETRY_H
@@ -0,0 +1,38 @@
+#ifndef CHASSIS_SETPOINT_H
+#define CHASSIS_SETPOINT_H
+
+#include <stdint.h>
+#include "swerve_locomotion.h"
+
+/*
+ * Setpoint generator between the chassis command and the module kinematics. Each chassis
+ * cycle the setpoint moves towards the command:
+ *  - translation changes as a 2D vector limited to CHASSIS_MAX_ACCEL, so a diagonal change
+ *    takes as long as a straight one and the direction of the change is kept,
+ *  - rotation changes at most CHASSIS_MAX_ANGULAR_ACCEL,
+ *  - the step is then shortened until no module has to steer faster than
+ *    CHASSIS_AZIMUTH_MAX_RATE to follow it (modules slower than CHASSIS_SETPOINT_MIN_SPEED
+ *    are free to point anywhere, a reversal is a flip and needs no steering).
+ * Comment out to pass the command straight to the kinematics.
+ */
+#define CHASSIS_SETPOINT_ENABLED
+
+#define CHASSIS_MAX_ACCEL (5.0f)           // m/s^2, below the tire friction limit
+#define CHASSIS_MAX_ANGULAR_ACCEL (20.0f)  // rad/s^2
+#define CHASSIS_AZIMUTH_MAX_RATE (20.0f)   // rad/s, GM6020 under load, no-load is 33 rad/s
+#define CHASSIS_SETPOINT_MIN_SPEED (0.05f) // m/s
+#define CHASSIS_SETPOINT_ITERATIONS (6)    // bisection steps for the steering limited step
+
+typedef struct
+{
+    swerve_chassis_state_t setpoint; // v_x, v_y, omega the kinematics get
+    float step_scale;                // fraction of the accel limited step taken last cycle
+    uint32_t steering_limited_cycles;
+    uint32_t resets;
+} Chassis_Setpoint_t;
+
+void Chassis_Setpoint_Update(swerve_chassis_state_t *chassis_state, float dt);
+
+extern Chassis_Setpoint_t g_chassis_setpoint;
+
+#endif // CHASSIS_SETPOINT_H
@@ -1,6 +1,9 @@
 #ifndef CHASSIS_TASK_H
 #define CHASSIS_TASK_H
 
+#include <stdint.h>
+#include "swerve_locomotion.h"
+
 // PHYSICAL CONSTANTS
 #define SWERVE_MAX_SPEED 1.0f          // m/s
 #define SPIN_TOP_OMEGA 2.0f            // m/s
@@ -8,10 +11,53 @@
 #define TRACK_WIDTH 0.34f              // m, measured wheel to wheel (side to side)
 #define WHEEL_BASE 0.34f               // m, measured wheel to wheel (up and down)
 #define WHEEL_DIAMETER 0.12f           // m, measured wheel diameter
+#define CHASSIS_MAX_WHEEL_SPEED 2.9f   // m/s, M3508 rated 469 rpm at the gearbox output
+
+/*
+ * Module optimization after the kinematics, on top of swerve_optimize_module_angles:
+ *  - a module commanded slower than CHASSIS_MODULE_HOLD_SPEED keeps its last azimuth instead
+ *    of snapping to the heading the kinematics give for (almost) no motion,
+ *  - each drive speed is scaled by the cosine of its module's azimuth error, so a module that
+ *    is still steering only drives the component along its heading (none past 90 degrees),
+ *  - the module states are only solved again when the chassis command changed.
+ * Comment out to pass the solved states to swerve_optimize_module_angles alone.
+ */
+#define CHASSIS_MODULE_OPTIMIZATION_ENABLED
+#define CHASSIS_MODULE_HOLD_SPEED 0.05f // m/s
+
+// Uncomment to time both kinematics paths once at init (results in g_kinematics_benchmark)
+// #define CHASSIS_KINEMATICS_BENCHMARK
+
+typedef struct
+{
+    uint32_t scalar_cycles; // swerve_calculate_kinematics, per call
+    uint32_t matrix_cycles; // Chassis_Solve_Module_States, per call
+} Kinematics_Benchmark_t;
+
+typedef struct
+{
+    float translation_scale; // last cycle, 1 when the command fits
+    float rotation_scale;
+    uint32_t saturated_cycles;
+} Chassis_Desaturation_t;
+
+typedef struct
+{
+    uint32_t held_modules;   // module cycles that kept their last azimuth
+    uint32_t skipped_solves; // cycles that reused the module states of the last command
+} Chassis_Module_Stats_t;
 
 // Function prototypes
 void Chassis_Task_Init(void);
 void Chassis_Ctrl_Loop(void);
-float Rescale_Chassis_Velocity(void);
+void Chassis_Solve_Module_States(swerve_chassis_state_t *chassis_state);
+void Chassis_Module_Velocity(const swerve_chassis_state_t *chassis_state, int module, float *v_x, float *v_y);
+void Chassis_Desaturate(swerve_chassis_state_t *chassis_state);
+#ifdef CHASSIS_MODULE_OPTIMIZATION_ENABLED
+void Chassis_Optimize_Module_States(swerve_chassis_state_t *chassis_state, float measured_angles[]);
+#endif
+
+extern Chassis_Desaturation_t g_chassis_desaturation;
+extern Chassis_Module_Stats_t g_chassis_module_stats;
 
 #endif // CHASSIS_TASK_H
@@ -0,0 +1,16 @@
+#ifndef COBS_FRAME_H
+#define COBS_FRAME_H
+
+#include <stdint.h>
+
+/*
+ * Framing shared by the telemetry stream and the Orin link: COBS encoded so the only zero byte
+ * on the wire is the frame delimiter, CRC-16/CCITT-FALSE over the decoded frame.
+ */
+#define COBS_FRAME_ENCODED_SIZE(raw_size) ((raw_size) + (raw_size) / 254 + 2) // incl. delimiter
+
+uint16_t COBS_Frame_CRC16(const uint8_t *data, uint16_t length);
+uint16_t COBS_Frame_Encode(const uint8_t *src, uint16_t length, uint8_t *dst);
+uint16_t COBS_Frame_Decode(const uint8_t *src, uint16_t length, uint8_t *dst);
+
+#endif // COBS_FRAME_H
@@ -0,0 +1,49 @@
+#ifndef CONTROL_SYNC_H
+#define CONTROL_SYNC_H
+
+#include <stdint.h>
+#include "dji_motor.h"
+
+/*
+ * Uncomment to run the rate groups and motor task off motor feedback instead of their own
+ * vTaskDelayUntil periods: CAN RX of the registered feedback frames releases the rate groups
+ * that are due (see rate_group.c), the gimbal group then notifies the motor task to transmit.
+ */
+// #define EVENT_DRIVEN_CONTROL
+
+#define CONTROL_SYNC_MAX_MOTORS (16)
+#define CONTROL_SYNC_MOTOR_TIMEOUT_MS (2) // fall back to free running if feedback stops (e.g. motors unpowered)
+
+/*
+ * A feedback set completes once every expected motor has reported, or, when one has not, at the
+ * next frame of a motor already in the set, a feedback period after the set started. Motors
+ * missing from CONTROL_SYNC_MISSING_SETS sets in a row are no longer expected, so one dead or
+ * unplugged motor costs a few late sets instead of leaving every group on its timeout. A motor
+ * is expected again from its next frame.
+ */
+#define CONTROL_SYNC_MISSING_SETS (3)
+
+typedef struct
+{
+    uint32_t feedback_sets;     // completed feedback sets (every expected motor reported, or closed late)
+    uint32_t incomplete_sets;   // closed a feedback period late with expected motors missing
+    uint32_t missed_frames;     // expected motors missing from closed sets
+    uint32_t missing_mask;      // registered motors no longer expected, by registration order
+    uint32_t transmits;         // transmits with a latency sample
+    uint32_t motor_timeouts;    // motor task woke without a command/feedback trigger
+    uint32_t last_latency;      // cycles from last feedback set to DJI_Motor_Send completing
+    uint32_t min_latency;
+    uint32_t max_latency;
+    uint64_t total_latency;
+} Control_Sync_Stats_t;
+
+void Control_Sync_Init(void);
+void Control_Sync_Register_Feedback(DJI_Motor_Handle_t *motor_handle);
+void Control_Sync_Command_Done(void);
+void Control_Sync_Wait_For_Command(void);
+void Control_Sync_Transmit_Done(void);
+float Control_Sync_Get_Average_Latency_Us(void);
+
+extern Control_Sync_Stats_t g_control_sync_stats;
+
+#endif // CONTROL_SYNC_H
@@ -0,0 +1,44 @@
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <stdint.h>
+
+/*
+ * Free running cycle counter for profiling.
+ * On the board this is the DWT cycle counter (SystemCoreClock ticks),
+ * in the SIL build it is the host monotonic clock in nanoseconds.
+ */
+#ifdef SIL_BUILD
+#include <time.h>
+
+#define CYCLE_COUNTER_HZ (1000000000U)
+
+static inline void Cycle_Counter_Init(void)
+{
+}
+
+static inline uint32_t Cycle_Counter_Get(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#else
+#include "main.h"
+
+#define CYCLE_COUNTER_HZ (SystemCoreClock)
+
+static inline void Cycle_Counter_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t Cycle_Counter_Get(void)
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+#endif // CYCLE_COUNTER_H
@@ -0,0 +1,38 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+/*
+ * Single-precision math for the control loops. The M4F FPU only handles float, so anything
+ * that ends up in double (libm sin/cos/fmod, double literals, a double PI) is emulated in
+ * software. app/ is built with -Wdouble-promotion to keep it that way.
+ */
+
+#define PI_F (3.14159265358979f)
+#define HALF_PI_F (1.57079632679490f)
+#define TWO_PI_F (6.28318530717959f)
+#define DEG_TO_RAD_F (PI_F / 180.0f)
+
+/**
+ * @brief Single-precision atan2 using a minimax polynomial, max error ~2e-6 rad
+ * (well below one GM6020 encoder tick). Returns 0 for (0, 0).
+ */
+float Fast_Atan2f(float y, float x);
+
+/**
+ * @brief Table based sine and cosine of the same angle (CMSIS-DSP arm_sin_f32/arm_cos_f32,
+ * 512 entry table with linear interpolation), angle in rad.
+ */
+void Fast_Sin_Cos(float angle, float *sin_out, float *cos_out);
+
+/**
+ * @brief Remainder of angle / 2pi with the sign of angle, same result as fmod(angle, 2 * PI)
+ * without the double-precision call.
+ */
+float Wrap_Angle(float angle);
+
+/**
+ * @brief to - from folded into [-pi, pi], the short way round.
+ */
+float Angle_Difference(float to, float from);
+
+#endif // FAST_MATH_H
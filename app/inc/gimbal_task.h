@@ -1,9 +1,50 @@
 #ifndef GIMBAL_TASK_H
 #define GIMBAL_TASK_H
 
+#include "input_snapshot.h"
+
 #define YAW_MID_POSITION
 #define PITCH_MID_POSITION
 
+/*
+ * Yaw feedforward for the chassis turning under the gimbal. The yaw motor turns relative to the
+ * chassis, so holding a world yaw while the chassis spins at omega means running the GM6020 at
+ * -omega against its own back-EMF, which the velocity loop only learns of through the IMU once
+ * the gimbal has been dragged along. After DJI_Motor_Send the motor task adds the back-EMF
+ * voltage for the chassis rate to the yaw command the velocity loop staged (so it needs
+ * CAN_TX_SCHEDULER_ENABLED). The chassis rate is the setpoint the chassis follows, or with
+ * GIMBAL_YAW_FEEDFORWARD_MEASURED the IMU yaw rate minus the yaw motor's rate on the chassis,
+ * which follows wheel slip but carries the encoder's rpm steps.
+ * Comment out to leave the chassis rotation to the yaw feedback loops.
+ */
+#define GIMBAL_YAW_FEEDFORWARD_ENABLED
+// #define GIMBAL_YAW_FEEDFORWARD_MEASURED
+#define GIMBAL_YAW_FEEDFORWARD_GAIN (895.0f) // per rad/s, GM6020 back-EMF 0.716 V per rad/s, 30000 per 24 V
+
+/*
+ * Auto aim against the attitude at capture time. The Orin's aim offset is relative to the gimbal
+ * attitude when the camera frame was taken, AIM_CAPTURE_LATENCY before it arrives, and the
+ * gimbal has moved on since (fast during spintop). The gimbal group keeps the attitude history
+ * (imu_history.h) and the offset is added to the attitude looked up at the capture tick, falling
+ * back to the current one outside the history.
+ * Comment out to add the offset to the current attitude.
+ */
+#define AIM_LATENCY_COMPENSATION_ENABLED
+
+typedef struct
+{
+    float chassis_omega; // rad/s the feedforward compensated last cycle
+    float command;       // added to the staged yaw command
+} Gimbal_Yaw_Feedforward_t;
+
+// Operator's gimbal rates, set by the command group every cycle (zero while disabled). The gimbal
+// group integrates them and is the only writer of g_robot_state.gimbal
+typedef struct
+{
+    float yaw_rate;   // rad/s, sticks and mouse
+    float pitch_rate; // rad/s
+} Gimbal_Command_t;
+
 typedef struct
 {
     float pitch;
@@ -14,5 +55,12 @@ typedef struct
 // Function prototypes
 void Gimbal_Task_Init(void);
 void Gimbal_Ctrl_Loop(void);
+void Gimbal_Set_Command(const Gimbal_Command_t *command);
+#ifdef GIMBAL_YAW_FEEDFORWARD_ENABLED
+void Gimbal_Yaw_Feedforward_Apply(void);
+#endif
+
+extern Input_Snapshot_t g_gimbal_inputs;
+extern Gimbal_Yaw_Feedforward_t g_gimbal_yaw_feedforward;
 
 #endif // GIMBAL_TASK_H
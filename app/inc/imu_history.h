@@ -0,0 +1,31 @@
+#ifndef IMU_HISTORY_H
+#define IMU_HISTORY_H
+
+#include <stdint.h>
+
+/*
+ * Timestamped gimbal attitude, one sample per gimbal cycle, so that a measurement taken in the
+ * past (an aim offset computed from a camera frame) can be applied against the attitude the
+ * gimbal had at the time. Pushed and looked up by the gimbal group only, no locking.
+ */
+#define IMU_HISTORY_LENGTH (128) // samples, a power of two, 128 ms at the gimbal rate
+
+typedef struct
+{
+    uint32_t tick; // ms
+    float yaw;     // rad
+    float pitch;   // rad
+} IMU_History_Sample_t;
+
+typedef struct
+{
+    uint32_t lookups;
+    uint32_t misses; // tick newer than the last sample or older than the history
+} IMU_History_Stats_t;
+
+void IMU_History_Push(uint32_t tick, float yaw, float pitch);
+uint8_t IMU_History_Lookup(uint32_t tick, float *yaw, float *pitch);
+
+extern IMU_History_Stats_t g_imu_history_stats;
+
+#endif // IMU_HISTORY_H
@@ -0,0 +1,46 @@
+#ifndef INPUT_SNAPSHOT_H
+#define INPUT_SNAPSHOT_H
+
+#include <stdint.h>
+#include "remote.h"
+#include "snapshot.h"
+
+typedef struct
+{
+    float yaw;
+    float pitch;
+    float roll;
+    float gyro[3]; // rad/s, bmi088 body frame
+} IMU_Attitude_t;
+
+// ms from the camera exposure to the aim offset arriving, assumed by the Jetson_Orin driver path,
+// the Orin link (ORIN_LINK_ENABLED) carries the exposure time in the aim frame
+#define AIM_CAPTURE_LATENCY (30)
+
+typedef struct
+{
+    float yaw;             // deg, relative to the gimbal attitude at capture_tick
+    float pitch;           // deg
+    uint32_t capture_tick; // ms, exposure of the frame the offset was computed from
+    uint32_t sequence;     // counts the offsets received, a new one when it changes
+    uint8_t target_valid;  // 0 when the Orin sees no target, the offset is meaningless then
+} Aim_Command_t;
+
+// One coherent copy of every shared input, taken once per rate group cycle
+typedef struct
+{
+    IMU_Attitude_t imu;
+    Remote_t remote;
+    Aim_Command_t aim;
+    uint32_t sample_retries; // torn copies detected and retried while sampling
+} Input_Snapshot_t;
+
+void Input_Snapshot_Update(Input_Snapshot_t *inputs);
+void Input_Snapshot_Take(Input_Snapshot_t *inputs);
+
+extern Input_Snapshot_t g_inputs;   // command group view, refreshed by Input_Snapshot_Take
+extern Snapshot_t g_imu_snapshot;    // IMU_Attitude_t for other tasks
+extern Snapshot_t g_remote_snapshot; // Remote_t for other tasks
+extern Snapshot_t g_aim_snapshot;    // Aim_Command_t for other tasks
+
+#endif // INPUT_SNAPSHOT_H
@@ -2,13 +2,50 @@
 #define LAUNCH_TASK_H
 
 #include "dji_motor.h"
+#include "fast_math.h"
 
 #define NUM_SHOTS 8
-#define SHOT_ANGLE_OFFSET_RAD (2 * PI / NUM_SHOTS)
-#define FEED_TOLERANCE (5 * PI / 180) // 5 degree tolerance 
+#define SHOT_ANGLE_OFFSET_RAD (TWO_PI_F / NUM_SHOTS)
+#define FEED_TOLERANCE (5.0f * DEG_TO_RAD_F) // 5 degree tolerance
 #define FEED_RATE  60 / 8 * 60 // rpm
 #define FREQUENCY 8 * (FEED_RATE / DJI_MAX_TICKS) * M2006_REDUCTION_RATIO
 
+/*
+ * Feeder jam detection, in place of a rejiggle after every shot:
+ *  - the feeder is stalled while it is commanded to move (more than FEED_TOLERANCE from its
+ *    shot target, or a full auto feed rate) yet turns slower than FEED_JAM_SPEED with more than
+ *    FEED_JAM_CURRENT through the M2006. Accelerating or arriving the current is up but the
+ *    speed is not down, so it only counts once it lasts FEED_JAM_TIME,
+ *  - a stall backs the feeder off FEED_JAM_REVERSE_RAD, then retries: the same shot target in
+ *    single fire, the feed rate in full auto. The reverse ends at its angle or after
+ *    FEED_JAM_REVERSE_TIME, whichever is first, it may be wedged as well,
+ *  - a shot still jammed after FEED_JAM_MAX_RETRIES is given up, the feeder holds where it is
+ *    and does not fire again until fire_mode has gone through NO_FIRE.
+ * Shots and their cycle time (command to the next pocket, retries included) are counted in
+ * g_feed_stats either way. Comment out to rejiggle after every shot.
+ */
+#define FEED_JAM_DETECTION_ENABLED
+
+#define FEED_JAM_CURRENT (6000)                          // M2006 current_torq, of M2006_MAX_CURRENT
+#define FEED_JAM_SPEED (20.0f)                           // rpm at the output
+#define FEED_JAM_TIME (60)                               // ms stalled
+#define FEED_JAM_REVERSE_RAD (SHOT_ANGLE_OFFSET_RAD / 2) // half a pocket
+#define FEED_JAM_REVERSE_TIME (100)                      // ms
+#define FEED_JAM_MAX_RETRIES (3)                         // per shot
+
+typedef struct
+{
+    uint32_t shots;             // pockets fed, single fire or full auto
+    uint32_t jams;              // stalls detected
+    uint32_t retries;           // reverses that went on to retry
+    uint32_t abandoned;         // shots given up after FEED_JAM_MAX_RETRIES
+    uint32_t last_cycle_ms;     // last shot, command to pocket
+    uint32_t total_cycle_ms;
+    float average_cycle_ms;
+} Feed_Stats_t;
+
+extern Feed_Stats_t g_feed_stats;
+
 void Launch_Task_Init(void);
 void Launch_Ctrl_Loop(void);
 void handleSingleFire(void);
@@ -21,4 +58,9 @@ void handleFullAuto(void);
  */
 void rejiggle(void);
 
+/**
+ * @brief Back off a jam, then retry the shot or the feed rate
+ */
+void clearJam(void);
+
 #endif // LAUNCH_TASK_H
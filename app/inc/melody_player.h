@@ -0,0 +1,19 @@
+#ifndef MELODY_PLAYER_H
+#define MELODY_PLAYER_H
+
+#include <stdint.h>
+#include "buzzer.h"
+
+/*
+ * Plays a Melody_t in the background from a one shot FreeRTOS software timer that
+ * retunes the buzzer PWM (TIM4 CH3 on the type C board) at every note boundary,
+ * in place of the blocking Buzzer_Play_Melody. Needs configUSE_TIMERS.
+ */
+#define MELODY_PLAYER_TIMER (htim4)
+#define MELODY_PLAYER_CHANNEL (TIM_CHANNEL_3)
+
+void Melody_Player_Init(void);
+void Melody_Player_Start(Melody_t melody);
+uint8_t Melody_Player_Is_Playing(void);
+
+#endif // MELODY_PLAYER_H
@@ -0,0 +1,156 @@
+#ifndef ORIN_LINK_H
+#define ORIN_LINK_H
+
+#include <stdint.h>
+#include "telemetry.h"
+
+/*
+ * Framed link to the Jetson Orin on huart6, in place of the control library's Jetson_Orin
+ * driver, which has no framing, sequence numbers or statistics:
+ *  - frames are the telemetry stream's (COBS, zero delimited, u8 type | u16 sequence |
+ *    u32 tick | body | u16 CRC-16/CCITT-FALSE, see telemetry_decode.py). The MCU to Orin
+ *    direction is the telemetry stream itself: the link's frames are put on it with
+ *    Telemetry_Send and go out by UART DMA straight from the ring they are encoded into, and
+ *    the Orin gets the telemetry samples as well,
+ *  - the Orin to MCU direction is received by circular DMA into a buffer the link task parses
+ *    up to the DMA position every ORIN_LINK_PERIOD, decoding each frame where it landed (one
+ *    straddling the end of the buffer is copied once),
+ *  - each direction counts frames, bytes and losses, the receive side sequence gaps, CRC and
+ *    framing errors,
+ *  - the aim frame carries the Orin's time from exposure to transmission and an explicit
+ *    target flag, so the capture tick is known instead of assumed (AIM_CAPTURE_LATENCY), and
+ *    its arrival tick says how stale it is,
+ *  - the MCU keeps the Orin's clock with a two-way exchange every ORIN_LINK_SYNC_PERIOD, PTP
+ *    style: request sent at t1 (MCU), received and answered at t2 and t3 (Orin), answer
+ *    parsed at t4 (MCU), so offset = ((t2 - t1) + (t3 - t4)) / 2 whatever the link delay, as
+ *    long as it is the same both ways. A request waits behind the telemetry ring, so t1 is
+ *    when its last byte left the line (Telemetry_Send_Timed), not when it was made, and the
+ *    answer's time on the line comes off t4. An answer is only known to have arrived within
+ *    the last link period, t4 is its middle and the round trip is taken to its end, so
+ *    exchanges whose round trip is more than ORIN_LINK_SYNC_ROUND_TRIP_MARGIN over the
+ *    shortest seen are dropped. An alpha-beta filter over the rest estimates offset and drift,
+ *  - state frames stream the attitude, gyro rates and chassis velocity (odometry with
+ *    CHASSIS_ODOMETRY_ENABLED, else the command) every ORIN_LINK_STATE_PERIOD (up to 1 kHz)
+ *    as 16 bit fixed point, stamped with the Orin's clock when they are read (at most a
+ *    gimbal period after the IMU sample), so the Orin interpolates them at its exposure time.
+ * huart6 runs at TELEMETRY_BAUD_RATE (921600, about 92 kB/s), the Orin's end must match. State
+ * frames at 1 kHz and sync requests take about 34 kB/s of it, kept for the link by
+ * TELEMETRY_SEND_BYTE_RATE, and the telemetry samples are decimated to fit the rest.
+ * Needs TELEMETRY_ENABLED. Comment out to use Jetson_Orin_Send_Data and g_orin_data.
+ */
+#define ORIN_LINK_ENABLED
+
+#define ORIN_LINK_PERIOD (1)             // ms, link task period, the receive side is parsed this often
+#define ORIN_LINK_STATE_PERIOD (1)       // ms between state frames to the Orin, 34 bytes each on the wire
+#define ORIN_LINK_RX_BUFFER_SIZE (512)   // bytes, power of two, more than a link period of bytes
+#define ORIN_LINK_MAX_FRAME_SIZE (64)    // bytes decoded, longer frames are dropped
+#define ORIN_LINK_AIM_TARGET_VALID (0x01) // Orin_Link_Aim_Frame_t flags
+#define ORIN_LINK_STATE_SYNCED (0x01)     // Orin_Link_State_Frame_t flags, time_us is the Orin's clock, else the MCU's
+
+#define ORIN_LINK_SYNC_PERIOD (100)             // ms between sync requests
+#define ORIN_LINK_SYNC_ROUND_TRIP_MARGIN (1000) // us over the shortest round trip an exchange may take, a link period
+#define ORIN_LINK_SYNC_ROUND_TRIP_AGING (20)    // us the shortest round trip grows per exchange, follows a slower link
+#define ORIN_LINK_SYNC_ALPHA (0.1f)             // offset gain, once the start up fit is past it
+#define ORIN_LINK_SYNC_BETA (0.005f)            // drift gain
+#define ORIN_LINK_SYNC_STEP (10000)             // us off the estimate that means the Orin's clock was set, the filter restarts
+
+// state frame fixed point, saturated to int16
+#define ORIN_LINK_ANGLE_SCALE (10000.0f) // per rad
+#define ORIN_LINK_RATE_SCALE (1000.0f)   // per rad/s
+#define ORIN_LINK_SPEED_SCALE (1000.0f)  // per m/s
+
+#if defined(ORIN_LINK_ENABLED) && !defined(TELEMETRY_ENABLED)
+#error "ORIN_LINK_ENABLED sends on the telemetry stream, it needs TELEMETRY_ENABLED"
+#endif
+
+typedef enum
+{
+    ORIN_LINK_FRAME_STATE = 0x10,         // MCU to Orin, Orin_Link_State_Frame_t
+    ORIN_LINK_FRAME_AIM = 0x11,           // Orin to MCU, Orin_Link_Aim_Frame_t
+    ORIN_LINK_FRAME_SYNC_REQUEST = 0x12,  // MCU to Orin, Orin_Link_Sync_Request_Frame_t
+    ORIN_LINK_FRAME_SYNC_RESPONSE = 0x13, // Orin to MCU, Orin_Link_Sync_Response_Frame_t
+} Orin_Link_Frame_e;
+
+// frame bodies, little endian as laid out
+typedef struct __attribute__((packed))
+{
+    uint32_t time_us;     // low 32 bits of the Orin's clock when read, the Orin unwraps it against its own
+    int16_t attitude[3];  // yaw, pitch, roll, ORIN_LINK_ANGLE_SCALE
+    int16_t gyro[3];      // bmi088 body frame, ORIN_LINK_RATE_SCALE
+    int16_t velocity[3];  // chassis frame v_x, v_y (ORIN_LINK_SPEED_SCALE), omega (ORIN_LINK_RATE_SCALE)
+    uint8_t flags;        // ORIN_LINK_STATE_SYNCED
+} Orin_Link_State_Frame_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t t1; // us, MCU clock at the request, echoed back
+} Orin_Link_Sync_Request_Frame_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t t1; // us, from the request
+    uint64_t t2; // us, Orin clock when the request arrived
+    uint64_t t3; // us, Orin clock when this was sent
+} Orin_Link_Sync_Response_Frame_t;
+
+typedef struct __attribute__((packed))
+{
+    float yaw;       // deg, relative to the gimbal attitude at exposure
+    float pitch;     // deg
+    uint8_t flags;   // ORIN_LINK_AIM_TARGET_VALID
+    uint16_t age_ms; // exposure to transmission
+} Orin_Link_Aim_Frame_t;
+
+typedef struct
+{
+    float yaw;   // deg, relative to the gimbal attitude at capture_tick
+    float pitch; // deg
+    uint8_t target_valid;
+    uint32_t capture_tick; // ms
+    uint32_t arrival_tick; // ms
+    uint32_t sequence;     // aim frames received
+} Orin_Link_Aim_t;
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t bytes;     // on the wire, delimiters included
+    uint32_t dropped;   // tx: not taken by Telemetry_Send (the ring's drops are its dropped_sends), rx: CRC, COBS or length errors
+    uint32_t lost;      // rx: sequence numbers skipped, frames sent that never arrived
+    uint32_t byte_rate; // bytes/s over the last second
+} Orin_Link_Direction_Stats_t;
+
+typedef struct
+{
+    uint8_t synced;         // offset and drift are estimated
+    int64_t offset_us;      // Orin clock minus MCU clock at reference_us
+    uint64_t reference_us;  // MCU clock of the last accepted exchange
+    float drift;            // Orin clock rate minus the MCU's, us per us
+    float drift_ppm;        // the same, for telemetry
+    float residual_us;      // last accepted offset measurement minus the estimate
+    uint32_t round_trip_us; // last accepted exchange, less the Orin's turnaround, to the parse after the answer
+    uint32_t min_round_trip_us;
+    uint32_t exchanges; // answers received
+    uint32_t accepted;
+    uint32_t rejected;      // round trip too long or negative, the answer was not to the last request or it never left
+    uint32_t steps;         // restarts after an exchange ORIN_LINK_SYNC_STEP off the estimate
+} Orin_Link_Sync_t;
+
+typedef struct
+{
+    Orin_Link_Direction_Stats_t tx;
+    Orin_Link_Direction_Stats_t rx;
+    uint32_t rx_unknown;   // good frames of a type the MCU does not take
+    uint32_t last_rx_tick; // ms, last good frame
+    Orin_Link_Sync_t sync;
+} Orin_Link_Stats_t;
+
+void Orin_Link_Init(void);
+void Orin_Link_Task_Loop(void);
+void Orin_Link_Get_Aim(Orin_Link_Aim_t *aim);
+uint64_t Orin_Link_Time_Us(void);
+uint64_t Orin_Link_To_Orin_Time(uint64_t mcu_us);
+
+extern Orin_Link_Stats_t g_orin_link_stats;
+
+#endif // ORIN_LINK_H
@@ -0,0 +1,56 @@
+#ifndef POWER_LIMITER_H
+#define POWER_LIMITER_H
+
+#include <stdint.h>
+#include "dji_motor.h"
+#include "motor.h"
+
+/*
+ * Chassis power limiter on the referee's power and buffer energy. It runs in the motor task
+ * between DJI_Motor_Send and CAN_TX_Scheduler_Flush, on the chassis currents the CAN TX
+ * scheduler has staged (so it needs CAN_TX_SCHEDULER_ENABLED):
+ *  - every registered motor's electrical power is predicted from its staged command and its
+ *    speed, I (I R + Ke w) for an M3508 current command, V (V - Ke w) / R for a GM6020 voltage
+ *    command,
+ *  - the budget is the referee limit plus the buffer energy above POWER_LIMITER_BUFFER_RESERVE
+ *    spread over POWER_LIMITER_BUFFER_HORIZON, below the reserve it is less than the limit so
+ *    the buffer refills. Between referee samples the buffer is predicted from the power drawn,
+ *  - what the model misses (ESCs, wiring, the supercap board) is the referee average minus the
+ *    predicted average over the last BUFFER_SIZE referee samples, taken off the budget,
+ *  - the azimuth motors are served first and the drive motors share one scale that fits what
+ *    is left, the azimuths are only scaled when they alone exceed the budget,
+ *  - cap_power (set by the boost scheduler) is what the supercap supplies on top of the limit,
+ *    it is added to the budget and the referee is predicted to see only the rest.
+ * Comment out to send the chassis currents unchanged.
+ */
+#define POWER_LIMITER_ENABLED
+
+#define POWER_LIMITER_BUFFER_RESERVE (10.0f) // J never planned away, the penalty starts at 0
+#define POWER_LIMITER_BUFFER_HORIZON (0.2f)  // s over which the buffer above the reserve may go
+#define POWER_LIMITER_MAX_OFFSET (30.0f)     // W, bound on the learned model offset
+#define POWER_LIMITER_DEFAULT_LIMIT (60.0f)  // W until the referee reports a limit
+#define POWER_LIMITER_PERIOD (0.001f)        // s, motor task
+#define POWER_LIMITER_MAX_MOTORS (8)
+
+typedef struct
+{
+    float limit;           // W, referee chassis power limit
+    float buffer;          // J, referee buffer predicted to now
+    float budget;          // W the predicted power may reach this cycle, model offset taken off
+    float predicted_power; // W, staged commands before scaling
+    float limited_power;   // W, after scaling
+    float model_offset;    // W, referee average minus predicted average
+    float cap_power;       // W the supercap may supply above the limit
+    float drive_scale;
+    float azimuth_scale;
+    uint32_t limited_cycles;
+    uint32_t referee_samples;
+} Power_Limiter_t;
+
+void Power_Limiter_Register_Motor(DJI_Motor_Handle_t *motor_handle, Motor_Reversal_t reversal, uint8_t is_drive);
+void Power_Limiter_Referee_Sample(float chassis_power, float power_buffer, float power_limit);
+void Power_Limiter_Apply(void);
+
+extern Power_Limiter_t g_power_limiter;
+
+#endif // POWER_LIMITER_H
@@ -0,0 +1,58 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+/*
+ * Section timing on the cycle counter (DWT CYCCNT on the board, clock_gettime in SIL).
+ * Each section keeps min/max, a log-linear histogram for percentiles and a count of runs
+ * longer than its deadline. Comment out to compile the PROFILE_* macros away.
+ */
+#define PROFILER_ENABLED
+
+#define PROFILER_SUB_BUCKETS_BITS (2) // 4 buckets per power of two, <= 25% bucket width
+#define PROFILER_BUCKETS (32 << PROFILER_SUB_BUCKETS_BITS)
+
+typedef enum
+{
+    PROFILE_ROBOT_COMMAND,
+    PROFILE_CHASSIS,
+    PROFILE_GIMBAL,
+    PROFILE_LAUNCH,
+    PROFILE_MOTOR,
+    PROFILE_JETSON_SEND,
+    PROFILE_SECTION_COUNT
+} Profile_Section_e;
+
+typedef struct
+{
+    const char *name;
+    uint32_t deadline_us;
+    uint32_t deadline_cycles;
+    uint32_t start;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t deadline_misses;
+    uint32_t histogram[PROFILER_BUCKETS];
+} Profiler_Section_t;
+
+void Profiler_Init(void);
+void Profiler_Begin(Profile_Section_e section);
+void Profiler_End(Profile_Section_e section);
+void Profiler_Reset(void);
+uint32_t Profiler_Get_Percentile(Profile_Section_e section, float percentile);
+uint32_t Profiler_Cycles_To_Us(uint32_t cycles);
+
+#ifdef PROFILER_ENABLED
+#define PROFILE_BEGIN(section) Profiler_Begin(section)
+#define PROFILE_END(section) Profiler_End(section)
+#else
+#define PROFILE_BEGIN(section)
+#define PROFILE_END(section)
+#endif
+
+extern Profiler_Section_t g_profiler_sections[PROFILE_SECTION_COUNT];
+extern volatile uint8_t g_profiler_report_requested; // set from the debugger to stream a summary
+
+#endif // PROFILER_H
@@ -0,0 +1,51 @@
+#ifndef RATE_GROUP_H
+#define RATE_GROUP_H
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "cmsis_os.h"
+
+/*
+ * Control loops split by rate, each group in its own task. Priorities are rate monotonic,
+ * the shorter the period the higher the priority, so the gimbal is never held up by the
+ * chassis or the launch state machine. Periods are in ms and must divide each other.
+ */
+#define RATE_GROUP_GIMBAL_PERIOD (1)  // input sampling + gimbal
+#define RATE_GROUP_CHASSIS_PERIOD (2) // chassis kinematics
+#define RATE_GROUP_COMMAND_PERIOD (4) // state machine, remote input, launch
+
+// ms, period of the single control loop the groups replaced. Gains applied once per call were
+// tuned at it, scale them by RATE_GROUP_*_PERIOD / RATE_GROUP_TUNED_PERIOD to keep their rate
+#define RATE_GROUP_TUNED_PERIOD (2)
+
+typedef enum
+{
+    RATE_GROUP_GIMBAL,
+    RATE_GROUP_CHASSIS,
+    RATE_GROUP_COMMAND,
+    RATE_GROUP_COUNT
+} Rate_Group_e;
+
+typedef struct
+{
+    const char *name;
+    uint32_t period_ms;
+    osPriority priority;
+    void (*loop)(void);
+    osThreadId handle;
+
+    uint32_t period_cycles;
+    uint32_t runs;
+    uint32_t overruns;            // cycles still running at the next release
+    uint32_t release_timeouts;    // EVENT_DRIVEN_CONTROL: released by timeout, no feedback
+    uint32_t max_response_cycles; // release to loop done
+} Rate_Group_t;
+
+void Rate_Group_Init(void);
+void Rate_Group_Wait(Rate_Group_e group, TickType_t *last_wake_time);
+void Rate_Group_Run(Rate_Group_e group);
+void Rate_Group_Release_From_ISR(uint32_t feedback_set, BaseType_t *higher_priority_task_woken);
+
+extern Rate_Group_t g_rate_groups[RATE_GROUP_COUNT];
+
+#endif // RATE_GROUP_H
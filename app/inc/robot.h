@@ -87,6 +87,9 @@ typedef struct
   uint8_t prev_V;
   uint8_t prev_Z;
   uint8_t prev_Shift;
+
+  // previous controller supercap hold
+  uint8_t prev_supercap_held;
 } Input_State_t;
 
 typedef struct
@@ -113,6 +116,8 @@ typedef struct
 
 void Robot_Init(void);
 void Robot_Command_Loop(void);
+void Robot_Chassis_Loop(void);
+void Robot_Gimbal_Loop(void);
 void Handle_Starting_Up_State(void);
 void Handle_Enabled_State(void);
 void Handle_Disabled_State(void);
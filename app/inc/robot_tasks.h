@@ -10,60 +10,95 @@
 #include "motor_task.h"
 #include "debug_task.h"
 #include "jetson_orin.h"
+#include "orin_link.h"
 #include "bsp_serial.h"
 #include "bsp_daemon.h"
+#include "control_sync.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "rate_group.h"
 
 extern void IMU_Task(void const *pvParameters);
 
+/*
+ * Task control blocks and stacks are static when FreeRTOSConfig.h enables
+ * configSUPPORT_STATIC_ALLOCATION, so no task comes out of the heap_4 heap.
+ * Stack sizes are in words; `make ram_report` prints the worst case use of each.
+ */
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+#define ROBOT_TASK_DEF(name, thread, priority, instances, stacksz) \
+    static uint32_t name##_stack[stacksz];                          \
+    static osStaticThreadDef_t name##_control_block;                \
+    osThreadStaticDef(name, thread, priority, instances, stacksz, name##_stack, &name##_control_block)
+#else
+#define ROBOT_TASK_DEF(name, thread, priority, instances, stacksz) osThreadDef(name, thread, priority, instances, stacksz)
+#endif
+
 osThreadId imu_task_handle;
-osThreadId robot_command_task_handle;
 osThreadId motor_task_handle;
 osThreadId ui_task_handle;
 osThreadId debug_task_handle;
 osThreadId jetson_orin_task_handle;
 osThreadId daemon_task_handle;
+osThreadId telemetry_task_handle;
 
-void Robot_Tasks_Robot_Command(void const *argument);
+void Robot_Tasks_Rate_Group(void const *argument);
 void Robot_Tasks_Motor(void const *argument);
 void Robot_Tasks_IMU(void const *argument);
 void Robot_Tasks_UI(void const *argument);
 void Robot_Tasks_Debug(void const *argument);
 void Robot_Tasks_Jetson_Orin(void const *argument);
 void Robot_Tasks_Daemon(void const *argument);
+void Robot_Tasks_Telemetry(void const *argument);
 
 void Robot_Tasks_Start()
 {
-    osThreadDef(imu_task, Robot_Tasks_IMU, osPriorityAboveNormal, 0, 1024);
+    // IMU is the highest priority task so no reader can preempt it mid-update (see input_snapshot.c)
+    ROBOT_TASK_DEF(imu_task, Robot_Tasks_IMU, osPriorityRealtime, 0, 1024);
     imu_task_handle = osThreadCreate(osThread(imu_task), NULL);
 
-    osThreadDef(motor_task, Robot_Tasks_Motor, osPriorityAboveNormal, 0, 256);
+    // control tasks are rate monotonic, the priorities of the rate groups come from g_rate_groups
+    ROBOT_TASK_DEF(motor_task, Robot_Tasks_Motor, osPriorityHigh, 0, 256);
     motor_task_handle = osThreadCreate(osThread(motor_task), NULL);
 
-    osThreadDef(robot_command_task, Robot_Tasks_Robot_Command, osPriorityAboveNormal, 0, 256);
-    robot_command_task_handle = osThreadCreate(osThread(robot_command_task), NULL);
+    ROBOT_TASK_DEF(gimbal_group_task, Robot_Tasks_Rate_Group, g_rate_groups[RATE_GROUP_GIMBAL].priority, 0, 256);
+    g_rate_groups[RATE_GROUP_GIMBAL].handle = osThreadCreate(osThread(gimbal_group_task), (void *)RATE_GROUP_GIMBAL);
+
+    ROBOT_TASK_DEF(chassis_group_task, Robot_Tasks_Rate_Group, g_rate_groups[RATE_GROUP_CHASSIS].priority, 0, 256);
+    g_rate_groups[RATE_GROUP_CHASSIS].handle = osThreadCreate(osThread(chassis_group_task), (void *)RATE_GROUP_CHASSIS);
+
+    ROBOT_TASK_DEF(robot_command_task, Robot_Tasks_Rate_Group, g_rate_groups[RATE_GROUP_COMMAND].priority, 0, 256);
+    g_rate_groups[RATE_GROUP_COMMAND].handle = osThreadCreate(osThread(robot_command_task), (void *)RATE_GROUP_COMMAND);
 
-    osThreadDef(ui_task, Robot_Tasks_UI, osPriorityAboveNormal, 0, 256);
+    ROBOT_TASK_DEF(ui_task, Robot_Tasks_UI, osPriorityAboveNormal, 0, 256);
     ui_task_handle = osThreadCreate(osThread(ui_task), NULL);
 
-    osThreadDef(debug_task, Robot_Tasks_Debug, osPriorityIdle, 0, 256);
+    ROBOT_TASK_DEF(debug_task, Robot_Tasks_Debug, osPriorityIdle, 0, 256);
     debug_task_handle = osThreadCreate(osThread(debug_task), NULL);
 
-    osThreadDef(jetson_orin_task, Robot_Tasks_Jetson_Orin, osPriorityAboveNormal, 0, 256);
+    // 10 ms periods, slower than every control group
+    ROBOT_TASK_DEF(jetson_orin_task, Robot_Tasks_Jetson_Orin, osPriorityBelowNormal, 0, 256);
     jetson_orin_task_handle = osThreadCreate(osThread(jetson_orin_task), NULL);
 
-    osThreadDef(daemon_task, Robot_Tasks_Daemon, osPriorityAboveNormal, 0, 256);
+    ROBOT_TASK_DEF(daemon_task, Robot_Tasks_Daemon, osPriorityBelowNormal, 0, 256);
     daemon_task_handle = osThreadCreate(osThread(daemon_task), NULL);
+
+#ifdef TELEMETRY_ENABLED
+    // below the control tasks, sampling only copies registered values and the UART is DMA driven
+    ROBOT_TASK_DEF(telemetry_task, Robot_Tasks_Telemetry, osPriorityBelowNormal, 0, 256);
+    telemetry_task_handle = osThreadCreate(osThread(telemetry_task), NULL);
+#endif
 }
 
-void Robot_Tasks_Robot_Command(void const *argument)
+void Robot_Tasks_Rate_Group(void const *argument)
 {
+    Rate_Group_e group = (Rate_Group_e)(uintptr_t)argument;
     portTickType xLastWakeTime;
     xLastWakeTime = xTaskGetTickCount();
-    const TickType_t TimeIncrement = pdMS_TO_TICKS(2);
     while (1)
     {
-        Robot_Command_Loop();
-        vTaskDelayUntil(&xLastWakeTime, TimeIncrement);
+        Rate_Group_Wait(group, &xLastWakeTime);
+        Rate_Group_Run(group);
     }
 }
 
@@ -74,6 +109,13 @@ __weak void Robot_Tasks_IMU(void const *argument)
 
 void Robot_Tasks_Motor(void const *argument)
 {
+#ifdef EVENT_DRIVEN_CONTROL
+    while (1)
+    {
+        Control_Sync_Wait_For_Command();
+        Motor_Task_Loop();
+    }
+#else
     portTickType xLastWakeTime;
     xLastWakeTime = xTaskGetTickCount();
     const TickType_t TimeIncrement = pdMS_TO_TICKS(1);
@@ -82,6 +124,7 @@ void Robot_Tasks_Motor(void const *argument)
         Motor_Task_Loop();
         vTaskDelayUntil(&xLastWakeTime, TimeIncrement);
     }
+#endif
 }
 
 void Robot_Tasks_UI(void const *argument)
@@ -112,10 +155,20 @@ void Robot_Tasks_Jetson_Orin(void const *argument)
 {
     portTickType xLastWakeTime;
     xLastWakeTime = xTaskGetTickCount();
+#ifdef ORIN_LINK_ENABLED
+    const TickType_t TimeIncrement = pdMS_TO_TICKS(ORIN_LINK_PERIOD);
+#else
     const TickType_t TimeIncrement = pdMS_TO_TICKS(JETSON_ORIN_PERIOD);
+#endif
     while (1)
     {
+        PROFILE_BEGIN(PROFILE_JETSON_SEND);
+#ifdef ORIN_LINK_ENABLED
+        Orin_Link_Task_Loop();
+#else
         Jetson_Orin_Send_Data();
+#endif
+        PROFILE_END(PROFILE_JETSON_SEND);
         vTaskDelayUntil(&xLastWakeTime, TimeIncrement);
     }
 }
@@ -131,3 +184,15 @@ void Robot_Tasks_Daemon(void const *argument)
         vTaskDelayUntil(&xLastWakeTime, TimeIncrement);
     }
 }
+
+void Robot_Tasks_Telemetry(void const *argument)
+{
+    portTickType xLastWakeTime;
+    xLastWakeTime = xTaskGetTickCount();
+    const TickType_t TimeIncrement = pdMS_TO_TICKS(TELEMETRY_PERIOD);
+    while (1)
+    {
+        Telemetry_Task_Loop();
+        vTaskDelayUntil(&xLastWakeTime, TimeIncrement);
+    }
+}
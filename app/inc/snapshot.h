@@ -0,0 +1,42 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+
+/*
+ * Lock-free single writer, multi reader snapshots (seqlock).
+ * The writer bumps the sequence to odd, copies, then bumps it to even. Readers copy and retry
+ * if the sequence was odd or changed underneath them. Neither side disables interrupts.
+ * A reader must not outrank the writer: on one core, a reader that preempted a publish spins on
+ * the odd sequence and the writer never runs to finish it. Hand data up in priority through a
+ * two slot buffer with an atomically published index instead (see Gimbal_Set_Command).
+ */
+typedef struct
+{
+    volatile uint32_t sequence;
+    uint16_t size;
+    void *data;
+} Snapshot_t;
+
+#define SNAPSHOT_SAMPLE_MAX_SIZE (128)
+
+#define SNAPSHOT_INIT(buffer) {.sequence = 0, .size = sizeof(buffer), .data = &(buffer)}
+
+void Snapshot_Publish(Snapshot_t *snapshot, const void *src);
+void Snapshot_Read(const Snapshot_t *snapshot, void *dst);
+
+/**
+ * @brief Coherent copy of a plain global whose writer we do not own, by copying until two
+ * consecutive copies match. Valid when the writer can not be preempted by the caller mid-write,
+ * i.e. it is an ISR or a higher priority task. Returns the number of retries.
+ */
+uint32_t Snapshot_Sample(void *dst, const volatile void *src, uint16_t size);
+
+#define SNAPSHOT_SAMPLE(dst, src)                                                              \
+    ({                                                                                         \
+        _Static_assert(sizeof(dst) == sizeof(src), "snapshot size mismatch");                \
+        _Static_assert(sizeof(src) <= SNAPSHOT_SAMPLE_MAX_SIZE, "snapshot sample too large"); \
+        Snapshot_Sample(&(dst), &(src), sizeof(src));                                          \
+    })
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,29 @@
+#ifndef STATIC_POOL_H
+#define STATIC_POOL_H
+
+#include <stdint.h>
+
+/*
+ * Fixed-size pool behind malloc/calloc (linked with -Wl,--wrap=malloc,...), so the
+ * driver handles control-base allocates at init (DJI_Motor_Init, CAN_Device_Register, ...)
+ * live in one statically sized block instead of the newlib heap. Blocks are never
+ * freed; running out stops in Error_Handler at boot rather than at run time. Once
+ * Static_Pool_Lock marks the end of start up, allocations go to the newlib heap and their
+ * frees return the memory, so a run time malloc/free pair does not drain the pool.
+ */
+#define STATIC_POOL_SIZE (8 * 1024)
+#define STATIC_POOL_ALIGNMENT (8)
+
+typedef struct
+{
+    uint32_t used;             // bytes handed out, incl. alignment padding
+    uint32_t allocations;
+    uint32_t late_allocations; // heap allocations after Static_Pool_Lock, should stay 0
+    uint32_t ignored_frees;    // free() of pool blocks, which are never reused
+} Static_Pool_Stats_t;
+
+void Static_Pool_Lock(void);
+
+extern Static_Pool_Stats_t g_static_pool_stats;
+
+#endif // STATIC_POOL_H
@@ -0,0 +1,97 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+/*
+ * Binary telemetry over huart6 in place of DEBUG_PRINTF. Registered channels are sampled
+ * by the telemetry task into COBS framed, CRC16 checked packets queued on a ring buffer
+ * that is drained by UART DMA, so no float formatting or blocking UART write happens on
+ * the MCU. Other modules put their own frames on the stream with Telemetry_Send (the Orin
+ * link, orin_link.h). Decode on the host with tools/telemetry_decode.py.
+ * Comment out to keep huart6 for DEBUG_PRINTF text.
+ */
+#define TELEMETRY_ENABLED
+
+/*
+ * huart6 runs 8N1, TELEMETRY_BAUD_RATE / 10 bytes/s. The stream is budgeted TELEMETRY_LOAD
+ * percent of that, TELEMETRY_SEND_BYTE_RATE of it kept for Telemetry_Send frames, and sample
+ * frames are decimated (telemetry.c) so the largest one TELEMETRY_MAX_CHANNELS can make fits
+ * the rest. Schema and log frames come out of the headroom.
+ */
+#define TELEMETRY_BAUD_RATE (921600)       // huart6, set by Telemetry_Init, what the host tools default to
+#define TELEMETRY_LOAD (80)                // % of the line the stream may plan to fill
+#define TELEMETRY_SEND_BYTE_RATE (35000)   // bytes/s kept for Telemetry_Send frames
+
+#define TELEMETRY_PERIOD (1)              // ms, telemetry task period
+#define TELEMETRY_SCHEMA_INTERVAL (1000)  // sample frames between schema frames so a decoder can join mid stream
+#define TELEMETRY_MAX_CHANNELS (48)
+#define TELEMETRY_MAX_NAME_LENGTH (23)
+#define TELEMETRY_MAX_LOG_LENGTH (96)
+#define TELEMETRY_MAX_SEND_LENGTH (64)
+#define TELEMETRY_SEND_SLOTS (4)          // Telemetry_Send frames waiting for the telemetry task
+#define TELEMETRY_RING_SIZE (4096)        // power of two, must not sit in CCM RAM (not reachable by DMA)
+
+typedef enum
+{
+    TELEMETRY_FRAME_SAMPLE = 1,
+    TELEMETRY_FRAME_SCHEMA = 2,
+    TELEMETRY_FRAME_LOG = 3,
+} Telemetry_Frame_e;
+
+typedef enum
+{
+    TELEMETRY_U8 = 0,
+    TELEMETRY_I8,
+    TELEMETRY_U16,
+    TELEMETRY_I16,
+    TELEMETRY_U32,
+    TELEMETRY_I32,
+    TELEMETRY_F32,
+} Telemetry_Type_e;
+
+typedef struct
+{
+    const char *name;
+    Telemetry_Type_e type;
+    const void *source;
+} Telemetry_Channel_t;
+
+typedef struct
+{
+    uint32_t frames;          // sample frames queued
+    uint32_t dropped_frames;  // frames not queued because the ring was full (link too slow)
+    uint32_t dma_transfers;
+    uint16_t frame_size;      // encoded bytes per sample frame, incl. delimiter
+    uint16_t ring_high_water; // most bytes ever pending in the ring
+    uint32_t dropped_sends;   // Telemetry_Send frames taken but not queued, ring full
+    uint16_t sample_rate;     // Hz, sample frames after decimation
+} Telemetry_Stats_t;
+
+void Telemetry_Init(void);
+uint8_t Telemetry_Register(const char *name, Telemetry_Type_e type, const void *source);
+void Telemetry_Start(void);
+uint8_t Telemetry_Log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+uint8_t Telemetry_Send(uint8_t type, const void *body, uint16_t length);
+uint8_t Telemetry_Send_Timed(uint8_t type, const void *body, uint16_t length);
+uint8_t Telemetry_Get_Timed_Cycles(uint32_t *cycles);
+void Telemetry_Task_Loop(void);
+
+/**
+ * @brief Register a channel with its type picked from the pointer type, e.g.
+ * TELEMETRY_REGISTER("imu_yaw", &g_inputs.imu.yaw);
+ */
+#define TELEMETRY_REGISTER(name, source)                      \
+    Telemetry_Register((name), _Generic((source),             \
+                           uint8_t *: TELEMETRY_U8,           \
+                           int8_t *: TELEMETRY_I8,            \
+                           uint16_t *: TELEMETRY_U16,         \
+                           int16_t *: TELEMETRY_I16,          \
+                           uint32_t *: TELEMETRY_U32,         \
+                           int32_t *: TELEMETRY_I32,          \
+                           float *: TELEMETRY_F32),           \
+                       (source))
+
+extern Telemetry_Stats_t g_telemetry_stats;
+
+#endif // TELEMETRY_H
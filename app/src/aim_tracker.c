@@ -0,0 +1,113 @@
+#include "aim_tracker.h"
+
+#include <math.h>
+#include "fast_math.h"
+
+Aim_Tracker_t g_aim_tracker = {0};
+
+static void Aim_Tracker_Axis_Start(Aim_Tracker_Axis_t *axis, float angle)
+{
+    axis->angle = angle;
+    axis->rate = 0.0f;
+    axis->p[0][0] = AIM_TRACKER_MEASUREMENT_NOISE * AIM_TRACKER_MEASUREMENT_NOISE;
+    axis->p[0][1] = 0.0f;
+    axis->p[1][0] = 0.0f;
+    axis->p[1][1] = AIM_TRACKER_INITIAL_RATE * AIM_TRACKER_INITIAL_RATE;
+}
+
+/**
+ * @brief Predict the axis dt forward and correct it with a measurement of its angle, innovation
+ * being measurement - predicted angle (the caller folds yaw the short way round).
+ */
+static void Aim_Tracker_Axis_Update(Aim_Tracker_Axis_t *axis, float dt, float innovation)
+{
+    float (*p)[2] = axis->p;
+    // F = [1 dt; 0 1], Q from white acceleration over dt
+    const float q = AIM_TRACKER_ACCELERATION_NOISE;
+    float p00 = p[0][0] + dt * (p[1][0] + p[0][1]) + dt * dt * p[1][1] + q * dt * dt * dt / 3.0f;
+    float p01 = p[0][1] + dt * p[1][1] + q * dt * dt / 2.0f;
+    float p10 = p[1][0] + dt * p[1][1] + q * dt * dt / 2.0f;
+    float p11 = p[1][1] + q * dt;
+
+    // H = [1 0]
+    float s = p00 + AIM_TRACKER_MEASUREMENT_NOISE * AIM_TRACKER_MEASUREMENT_NOISE;
+    float k0 = p00 / s;
+    float k1 = p10 / s;
+    axis->angle += k0 * innovation;
+    axis->rate += k1 * innovation;
+    p[0][0] = (1.0f - k0) * p00;
+    p[0][1] = (1.0f - k0) * p01;
+    p[1][0] = p10 - k1 * p00;
+    p[1][1] = p11 - k1 * p01;
+}
+
+/**
+ * @brief Take a measurement of the target in the world frame at its capture tick, in capture
+ * order. Starts a new track when there is none, the last one timed out or the measurement is
+ * outside the gate.
+ */
+void Aim_Tracker_Measure(uint32_t tick, float yaw, float pitch)
+{
+    Aim_Tracker_t *tracker = &g_aim_tracker;
+    tracker->measurements++;
+    if (tracker->target_valid && (int32_t)(tick - tracker->tick) > AIM_TRACKER_TIMEOUT)
+    {
+        tracker->target_valid = 0;
+        tracker->timeouts++;
+    }
+    float dt = (int32_t)(tick - tracker->tick) > 0 ? (float)(tick - tracker->tick) * 0.001f : 0.0f;
+    float predicted_yaw = tracker->yaw.angle + tracker->yaw.rate * dt;
+    float predicted_pitch = tracker->pitch.angle + tracker->pitch.rate * dt;
+    float yaw_innovation = Angle_Difference(yaw, predicted_yaw);
+    float pitch_innovation = pitch - predicted_pitch;
+    if (!tracker->target_valid || fabsf(yaw_innovation) > AIM_TRACKER_GATE || fabsf(pitch_innovation) > AIM_TRACKER_GATE)
+    {
+        Aim_Tracker_Axis_Start(&tracker->yaw, yaw);
+        Aim_Tracker_Axis_Start(&tracker->pitch, pitch);
+        tracker->tick = tick;
+        tracker->target_valid = 1;
+        tracker->targets++;
+        return;
+    }
+
+    // a capture older than the last one (tick jitter on arrival) only corrects the state
+    tracker->yaw.angle = predicted_yaw;
+    tracker->pitch.angle = predicted_pitch;
+    Aim_Tracker_Axis_Update(&tracker->yaw, dt, yaw_innovation);
+    Aim_Tracker_Axis_Update(&tracker->pitch, dt, pitch_innovation);
+    tracker->yaw.angle = Wrap_Angle(tracker->yaw.angle);
+    if (dt > 0.0f)
+    {
+        tracker->tick = tick;
+    }
+}
+
+/**
+ * @brief The Orin reports no target, forget the track.
+ */
+void Aim_Tracker_Drop(void)
+{
+    g_aim_tracker.target_valid = 0;
+}
+
+/**
+ * @brief Target attitude at tick, extrapolated from the last measurement.
+ * @return target_valid, the attitude is untouched when 0
+ */
+uint8_t Aim_Tracker_Predict(uint32_t tick, float *yaw, float *pitch)
+{
+    Aim_Tracker_t *tracker = &g_aim_tracker;
+    if (tracker->target_valid && (int32_t)(tick - tracker->tick) > AIM_TRACKER_TIMEOUT)
+    {
+        tracker->target_valid = 0;
+        tracker->timeouts++;
+    }
+    if (!tracker->target_valid)
+    {
+        return 0;
+    }
+    float dt = (int32_t)(tick - tracker->tick) > 0 ? (float)(tick - tracker->tick) * 0.001f : 0.0f;
+    *yaw = Wrap_Angle(tracker->yaw.angle + tracker->yaw.rate * dt);
+    *pitch = tracker->pitch.angle + tracker->pitch.rate * dt;
+    return 1;
+}
@@ -0,0 +1,121 @@
+#include "boost_scheduler.h"
+
+#include <math.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "supercap.h"
+#include "power_limiter.h"
+#include "robot.h"
+#include "user_math.h"
+
+extern Supercap_t g_supercap;
+
+Boost_Scheduler_t g_boost_scheduler = {.speed_scale = 1.0f, .omega_scale = 1.0f, .cap_armed = 1};
+
+static uint32_t g_boost_last_tick = 0;
+
+static float Boost_Approach(float value, float target, float max_step)
+{
+    float step = target - value;
+    __MAX_LIMIT(step, -max_step, max_step);
+    return value + step;
+}
+
+/**
+ * @brief Account the cap's energy change to the current match once the reading has moved
+ * BOOST_ACCOUNT_STEP from the last accounted one, the board's 1 % steps flicker. The driver
+ * reads 0 % until the first frame from the cap board, so changes from or to 0 are left out.
+ */
+static void Boost_Account(Boost_Scheduler_t *boost, float percent, uint32_t period_ms)
+{
+    Boost_Match_t *match = &boost->match;
+    match->duration_ms += period_ms;
+    float last_percent = boost->percent;
+    if (percent <= 0.0f || last_percent <= 0.0f)
+    {
+        boost->percent = percent;
+        return;
+    }
+    if (fabsf(percent - last_percent) < BOOST_ACCOUNT_STEP)
+    {
+        return;
+    }
+    boost->percent = percent;
+    float energy_change = (percent - last_percent) * (BOOST_SUPERCAP_ENERGY / 100.0f);
+    if (energy_change > 0.0f)
+    {
+        match->recharged += energy_change;
+    }
+    else if (g_robot_state.chassis.IS_SPINTOP_ENABLED)
+    {
+        match->spent_spintop -= energy_change;
+    }
+    else
+    {
+        match->spent_translation -= energy_change;
+    }
+    match->min_percent = percent < match->min_percent ? percent : match->min_percent;
+}
+
+/**
+ * @brief Turn the cap output on or off, move the speed envelope and hand the cap's power to the
+ * power limiter, call once per chassis cycle before the command is scaled.
+ */
+void Boost_Scheduler_Update(uint32_t period_ms)
+{
+    Boost_Scheduler_t *boost = &g_boost_scheduler;
+    float percent = g_supercap.supercap_percent;
+
+    // the chassis group only runs while enabled, a gap starts a new match
+    uint32_t tick = xTaskGetTickCount();
+    if (boost->matches == 0 || tick - g_boost_last_tick > 2 * period_ms)
+    {
+        memset(&boost->match, 0, sizeof(boost->match));
+        boost->match.min_percent = 100.0f;
+        boost->percent = percent;
+        boost->matches++;
+    }
+    g_boost_last_tick = tick;
+    Boost_Account(boost, percent, period_ms);
+
+    if (percent <= BOOST_EMPTY_PERCENT)
+    {
+        boost->cap_armed = 0;
+    }
+    else if (percent >= BOOST_REARM_PERCENT)
+    {
+        boost->cap_armed = 1;
+    }
+    uint8_t requested = g_robot_state.IS_SUPER_CAPACITOR_ENABLED;
+    uint8_t cap_on = requested && boost->cap_armed;
+    g_supercap.supercap_enabled_flag = cap_on;
+
+    // all of the boost down to BOOST_FULL_PERCENT, none at BOOST_EMPTY_PERCENT
+    float fraction = 0.0f;
+    if (cap_on)
+    {
+        fraction = (percent - BOOST_EMPTY_PERCENT) / (BOOST_FULL_PERCENT - BOOST_EMPTY_PERCENT);
+        __MAX_LIMIT(fraction, 0.0f, 1.0f);
+    }
+    float max_step = BOOST_SCALE_RATE * period_ms * 0.001f;
+    boost->speed_scale = Boost_Approach(boost->speed_scale, 1.0f + (BOOST_MAX_SPEED_SCALE - 1.0f) * fraction, max_step);
+    boost->omega_scale = Boost_Approach(boost->omega_scale, 1.0f + (BOOST_MAX_OMEGA_SCALE - 1.0f) * fraction, max_step);
+    boost->cap_power = BOOST_CAP_POWER * fraction;
+#ifdef POWER_LIMITER_ENABLED
+    g_power_limiter.cap_power = boost->cap_power;
+#endif
+
+    if (boost->speed_scale >= BOOST_MAX_SPEED_SCALE)
+    {
+        boost->match.boost_ms += period_ms;
+    }
+    else if (boost->speed_scale > 1.0f)
+    {
+        boost->match.taper_ms += period_ms;
+    }
+    if (requested && !cap_on)
+    {
+        boost->match.empty_ms += period_ms;
+    }
+}
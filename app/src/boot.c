@@ -0,0 +1,62 @@
+#include "boot.h"
+
+#include "cycle_counter.h"
+
+Boot_Report_t g_boot_report = {0};
+
+static uint32_t g_boot_start_cycles = 0;
+
+static uint32_t Boot_Elapsed_Us(void)
+{
+    return (uint32_t)((uint64_t)(Cycle_Counter_Get() - g_boot_start_cycles) * 1000000U / CYCLE_COUNTER_HZ);
+}
+
+static Boot_Trace_t *Boot_Add_Trace(const char *name)
+{
+    if (g_boot_report.stage_count >= BOOT_MAX_STAGES)
+    {
+        return NULL;
+    }
+    Boot_Trace_t *trace = &g_boot_report.stages[g_boot_report.stage_count++];
+    trace->name = name;
+    trace->start_us = Boot_Elapsed_Us();
+    trace->duration_us = 0;
+    return trace;
+}
+
+/**
+ * @brief Zero of the boot trace, call first thing in Robot_Init.
+ */
+void Boot_Begin(void)
+{
+    Cycle_Counter_Init();
+    g_boot_start_cycles = Cycle_Counter_Get();
+    g_boot_report.stage_count = 0;
+    g_boot_report.ready_us = 0;
+}
+
+/**
+ * @brief Record a zero length event, e.g. the first command task run after the scheduler starts.
+ */
+void Boot_Mark(const char *name)
+{
+    Boot_Add_Trace(name);
+}
+
+/**
+ * @brief Run the stages in table order, a stage may rely on everything before it.
+ * Returns once all of them are done, which is the barrier for leaving STARTING_UP.
+ */
+void Boot_Run(const Boot_Stage_t *stages, uint8_t stage_count)
+{
+    for (uint8_t i = 0; i < stage_count; i++)
+    {
+        Boot_Trace_t *trace = Boot_Add_Trace(stages[i].name);
+        stages[i].init();
+        if (trace != NULL)
+        {
+            trace->duration_us = Boot_Elapsed_Us() - trace->start_us;
+        }
+    }
+    g_boot_report.ready_us = Boot_Elapsed_Us();
+}
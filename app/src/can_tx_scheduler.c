@@ -0,0 +1,304 @@
+#include "can_tx_scheduler.h"
+
+#include <string.h>
+
+#include "bsp_can.h"
+#include "can.h"
+#include "cycle_counter.h"
+
+HAL_StatusTypeDef __real_CAN_Transmit(CAN_Instance_t *can_instance);
+CAN_Instance_t *__real_CAN_Device_Register(uint8_t _can_bus, uint16_t _tx_id, uint16_t _rx_id,
+                                           void (*_can_module_callback)(CAN_Instance_t *can_instance));
+
+// DJI ESCs broadcast feedback on 0x201-0x20B at 1 kHz whether or not they are commanded
+#define CAN_TX_DJI_FEEDBACK_FIRST (0x201)
+#define CAN_TX_DJI_FEEDBACK_LAST (0x20B)
+
+typedef struct
+{
+    CAN_Instance_t instance; // own copy, the caller's instance may be a temporary
+    CAN_TxHeaderTypeDef header;
+    uint8_t last_sent[8];
+    uint8_t used;
+    uint8_t priority;
+    uint8_t staged;  // queued since the last flush
+    uint8_t pending; // due but no mailbox was free, retried next flush
+    uint8_t ever_sent;
+} CAN_TX_Slot_t;
+
+CAN_TX_Stats_t g_can_tx_stats = {0};
+
+static CAN_TX_Slot_t g_can_tx_slots[CAN_TX_BUS_COUNT][CAN_TX_MAX_SLOTS];
+static uint8_t g_can_tx_batch = 0;
+static uint32_t g_can_tx_window_start = 0;
+
+static CAN_HandleTypeDef *const g_can_tx_handles[CAN_TX_BUS_COUNT] = {&hcan1, &hcan2};
+static const uint8_t g_can_tx_bus_period[CAN_TX_BUS_COUNT] = {1, CAN_TX_CAN2_PERIOD};
+
+_Static_assert(CAN_TX_REFRESH_PERIOD % CAN_TX_CAN2_PERIOD == 0 && CAN_TX_IDLE_PERIOD % CAN_TX_CAN2_PERIOD == 0,
+               "CAN2 refreshes must fall on a block's turn");
+
+/**
+ * @brief Bits on the wire for a standard data frame incl. the 3 bit IFS. Stuff bits are
+ * not counted, they depend on the payload and add at most 24 bits (22%) to an 8 byte frame.
+ */
+static uint32_t CAN_TX_Frame_Bits(uint32_t dlc)
+{
+    return 47 + 8 * dlc;
+}
+
+/**
+ * @brief Identifier block and byte offset of a DJI motor's current in the group frames.
+ * GM6020 ids 1-7 share the blocks of M3508/M2006 ids 5-11.
+ */
+static uint16_t CAN_TX_Motor_Block(const DJI_Motor_Handle_t *motor_handle, uint8_t *byte_offset)
+{
+    uint16_t slot_id = motor_handle->speed_controller_id + (motor_handle->motor_type == GM6020 ? 4 : 0);
+    *byte_offset = 2 * ((slot_id - 1) % 4);
+    return slot_id <= 4 ? 0x200 : (slot_id <= 8 ? 0x1FF : 0x2FF);
+}
+
+static CAN_TX_Slot_t *CAN_TX_Find_Slot(uint8_t bus_index, uint16_t tx_id)
+{
+    CAN_TX_Slot_t *slots = g_can_tx_slots[bus_index];
+    for (int i = 0; i < CAN_TX_MAX_SLOTS; i++)
+    {
+        if (slots[i].used && slots[i].header.StdId == tx_id)
+        {
+            return &slots[i];
+        }
+        if (!slots[i].used)
+        {
+            slots[i].used = 1;
+            slots[i].header.StdId = tx_id;
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Hand one frame to a mailbox and account for it.
+ * @return HAL_BUSY if every mailbox is taken, otherwise the CAN_Transmit status
+ */
+static HAL_StatusTypeDef CAN_TX_Submit(uint8_t bus_index, CAN_Instance_t *can_instance)
+{
+    CAN_TX_Bus_Stats_t *stats = &g_can_tx_stats.bus[bus_index];
+    if (HAL_CAN_GetTxMailboxesFreeLevel(g_can_tx_handles[bus_index]) == 0)
+    {
+        stats->mailbox_full++;
+        return HAL_BUSY;
+    }
+    HAL_StatusTypeDef status = __real_CAN_Transmit(can_instance);
+    if (status != HAL_OK)
+    {
+        stats->tx_errors++;
+        return status;
+    }
+    stats->frames_sent++;
+    stats->window_bits += CAN_TX_Frame_Bits(can_instance->tx_header->DLC);
+    return HAL_OK;
+}
+
+static uint8_t CAN_TX_Is_Due(const CAN_TX_Slot_t *slot, uint8_t bus_index, uint8_t slot_index, uint32_t tick)
+{
+    // the blocks of a bus take turns, on CAN1 every tick is every block's turn
+    uint32_t phase = tick + slot_index;
+    if (phase % g_can_tx_bus_period[bus_index] != 0)
+    {
+        return 0;
+    }
+    if (slot->pending || !slot->ever_sent || memcmp(slot->instance.tx_buffer, slot->last_sent, 8) != 0)
+    {
+        return 1;
+    }
+    uint8_t all_zero = 1;
+    for (int i = 0; i < 8; i++)
+    {
+        all_zero &= slot->instance.tx_buffer[i] == 0;
+    }
+    uint32_t period = all_zero ? CAN_TX_IDLE_PERIOD : CAN_TX_REFRESH_PERIOD;
+    // CAN2 refreshes half a period after CAN1 and the blocks one after another, so unchanged
+    // frames never pile up on one tick
+    return (phase + bus_index * period / 2) % period == 0;
+}
+
+static void CAN_TX_Flush_Slot(CAN_TX_Slot_t *slot, uint8_t bus_index, uint8_t slot_index, uint32_t tick)
+{
+    if (!slot->staged && !slot->pending)
+    {
+        return;
+    }
+    slot->staged = 0;
+    if (!CAN_TX_Is_Due(slot, bus_index, slot_index, tick))
+    {
+        g_can_tx_stats.bus[bus_index].frames_skipped++;
+        return;
+    }
+    if (CAN_TX_Submit(bus_index, &slot->instance) != HAL_OK)
+    {
+        slot->pending = 1;
+        return;
+    }
+    slot->pending = 0;
+    slot->ever_sent = 1;
+    memcpy(slot->last_sent, slot->instance.tx_buffer, 8);
+}
+
+static void CAN_TX_Flush_Pass(uint8_t priority, uint32_t tick)
+{
+    for (uint8_t bus_index = 0; bus_index < CAN_TX_BUS_COUNT; bus_index++)
+    {
+        for (int i = 0; i < CAN_TX_MAX_SLOTS; i++)
+        {
+            if (g_can_tx_slots[bus_index][i].priority == priority)
+            {
+                CAN_TX_Flush_Slot(&g_can_tx_slots[bus_index][i], bus_index, (uint8_t)i, tick);
+            }
+        }
+    }
+}
+
+static void CAN_TX_Update_Load(uint32_t tick)
+{
+    uint32_t window_ms = tick - g_can_tx_window_start;
+    if (window_ms < CAN_TX_LOAD_WINDOW)
+    {
+        return;
+    }
+    g_can_tx_window_start = tick;
+    float capacity_bits = (float)CAN_TX_BITRATE * (float)window_ms / 1000.0f;
+    for (int bus_index = 0; bus_index < CAN_TX_BUS_COUNT; bus_index++)
+    {
+        CAN_TX_Bus_Stats_t *stats = &g_can_tx_stats.bus[bus_index];
+        uint32_t rx_frames = stats->feedback_devices * window_ms;
+        stats->frames_rx += rx_frames;
+        uint32_t bits = stats->window_bits + rx_frames * CAN_TX_Frame_Bits(8);
+        stats->window_bits = 0;
+        stats->load_percent = 100.0f * (float)bits / capacity_bits;
+        if (stats->load_percent > stats->peak_load_percent)
+        {
+            stats->peak_load_percent = stats->load_percent;
+        }
+    }
+}
+
+void CAN_TX_Scheduler_Init(void)
+{
+    for (int bus_index = 0; bus_index < CAN_TX_BUS_COUNT; bus_index++)
+    {
+        uint8_t feedback_devices = g_can_tx_stats.bus[bus_index].feedback_devices;
+        memset(&g_can_tx_stats.bus[bus_index], 0, sizeof(CAN_TX_Bus_Stats_t));
+        g_can_tx_stats.bus[bus_index].feedback_devices = feedback_devices;
+    }
+    g_can_tx_window_start = xTaskGetTickCount();
+}
+
+/**
+ * @brief Submit the identifier block carrying this motor's current before any other frame
+ * on its bus, e.g. the gimbal. Call after DJI_Motor_Init.
+ */
+void CAN_TX_Scheduler_Prioritize_Motor(DJI_Motor_Handle_t *motor_handle)
+{
+    uint8_t bus_index = motor_handle->can_bus - 1;
+    if (bus_index >= CAN_TX_BUS_COUNT)
+    {
+        return;
+    }
+    uint8_t byte_offset;
+    CAN_TX_Slot_t *slot = CAN_TX_Find_Slot(bus_index, CAN_TX_Motor_Block(motor_handle, &byte_offset));
+    if (slot != NULL)
+    {
+        slot->priority = 1;
+    }
+}
+
+/**
+ * @brief The two big endian bytes carrying this motor's current in the frame staged for the
+ * next flush, NULL when none is staged (e.g. with the scheduler disabled). Lets the motor task
+ * adjust commands after DJI_Motor_Send and before CAN_TX_Scheduler_Flush.
+ */
+uint8_t *CAN_TX_Scheduler_Staged_Motor_Data(const DJI_Motor_Handle_t *motor_handle)
+{
+    uint8_t bus_index = motor_handle->can_bus - 1;
+    if (bus_index >= CAN_TX_BUS_COUNT)
+    {
+        return NULL;
+    }
+    uint8_t byte_offset;
+    uint16_t tx_id = CAN_TX_Motor_Block(motor_handle, &byte_offset);
+    for (int i = 0; i < CAN_TX_MAX_SLOTS; i++)
+    {
+        CAN_TX_Slot_t *slot = &g_can_tx_slots[bus_index][i];
+        if (slot->used && slot->header.StdId == tx_id)
+        {
+            return slot->staged ? &slot->instance.tx_buffer[byte_offset] : NULL;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start staging frames, call before the drivers' send functions in the motor task.
+ */
+void CAN_TX_Scheduler_Begin(void)
+{
+#ifdef CAN_TX_SCHEDULER_ENABLED
+    g_can_tx_batch = 1;
+#endif
+}
+
+/**
+ * @brief Submit the staged frames that are due, priority blocks first on each bus.
+ */
+void CAN_TX_Scheduler_Flush(void)
+{
+    uint32_t tick = xTaskGetTickCount();
+    uint32_t start = Cycle_Counter_Get();
+    g_can_tx_batch = 0;
+
+    CAN_TX_Flush_Pass(1, tick);
+    uint32_t priority_latency = Cycle_Counter_Get() - start;
+    if (priority_latency > g_can_tx_stats.max_priority_latency)
+    {
+        g_can_tx_stats.max_priority_latency = priority_latency;
+    }
+    CAN_TX_Flush_Pass(0, tick);
+    g_can_tx_stats.flushes++;
+    CAN_TX_Update_Load(tick);
+}
+
+HAL_StatusTypeDef __wrap_CAN_Transmit(CAN_Instance_t *can_instance)
+{
+    uint8_t bus_index = can_instance->can_bus - 1;
+    if (bus_index >= CAN_TX_BUS_COUNT)
+    {
+        return __real_CAN_Transmit(can_instance);
+    }
+    CAN_TX_Slot_t *slot = g_can_tx_batch ? CAN_TX_Find_Slot(bus_index, can_instance->tx_header->StdId) : NULL;
+    if (slot == NULL)
+    {
+        return CAN_TX_Submit(bus_index, can_instance); // outside the motor task, or out of slots
+    }
+
+    if (slot->pending)
+    {
+        g_can_tx_stats.bus[bus_index].frames_dropped++; // superseded before it got a mailbox
+    }
+    slot->header = *can_instance->tx_header;
+    slot->instance = *can_instance;
+    slot->instance.tx_header = &slot->header;
+    slot->staged = 1;
+    return HAL_OK;
+}
+
+CAN_Instance_t *__wrap_CAN_Device_Register(uint8_t _can_bus, uint16_t _tx_id, uint16_t _rx_id,
+                                           void (*_can_module_callback)(CAN_Instance_t *can_instance))
+{
+    if (_can_bus >= 1 && _can_bus <= CAN_TX_BUS_COUNT &&
+        _rx_id >= CAN_TX_DJI_FEEDBACK_FIRST && _rx_id <= CAN_TX_DJI_FEEDBACK_LAST)
+    {
+        g_can_tx_stats.bus[_can_bus - 1].feedback_devices++;
+    }
+    return __real_CAN_Device_Register(_can_bus, _tx_id, _rx_id, _can_module_callback);
+}
@@ -0,0 +1,150 @@
+#include "chassis_odometry.h"
+
+#include <math.h>
+#include "arm_math.h"
+#include "dji_motor.h"
+#include "chassis_task.h"
+#include "input_snapshot.h"
+#include "fast_math.h"
+
+extern DJI_Motor_Handle_t *g_azimuth_motors[NUMBER_OF_MODULES];
+extern DJI_Motor_Handle_t *g_drive_motors[NUMBER_OF_MODULES];
+extern DJI_Motor_Handle_t *g_yaw;
+extern float g_kinematics_matrix_data[NUMBER_OF_MODULES * 2 * 3];
+extern arm_matrix_instance_f32 g_kinematics_matrix;
+
+Chassis_Odometry_t g_chassis_odometry = {.slip_module = CHASSIS_ODOMETRY_NO_MODULE};
+
+static Chassis_Odometry_State_t g_chassis_odometry_snapshot_buffer;
+Snapshot_t g_chassis_odometry_snapshot = SNAPSHOT_INIT(g_chassis_odometry_snapshot_buffer);
+
+// K+ = (K'K)^-1 K', 3x8, and the module velocities it is applied to
+static float g_odometry_pseudo_inverse_data[3 * NUMBER_OF_MODULES * 2];
+static float g_odometry_module_velocity_data[NUMBER_OF_MODULES * 2];
+static float g_odometry_fit_data[3];
+static arm_matrix_instance_f32 g_odometry_pseudo_inverse;
+static arm_matrix_instance_f32 g_odometry_module_velocity;
+static arm_matrix_instance_f32 g_odometry_fit;
+
+static uint8_t g_odometry_started = 0;
+static float g_odometry_heading_origin = 0.0f; // IMU derived heading at the first update
+
+/**
+ * @brief K+ from the kinematics matrix, call after Chassis_Init_Kinematics_Matrix. The
+ * temporaries only live here, the update only multiplies.
+ */
+void Chassis_Odometry_Init(void)
+{
+    float transpose_data[3 * NUMBER_OF_MODULES * 2];
+    float normal_data[3 * 3];
+    float normal_inverse_data[3 * 3];
+    arm_matrix_instance_f32 transpose, normal, normal_inverse;
+    arm_mat_init_f32(&transpose, 3, NUMBER_OF_MODULES * 2, transpose_data);
+    arm_mat_init_f32(&normal, 3, 3, normal_data);
+    arm_mat_init_f32(&normal_inverse, 3, 3, normal_inverse_data);
+    arm_mat_init_f32(&g_odometry_pseudo_inverse, 3, NUMBER_OF_MODULES * 2, g_odometry_pseudo_inverse_data);
+    arm_mat_init_f32(&g_odometry_module_velocity, NUMBER_OF_MODULES * 2, 1, g_odometry_module_velocity_data);
+    arm_mat_init_f32(&g_odometry_fit, 3, 1, g_odometry_fit_data);
+
+    arm_mat_trans_f32(&g_kinematics_matrix, &transpose);
+    arm_mat_mult_f32(&transpose, &g_kinematics_matrix, &normal);
+    arm_mat_inverse_f32(&normal, &normal_inverse); // modules not all on one point, K'K is positive definite
+    arm_mat_mult_f32(&normal_inverse, &transpose, &g_odometry_pseudo_inverse);
+}
+
+/**
+ * @brief Translation that fits the modules at yaw rate omega. The translation columns of K
+ * are one identity per module, so that is the mean of what is left of each module's velocity
+ * after its rotation part. Returns the module furthest off it.
+ */
+static uint8_t Chassis_Odometry_Refit(float omega, float *v_x, float *v_y, float *max_error)
+{
+    float sum_x = 0.0f, sum_y = 0.0f;
+    for (int i = 0; i < NUMBER_OF_MODULES; i++)
+    {
+        sum_x += g_odometry_module_velocity_data[2 * i] - g_kinematics_matrix_data[(2 * i) * 3 + 2] * omega;
+        sum_y += g_odometry_module_velocity_data[2 * i + 1] - g_kinematics_matrix_data[(2 * i + 1) * 3 + 2] * omega;
+    }
+    *v_x = sum_x / NUMBER_OF_MODULES;
+    *v_y = sum_y / NUMBER_OF_MODULES;
+
+    uint8_t worst_module = CHASSIS_ODOMETRY_NO_MODULE;
+    float worst_squared = -1.0f;
+    for (int i = 0; i < NUMBER_OF_MODULES; i++)
+    {
+        float error_x = g_odometry_module_velocity_data[2 * i] - g_kinematics_matrix_data[(2 * i) * 3 + 2] * omega - *v_x;
+        float error_y = g_odometry_module_velocity_data[2 * i + 1] - g_kinematics_matrix_data[(2 * i + 1) * 3 + 2] * omega - *v_y;
+        float error_squared = error_x * error_x + error_y * error_y;
+        if (error_squared > worst_squared)
+        {
+            worst_squared = error_squared;
+            worst_module = i;
+        }
+    }
+    arm_sqrt_f32(worst_squared, max_error);
+    return worst_module;
+}
+
+/**
+ * @brief Fit the chassis velocity to the modules, check it against the gyro, take the heading
+ * from the IMU and integrate the pose over dt. Chassis group, once the motors are initialized.
+ */
+void Chassis_Odometry_Update(float dt)
+{
+    Chassis_Odometry_t *odometry = &g_chassis_odometry;
+    Chassis_Odometry_State_t *state = &odometry->state;
+
+    // module velocities over the floor, chassis frame
+    for (int i = 0; i < NUMBER_OF_MODULES; i++)
+    {
+        float speed = DJI_Motor_Get_Velocity(g_drive_motors[i]) * (PI_F * WHEEL_DIAMETER / 60.0f); // output rpm
+        float sin_angle, cos_angle;
+        Fast_Sin_Cos(DJI_Motor_Get_Absolute_Angle(g_azimuth_motors[i]), &sin_angle, &cos_angle);
+        g_odometry_module_velocity_data[2 * i] = speed * cos_angle;
+        g_odometry_module_velocity_data[2 * i + 1] = speed * sin_angle;
+    }
+    arm_mat_mult_f32(&g_odometry_pseudo_inverse, &g_odometry_module_velocity, &g_odometry_fit);
+    odometry->fit_omega = g_odometry_fit_data[2];
+
+    // the IMU turns with the gimbal, the yaw motor measures the gimbal against the chassis
+    IMU_Attitude_t imu;
+    Snapshot_Read(&g_imu_snapshot, &imu);
+    float imu_heading = imu.yaw - DJI_Motor_Get_Absolute_Angle(g_yaw);
+    odometry->gyro_omega = imu.gyro[2] - DJI_Motor_Get_Velocity(g_yaw) * (TWO_PI_F / 60.0f);
+    if (!g_odometry_started)
+    {
+        g_odometry_heading_origin = imu_heading;
+        state->heading = 0.0f;
+        g_odometry_started = 1;
+    }
+    float heading = Angle_Difference(imu_heading, g_odometry_heading_origin);
+
+    uint8_t rotation_slip = fabsf(odometry->fit_omega - odometry->gyro_omega) > CHASSIS_ODOMETRY_SLIP_OMEGA;
+    float omega = rotation_slip ? odometry->gyro_omega : odometry->fit_omega;
+    float v_x, v_y, max_error;
+    uint8_t worst_module = Chassis_Odometry_Refit(omega, &v_x, &v_y, &max_error);
+    odometry->max_module_error = max_error;
+    state->slip = rotation_slip || max_error > CHASSIS_ODOMETRY_SLIP_SPEED;
+    odometry->slip_module = CHASSIS_ODOMETRY_NO_MODULE;
+    if (state->slip)
+    {
+        odometry->slip_module = worst_module;
+        odometry->module_slips[worst_module]++;
+        odometry->slip_cycles++;
+    }
+
+    // translate along the heading half way through the cycle
+    float sin_heading, cos_heading;
+    Fast_Sin_Cos(state->heading + 0.5f * Angle_Difference(heading, state->heading), &sin_heading, &cos_heading);
+    state->x += (cos_heading * v_x - sin_heading * v_y) * dt;
+    state->y += (sin_heading * v_x + cos_heading * v_y) * dt;
+    float speed;
+    arm_sqrt_f32(v_x * v_x + v_y * v_y, &speed);
+    odometry->distance += speed * dt;
+    state->v_x = v_x;
+    state->v_y = v_y;
+    state->omega = omega;
+    state->heading = heading;
+
+    Snapshot_Publish(&g_chassis_odometry_snapshot, state);
+}
@@ -0,0 +1,118 @@
+#include "chassis_setpoint.h"
+
+#include <math.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "arm_math.h"
+#include "chassis_task.h"
+#include "fast_math.h"
+#include "user_math.h"
+#include "rate_group.h"
+
+Chassis_Setpoint_t g_chassis_setpoint = {.step_scale = 1.0f};
+
+static uint32_t g_chassis_setpoint_last_tick = 0;
+
+/**
+ * @brief Steering a module needs between two chassis setpoints, 0 when either leaves it
+ * (nearly) stopped. A reversal flips the wheel instead of steering, hence |dot|.
+ */
+static float Chassis_Setpoint_Steering(const swerve_chassis_state_t *from, const swerve_chassis_state_t *to, int module)
+{
+    float from_x, from_y, to_x, to_y;
+    Chassis_Module_Velocity(from, module, &from_x, &from_y);
+    Chassis_Module_Velocity(to, module, &to_x, &to_y);
+    const float min_speed_squared = CHASSIS_SETPOINT_MIN_SPEED * CHASSIS_SETPOINT_MIN_SPEED;
+    if (from_x * from_x + from_y * from_y < min_speed_squared || to_x * to_x + to_y * to_y < min_speed_squared)
+    {
+        return 0.0f;
+    }
+    float cross = from_x * to_y - from_y * to_x;
+    float dot = from_x * to_x + from_y * to_y;
+    return Fast_Atan2f(fabsf(cross), fabsf(dot));
+}
+
+static uint8_t Chassis_Setpoint_Steerable(const swerve_chassis_state_t *from, const swerve_chassis_state_t *to, float max_steering)
+{
+    for (int i = 0; i < NUMBER_OF_MODULES; i++)
+    {
+        if (Chassis_Setpoint_Steering(from, to, i) > max_steering)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Move the setpoint one chassis cycle towards chassis_state and write it back there.
+ */
+void Chassis_Setpoint_Update(swerve_chassis_state_t *chassis_state, float dt)
+{
+    swerve_chassis_state_t *setpoint = &g_chassis_setpoint.setpoint;
+
+    // the chassis group only runs while enabled, start from rest after a gap
+    uint32_t tick = xTaskGetTickCount();
+    if (tick - g_chassis_setpoint_last_tick > 2 * RATE_GROUP_CHASSIS_PERIOD)
+    {
+        setpoint->v_x = 0.0f;
+        setpoint->v_y = 0.0f;
+        setpoint->omega = 0.0f;
+        g_chassis_setpoint.resets++;
+    }
+    g_chassis_setpoint_last_tick = tick;
+
+    // translation as one vector
+    float delta_x = chassis_state->v_x - setpoint->v_x;
+    float delta_y = chassis_state->v_y - setpoint->v_y;
+    float max_delta = CHASSIS_MAX_ACCEL * dt;
+    float delta_squared = delta_x * delta_x + delta_y * delta_y;
+    if (delta_squared > max_delta * max_delta)
+    {
+        float delta;
+        arm_sqrt_f32(delta_squared, &delta);
+        delta_x *= max_delta / delta;
+        delta_y *= max_delta / delta;
+    }
+    float delta_omega = chassis_state->omega - setpoint->omega;
+    float max_delta_omega = CHASSIS_MAX_ANGULAR_ACCEL * dt;
+    __MAX_LIMIT(delta_omega, -max_delta_omega, max_delta_omega);
+
+    // largest fraction of that step every module can steer to within dt
+    swerve_chassis_state_t candidate = *setpoint;
+    float max_steering = CHASSIS_AZIMUTH_MAX_RATE * dt;
+    float step_scale = 1.0f;
+    candidate.v_x = setpoint->v_x + delta_x;
+    candidate.v_y = setpoint->v_y + delta_y;
+    candidate.omega = setpoint->omega + delta_omega;
+    if (!Chassis_Setpoint_Steerable(setpoint, &candidate, max_steering))
+    {
+        float feasible = 0.0f, infeasible = 1.0f;
+        for (int i = 0; i < CHASSIS_SETPOINT_ITERATIONS; i++)
+        {
+            float scale = 0.5f * (feasible + infeasible);
+            candidate.v_x = setpoint->v_x + scale * delta_x;
+            candidate.v_y = setpoint->v_y + scale * delta_y;
+            candidate.omega = setpoint->omega + scale * delta_omega;
+            if (Chassis_Setpoint_Steerable(setpoint, &candidate, max_steering))
+            {
+                feasible = scale;
+            }
+            else
+            {
+                infeasible = scale;
+            }
+        }
+        step_scale = feasible;
+        g_chassis_setpoint.steering_limited_cycles++;
+    }
+
+    setpoint->v_x += step_scale * delta_x;
+    setpoint->v_y += step_scale * delta_y;
+    setpoint->omega += step_scale * delta_omega;
+    g_chassis_setpoint.step_scale = step_scale;
+
+    chassis_state->v_x = setpoint->v_x;
+    chassis_state->v_y = setpoint->v_y;
+    chassis_state->omega = setpoint->omega;
+}
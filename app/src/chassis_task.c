@@ -1,10 +1,24 @@
 #include "chassis_task.h"
 
+#include <string.h>
+
 #include "robot.h"
 #include "remote.h"
 #include "dji_motor.h"
 #include "motor.h"
 #include "swerve_locomotion.h"
+#include "fast_math.h"
+#include "arm_math.h"
+#include "control_sync.h"
+#include "telemetry.h"
+#include "chassis_setpoint.h"
+#include "power_limiter.h"
+#include "boost_scheduler.h"
+#include "chassis_odometry.h"
+#include "rate_group.h"
+#ifdef CHASSIS_KINEMATICS_BENCHMARK
+#include "cycle_counter.h"
+#endif
 
 extern Robot_State_t g_robot_state;
 extern Remote_t g_remote;
@@ -15,7 +29,234 @@ swerve_constants_t g_swerve_constants;
 swerve_chassis_state_t g_chassis_state;
 float measured_angles[NUMBER_OF_MODULES];
 
-float chassis_rad = WHEEL_BASE * 1.414f; //TODO init?
+#ifdef TELEMETRY_ENABLED
+static const char *g_module_telemetry_names[NUMBER_OF_MODULES][4] = {
+    {"module0_angle", "module0_speed", "module0_azimuth_current", "module0_drive_current"},
+    {"module1_angle", "module1_speed", "module1_azimuth_current", "module1_drive_current"},
+    {"module2_angle", "module2_speed", "module2_azimuth_current", "module2_drive_current"},
+    {"module3_angle", "module3_speed", "module3_azimuth_current", "module3_drive_current"},
+};
+#endif
+
+// Inverse kinematics as one matrix product: [v_x_0 v_y_0 ... v_x_3 v_y_3]' = K * [v_x v_y omega]'
+float g_kinematics_matrix_data[NUMBER_OF_MODULES * 2 * 3];
+float g_chassis_velocity_data[3];
+float g_module_velocity_data[NUMBER_OF_MODULES * 2];
+arm_matrix_instance_f32 g_kinematics_matrix;
+arm_matrix_instance_f32 g_chassis_velocity;
+arm_matrix_instance_f32 g_module_velocity;
+
+Chassis_Desaturation_t g_chassis_desaturation = {1.0f, 1.0f, 0};
+Chassis_Module_Stats_t g_chassis_module_stats = {0};
+
+#ifdef CHASSIS_MODULE_OPTIMIZATION_ENABLED
+static swerve_chassis_state_t g_solved_chassis_state; // last command solved, before optimization
+static float g_module_hold_angles[NUMBER_OF_MODULES];  // heading each module was last solved for
+#endif
+
+#ifdef CHASSIS_KINEMATICS_BENCHMARK
+#define KINEMATICS_BENCHMARK_ITERATIONS (1000)
+Kinematics_Benchmark_t g_kinematics_benchmark = {0};
+#endif
+
+/**
+ * @brief Build the 8x3 module matrix from the swerve library itself.
+ * The kinematics are linear in (v_x, v_y, omega), so probing with unit inputs gives the
+ * columns of K in exactly the module order and angle convention swerve_locomotion uses.
+ */
+static void Chassis_Init_Kinematics_Matrix(void)
+{
+    const float unit_inputs[3][3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+    for (int col = 0; col < 3; col++)
+    {
+        swerve_chassis_state_t probe = {0};
+        probe.v_x = unit_inputs[col][0];
+        probe.v_y = unit_inputs[col][1];
+        probe.omega = unit_inputs[col][2];
+        swerve_calculate_kinematics(&probe, &g_swerve_constants);
+        for (int i = 0; i < NUMBER_OF_MODULES; i++)
+        {
+            g_kinematics_matrix_data[(2 * i) * 3 + col] = probe.states[i].speed * cosf(probe.states[i].angle);
+            g_kinematics_matrix_data[(2 * i + 1) * 3 + col] = probe.states[i].speed * sinf(probe.states[i].angle);
+        }
+    }
+    arm_mat_init_f32(&g_kinematics_matrix, NUMBER_OF_MODULES * 2, 3, g_kinematics_matrix_data);
+    arm_mat_init_f32(&g_chassis_velocity, 3, 1, g_chassis_velocity_data);
+    arm_mat_init_f32(&g_module_velocity, NUMBER_OF_MODULES * 2, 1, g_module_velocity_data);
+}
+
+/**
+ * @brief Drop-in replacement for swerve_calculate_kinematics: one 8x3 matrix product for all
+ * four modules, then a polynomial atan2 and sqrt per module.
+ */
+void Chassis_Solve_Module_States(swerve_chassis_state_t *chassis_state)
+{
+    g_chassis_velocity_data[0] = chassis_state->v_x;
+    g_chassis_velocity_data[1] = chassis_state->v_y;
+    g_chassis_velocity_data[2] = chassis_state->omega;
+    arm_mat_mult_f32(&g_kinematics_matrix, &g_chassis_velocity, &g_module_velocity);
+
+    for (int i = 0; i < NUMBER_OF_MODULES; i++)
+    {
+        float module_v_x = g_module_velocity_data[2 * i];
+        float module_v_y = g_module_velocity_data[2 * i + 1];
+        arm_sqrt_f32(module_v_x * module_v_x + module_v_y * module_v_y, &chassis_state->states[i].speed);
+        chassis_state->states[i].angle = Fast_Atan2f(module_v_y, module_v_x);
+    }
+}
+
+/**
+ * @brief Velocity of one module over the floor for the chassis command, in the chassis frame.
+ */
+void Chassis_Module_Velocity(const swerve_chassis_state_t *chassis_state, int module, float *v_x, float *v_y)
+{
+    const float *row_x = &g_kinematics_matrix_data[(2 * module) * 3];
+    const float *row_y = &g_kinematics_matrix_data[(2 * module + 1) * 3];
+    *v_x = row_x[0] * chassis_state->v_x + row_x[1] * chassis_state->v_y + row_x[2] * chassis_state->omega;
+    *v_y = row_y[0] * chassis_state->v_x + row_y[1] * chassis_state->v_y + row_y[2] * chassis_state->omega;
+}
+
+/**
+ * @brief Scale the chassis command so that no wheel exceeds CHASSIS_MAX_WHEEL_SPEED.
+ * Translation is scaled first and on its own, so the direction of travel stays exact. Rotation
+ * then gets the largest scale that still fits next to it on every wheel, so spintop only uses
+ * the wheel speed the translation leaves over. For a wheel with translation velocity a and
+ * rotation velocity b that scale is the positive root of |a + s * b| = CHASSIS_MAX_WHEEL_SPEED.
+ */
+void Chassis_Desaturate(swerve_chassis_state_t *chassis_state)
+{
+    const float max_speed_squared = CHASSIS_MAX_WHEEL_SPEED * CHASSIS_MAX_WHEEL_SPEED;
+    float translation_x[NUMBER_OF_MODULES], translation_y[NUMBER_OF_MODULES];
+    float translation_max_squared = 0.0f;
+    for (int i = 0; i < NUMBER_OF_MODULES; i++)
+    {
+        const float *row_x = &g_kinematics_matrix_data[(2 * i) * 3];
+        const float *row_y = &g_kinematics_matrix_data[(2 * i + 1) * 3];
+        translation_x[i] = row_x[0] * chassis_state->v_x + row_x[1] * chassis_state->v_y;
+        translation_y[i] = row_y[0] * chassis_state->v_x + row_y[1] * chassis_state->v_y;
+        float speed_squared = translation_x[i] * translation_x[i] + translation_y[i] * translation_y[i];
+        translation_max_squared = speed_squared > translation_max_squared ? speed_squared : translation_max_squared;
+    }
+
+    float translation_scale = 1.0f;
+    if (translation_max_squared > max_speed_squared)
+    {
+        float translation_max;
+        arm_sqrt_f32(translation_max_squared, &translation_max);
+        translation_scale = CHASSIS_MAX_WHEEL_SPEED / translation_max;
+    }
+
+    float rotation_scale = 1.0f;
+    for (int i = 0; i < NUMBER_OF_MODULES; i++)
+    {
+        float a_x = translation_x[i] * translation_scale;
+        float a_y = translation_y[i] * translation_scale;
+        float b_x = g_kinematics_matrix_data[(2 * i) * 3 + 2] * chassis_state->omega;
+        float b_y = g_kinematics_matrix_data[(2 * i + 1) * 3 + 2] * chassis_state->omega;
+        float b_b = b_x * b_x + b_y * b_y;
+        float a_b = a_x * b_x + a_y * b_y;
+        float a_a = a_x * a_x + a_y * a_y;
+        if (b_b < 1e-9f || a_a + 2.0f * a_b + b_b <= max_speed_squared)
+        {
+            continue; // full rotation fits on this wheel
+        }
+        float discriminant = a_b * a_b - b_b * (a_a - max_speed_squared); // >= 0 since |a| <= max
+        float root;
+        arm_sqrt_f32(discriminant > 0.0f ? discriminant : 0.0f, &root);
+        float scale = (root - a_b) / b_b;
+        rotation_scale = scale < rotation_scale ? scale : rotation_scale;
+    }
+    if (rotation_scale < 0.0f)
+    {
+        rotation_scale = 0.0f;
+    }
+
+    chassis_state->v_x *= translation_scale;
+    chassis_state->v_y *= translation_scale;
+    chassis_state->omega *= rotation_scale;
+    g_chassis_desaturation.translation_scale = translation_scale;
+    g_chassis_desaturation.rotation_scale = rotation_scale;
+    if (translation_scale < 1.0f || rotation_scale < 1.0f)
+    {
+        g_chassis_desaturation.saturated_cycles++;
+    }
+}
+
+#ifdef CHASSIS_MODULE_OPTIMIZATION_ENABLED
+/**
+ * @brief Chassis_Solve_Module_States, unless the command is bit for bit the one solved last
+ * cycle, then the module states solved for it are reused.
+ */
+static void Chassis_Solve_Changed_Module_States(swerve_chassis_state_t *chassis_state)
+{
+    if (chassis_state->v_x == g_solved_chassis_state.v_x && chassis_state->v_y == g_solved_chassis_state.v_y &&
+        chassis_state->omega == g_solved_chassis_state.omega)
+    {
+        memcpy(chassis_state->states, g_solved_chassis_state.states, sizeof(chassis_state->states));
+        g_chassis_module_stats.skipped_solves++;
+        return;
+    }
+    Chassis_Solve_Module_States(chassis_state);
+    g_solved_chassis_state = *chassis_state;
+}
+
+/**
+ * @brief Hold slow modules, flip modules more than 90 degrees off (swerve_optimize_module_angles),
+ * then scale each drive speed by the cosine of its remaining azimuth error.
+ */
+void Chassis_Optimize_Module_States(swerve_chassis_state_t *chassis_state, float measured_angles[])
+{
+    for (int i = 0; i < NUMBER_OF_MODULES; i++)
+    {
+        // hold the heading before the flip and only drive the part of the slow motion along it,
+        // negative when the command already turned past 90 degrees, e.g. through a reversal
+        if (chassis_state->states[i].speed < CHASSIS_MODULE_HOLD_SPEED)
+        {
+            float sin_turn, cos_turn;
+            Fast_Sin_Cos(chassis_state->states[i].angle - g_module_hold_angles[i], &sin_turn, &cos_turn);
+            chassis_state->states[i].speed *= cos_turn;
+            chassis_state->states[i].angle = g_module_hold_angles[i];
+            g_chassis_module_stats.held_modules++;
+        }
+        g_module_hold_angles[i] = chassis_state->states[i].angle;
+    }
+    swerve_optimize_module_angles(chassis_state, measured_angles);
+    for (int i = 0; i < NUMBER_OF_MODULES; i++)
+    {
+        float sin_error, cos_error;
+        Fast_Sin_Cos(chassis_state->states[i].angle - measured_angles[i], &sin_error, &cos_error);
+        chassis_state->states[i].speed *= cos_error > 0.0f ? cos_error : 0.0f;
+    }
+}
+#endif
+
+#ifdef CHASSIS_KINEMATICS_BENCHMARK
+static void Chassis_Kinematics_Benchmark(void)
+{
+    swerve_chassis_state_t state = {0};
+    Cycle_Counter_Init();
+
+    uint32_t start = Cycle_Counter_Get();
+    for (int n = 0; n < KINEMATICS_BENCHMARK_ITERATIONS; n++)
+    {
+        state.v_x = 0.001f * n;
+        state.v_y = 0.5f - 0.001f * n;
+        state.omega = 1.0f;
+        swerve_calculate_kinematics(&state, &g_swerve_constants);
+    }
+    g_kinematics_benchmark.scalar_cycles = (Cycle_Counter_Get() - start) / KINEMATICS_BENCHMARK_ITERATIONS;
+
+    start = Cycle_Counter_Get();
+    for (int n = 0; n < KINEMATICS_BENCHMARK_ITERATIONS; n++)
+    {
+        state.v_x = 0.001f * n;
+        state.v_y = 0.5f - 0.001f * n;
+        state.omega = 1.0f;
+        Chassis_Solve_Module_States(&state);
+    }
+    g_kinematics_benchmark.matrix_cycles = (Cycle_Counter_Get() - start) / KINEMATICS_BENCHMARK_ITERATIONS;
+}
+#endif
 
 void Chassis_Task_Init()
 {
@@ -84,10 +325,36 @@ void Chassis_Task_Init()
         drive_motor_config.speed_controller_id = module_configs[i].drive_speed_controller_id;
         drive_motor_config.motor_reversal = module_configs[i].drive_motor_reversal;
         g_drive_motors[i] = DJI_Motor_Init(&drive_motor_config, M3508);
+
+        Control_Sync_Register_Feedback(g_azimuth_motors[i]);
+        Control_Sync_Register_Feedback(g_drive_motors[i]);
+#ifdef POWER_LIMITER_ENABLED
+        Power_Limiter_Register_Motor(g_azimuth_motors[i], module_configs[i].azimuth_motor_reversal, 0);
+        Power_Limiter_Register_Motor(g_drive_motors[i], module_configs[i].drive_motor_reversal, 1);
+#endif
+
+#ifdef TELEMETRY_ENABLED
+        TELEMETRY_REGISTER(g_module_telemetry_names[i][0], &g_chassis_state.states[i].angle);
+        TELEMETRY_REGISTER(g_module_telemetry_names[i][1], &g_chassis_state.states[i].speed);
+        TELEMETRY_REGISTER(g_module_telemetry_names[i][2], &g_azimuth_motors[i]->stats->current_torq);
+        TELEMETRY_REGISTER(g_module_telemetry_names[i][3], &g_drive_motors[i]->stats->current_torq);
+#endif
     }
 
     // Initialize the swerve locomotion constants
     g_swerve_constants = swerve_init(TRACK_WIDTH, WHEEL_BASE, WHEEL_DIAMETER, SWERVE_MAX_SPEED, SWERVE_MAX_ANGLUAR_SPEED);
+    Chassis_Init_Kinematics_Matrix();
+#ifdef CHASSIS_ODOMETRY_ENABLED
+    Chassis_Odometry_Init();
+#endif
+#ifdef TELEMETRY_ENABLED
+    TELEMETRY_REGISTER("translation_scale", &g_chassis_desaturation.translation_scale);
+    TELEMETRY_REGISTER("rotation_scale", &g_chassis_desaturation.rotation_scale);
+#endif
+
+#ifdef CHASSIS_KINEMATICS_BENCHMARK
+    Chassis_Kinematics_Benchmark();
+#endif
 }
 
 void Chassis_Ctrl_Loop()
@@ -96,8 +363,15 @@ void Chassis_Ctrl_Loop()
     for (int i = 0; i < NUMBER_OF_MODULES; i++) {
         measured_angles[i] = DJI_Motor_Get_Absolute_Angle(g_azimuth_motors[i]);
     }
-    g_chassis_state.v_x = g_robot_state.chassis.x_speed * SWERVE_MAX_SPEED;
-    g_chassis_state.v_y = g_robot_state.chassis.y_speed * SWERVE_MAX_SPEED;
+    float max_speed = SWERVE_MAX_SPEED;
+    float spin_top_omega = SPIN_TOP_OMEGA;
+#ifdef BOOST_SCHEDULER_ENABLED
+    Boost_Scheduler_Update(RATE_GROUP_CHASSIS_PERIOD);
+    max_speed *= g_boost_scheduler.speed_scale;
+    spin_top_omega *= g_boost_scheduler.omega_scale;
+#endif
+    g_chassis_state.v_x = g_robot_state.chassis.x_speed * max_speed;
+    g_chassis_state.v_y = g_robot_state.chassis.y_speed * max_speed;
 
     // Offset chassis orientation based on gimbal direction
     // Note: commented because currently handled in process remote input
@@ -107,16 +381,23 @@ void Chassis_Ctrl_Loop()
 
     // If spintop enabled, chassis omega set to spintop value
     if (g_robot_state.chassis.IS_SPINTOP_ENABLED) {
-        //g_chassis_state.omega = Rescale_Chassis_Velocity();
-        g_chassis_state.omega = SPIN_TOP_OMEGA;
+        g_chassis_state.omega = spin_top_omega;
     } else {
         g_chassis_state.omega = g_robot_state.chassis.omega * SWERVE_MAX_ANGLUAR_SPEED;
     }
 
-    // Calculate the kinematics of the chassis
-    swerve_calculate_kinematics(&g_chassis_state, &g_swerve_constants);
+    // Calculate the kinematics of the chassis, within what the wheels can do
+    Chassis_Desaturate(&g_chassis_state);
+#ifdef CHASSIS_SETPOINT_ENABLED
+    Chassis_Setpoint_Update(&g_chassis_state, RATE_GROUP_CHASSIS_PERIOD * 0.001f);
+#endif
+#ifdef CHASSIS_MODULE_OPTIMIZATION_ENABLED
+    Chassis_Solve_Changed_Module_States(&g_chassis_state);
+    Chassis_Optimize_Module_States(&g_chassis_state, measured_angles);
+#else
+    Chassis_Solve_Module_States(&g_chassis_state);
     swerve_optimize_module_angles(&g_chassis_state, measured_angles);
-    //swerve_desaturate_wheel_speeds(&g_chassis_state, &g_swerve_constants);
+#endif
     swerve_convert_to_rpm(&g_chassis_state, &g_swerve_constants);
 
     for (int i = 0; i < NUMBER_OF_MODULES; i++) {
@@ -124,15 +405,3 @@ void Chassis_Ctrl_Loop()
         DJI_Motor_Set_Velocity(g_drive_motors[i], g_chassis_state.states[i].speed);
     }
 }
-
-/*
- * scale spintop omega by inverse of translation speed to prioritize translation
- * spin_coeff = rw/(v + rw) // r = rad, w = desired omega (spin top omega), v = translational speed
- * chassis_omega *= spin_coeff
- */
-float Rescale_Chassis_Velocity(void) {
-    float translation_speed = sqrtf(powf(g_robot_state.chassis.x_speed, 2) + powf(g_robot_state.chassis.y_speed, 2));
-    float spin_coeff = chassis_rad * SPIN_TOP_OMEGA / (translation_speed + chassis_rad * SPIN_TOP_OMEGA);
-    float target_omega = SPIN_TOP_OMEGA * spin_coeff;
-    return target_omega;
-}
@@ -0,0 +1,78 @@
+#include "cobs_frame.h"
+
+// CRC-16/CCITT-FALSE, nibble table keeps flash small at two lookups per byte
+uint16_t COBS_Frame_CRC16(const uint8_t *data, uint16_t length)
+{
+    static const uint16_t nibble_table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        crc = (uint16_t)(crc << 4) ^ nibble_table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ nibble_table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+/**
+ * @brief COBS encode so the only zero byte on the wire is the trailing frame delimiter.
+ * @return encoded length including the delimiter
+ */
+uint16_t COBS_Frame_Encode(const uint8_t *src, uint16_t length, uint8_t *dst)
+{
+    uint16_t code_index = 0;
+    uint16_t write_index = 1;
+    uint8_t code = 1;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if (src[i] == 0)
+        {
+            dst[code_index] = code;
+            code = 1;
+            code_index = write_index++;
+            continue;
+        }
+        dst[write_index++] = src[i];
+        code++;
+        if (code == 0xFF)
+        {
+            dst[code_index] = code;
+            code = 1;
+            code_index = write_index++;
+        }
+    }
+    dst[code_index] = code;
+    dst[write_index++] = 0;
+    return write_index;
+}
+
+/**
+ * @brief Decode one frame without its delimiter. dst may be src, the output never gets ahead
+ * of the input, so a frame can be decoded where it was received.
+ * @return decoded length, 0 for a malformed frame
+ */
+uint16_t COBS_Frame_Decode(const uint8_t *src, uint16_t length, uint8_t *dst)
+{
+    uint16_t read_index = 0;
+    uint16_t write_index = 0;
+    while (read_index < length)
+    {
+        uint8_t code = src[read_index];
+        if (code == 0 || read_index + code > length)
+        {
+            return 0;
+        }
+        read_index++;
+        for (uint8_t i = 1; i < code; i++)
+        {
+            dst[write_index++] = src[read_index++];
+        }
+        if (code < 0xFF && read_index < length)
+        {
+            dst[write_index++] = 0;
+        }
+    }
+    return write_index;
+}
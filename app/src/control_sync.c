@@ -0,0 +1,169 @@
+#include "control_sync.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_os.h"
+#include "cycle_counter.h"
+#include "rate_group.h"
+
+extern osThreadId motor_task_handle;
+
+Control_Sync_Stats_t g_control_sync_stats = {0};
+
+typedef struct
+{
+    CAN_Instance_t *can_instance;
+    void (*device_callback)(CAN_Instance_t *can_instance);
+} Control_Sync_Feedback_t;
+
+static Control_Sync_Feedback_t g_feedback_sources[CONTROL_SYNC_MAX_MOTORS];
+static uint8_t g_feedback_source_count = 0;
+static uint32_t g_expected_mask = 0;
+static volatile uint32_t g_received_mask = 0;
+static volatile uint32_t g_last_feedback_cycles = 0;
+static volatile uint8_t g_feedback_pending = 0;
+static uint8_t g_missed_sets[CONTROL_SYNC_MAX_MOTORS]; // in a row, per source
+
+void Control_Sync_Init(void)
+{
+    Cycle_Counter_Init();
+    g_control_sync_stats.min_latency = UINT32_MAX;
+}
+
+/**
+ * @brief Close the feedback set and release whoever waits on it. A set closed with expected
+ * motors missing counts them, and drops the ones missing CONTROL_SYNC_MISSING_SETS in a row.
+ */
+static void Control_Sync_Complete_Set(void)
+{
+    uint32_t missing = g_expected_mask & ~g_received_mask;
+    if (missing != 0)
+    {
+        g_control_sync_stats.incomplete_sets++;
+        for (int i = 0; i < g_feedback_source_count; i++)
+        {
+            if (!(missing & (1U << i)))
+            {
+                continue;
+            }
+            g_control_sync_stats.missed_frames++;
+            if (++g_missed_sets[i] >= CONTROL_SYNC_MISSING_SETS)
+            {
+                g_expected_mask &= ~(1U << i);
+                g_control_sync_stats.missing_mask |= (1U << i);
+            }
+        }
+    }
+
+    g_received_mask = 0;
+    g_last_feedback_cycles = Cycle_Counter_Get();
+    g_feedback_pending = 1;
+    g_control_sync_stats.feedback_sets++;
+
+#ifdef EVENT_DRIVEN_CONTROL
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    Rate_Group_Release_From_ISR(g_control_sync_stats.feedback_sets, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+#endif
+}
+
+/**
+ * @brief Called from the CAN RX interrupt in place of the motor's own callback.
+ * The motor callback runs first so the feedback is decoded before anyone is woken.
+ */
+static void Control_Sync_Feedback_Callback(CAN_Instance_t *can_instance)
+{
+    for (int i = 0; i < g_feedback_source_count; i++)
+    {
+        if (g_feedback_sources[i].can_instance != can_instance)
+        {
+            continue;
+        }
+        g_feedback_sources[i].device_callback(can_instance);
+        uint32_t source = 1U << i;
+        if (g_received_mask & source)
+        {
+            // a feedback period since its last frame and the set is still open, someone is missing
+            Control_Sync_Complete_Set();
+        }
+        if (!(g_expected_mask & source))
+        {
+            g_expected_mask |= source; // reporting again
+            g_control_sync_stats.missing_mask &= ~source;
+        }
+        g_missed_sets[i] = 0;
+        g_received_mask |= source;
+        break;
+    }
+
+    if (g_received_mask == g_expected_mask)
+    {
+        Control_Sync_Complete_Set(); // every expected motor has reported since the last set
+    }
+}
+
+/**
+ * @brief Insert the sync hook in front of a motor's CAN RX callback. Call after DJI_Motor_Init.
+ */
+void Control_Sync_Register_Feedback(DJI_Motor_Handle_t *motor_handle)
+{
+    if (g_feedback_source_count >= CONTROL_SYNC_MAX_MOTORS)
+    {
+        return;
+    }
+    CAN_Instance_t *can_instance = motor_handle->can_instance;
+    g_feedback_sources[g_feedback_source_count].can_instance = can_instance;
+    g_feedback_sources[g_feedback_source_count].device_callback = can_instance->can_module_callback;
+    g_expected_mask |= (1U << g_feedback_source_count);
+    g_feedback_source_count++;
+    can_instance->can_module_callback = Control_Sync_Feedback_Callback;
+}
+
+void Control_Sync_Command_Done(void)
+{
+    xTaskNotifyGive(motor_task_handle);
+}
+
+void Control_Sync_Wait_For_Command(void)
+{
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONTROL_SYNC_MOTOR_TIMEOUT_MS)) == 0)
+    {
+        g_control_sync_stats.motor_timeouts++;
+    }
+}
+
+/**
+ * @brief Record sensor-to-actuator latency, call right after the motor frames are queued.
+ * Works in both modes so polling and event driven latency can be compared.
+ */
+void Control_Sync_Transmit_Done(void)
+{
+    if (!g_feedback_pending)
+    {
+        return; // no new feedback since the last transmit
+    }
+    g_feedback_pending = 0;
+
+    uint32_t latency = Cycle_Counter_Get() - g_last_feedback_cycles;
+    g_control_sync_stats.last_latency = latency;
+    g_control_sync_stats.total_latency += latency;
+    g_control_sync_stats.transmits++;
+    if (latency < g_control_sync_stats.min_latency)
+    {
+        g_control_sync_stats.min_latency = latency;
+    }
+    if (latency > g_control_sync_stats.max_latency)
+    {
+        g_control_sync_stats.max_latency = latency;
+    }
+}
+
+float Control_Sync_Get_Average_Latency_Us(void)
+{
+    if (g_control_sync_stats.transmits == 0)
+    {
+        return 0.0f;
+    }
+    float average_cycles = (float)g_control_sync_stats.total_latency / (float)g_control_sync_stats.transmits;
+    return average_cycles * 1000000.0f / (float)CYCLE_COUNTER_HZ;
+}
@@ -1,5 +1,9 @@
 #include "debug_task.h"
 
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
 #include "bsp_serial.h"
 #include "remote.h"
 #include "user_math.h"
@@ -9,6 +13,12 @@
 #include "jetson_orin.h"
 #include "bsp_daemon.h"
 #include "launch_task.h"
+#include "control_sync.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "static_pool.h"
+#include "boot.h"
+#include "boost_scheduler.h"
 
 extern Robot_State_t g_robot_state;
 extern IMU_t g_imu;
@@ -27,9 +37,164 @@ const char *bottom_border = "/***** End of Info *****/\r\n";
 
 #define DEBUG_ENABLED
 
+#ifdef TELEMETRY_ENABLED
+// huart6 carries the telemetry stream, so text goes out as log frames
+#define DEBUG_LOG(...) Telemetry_Log(__VA_ARGS__)
+#else
+#define DEBUG_LOG(...) Debug_Print_Line(__VA_ARGS__)
+
+static uint8_t Debug_Print_Line(const char *format, ...)
+{
+    char line[96];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    DEBUG_PRINTF(&huart6, "%s", line);
+    return 1;
+}
+#endif
+
+/**
+ * @brief Boot trace and RAM budget once start up has finished, one line per debug period.
+ * Per task stack headroom comes from `make ram_report` at build time.
+ */
+static void Debug_Report_Boot(void)
+{
+    static uint8_t line = 0;
+    if (g_robot_state.state == STARTING_UP || line > g_boot_report.stage_count + 1)
+    {
+        return;
+    }
+
+    uint8_t sent;
+    if (line < g_boot_report.stage_count)
+    {
+        Boot_Trace_t *trace = &g_boot_report.stages[line];
+        sent = DEBUG_LOG("boot: %s at %lu us took %lu us\r\n", trace->name,
+                         (unsigned long)trace->start_us, (unsigned long)trace->duration_us);
+    }
+    else if (line == g_boot_report.stage_count)
+    {
+        sent = DEBUG_LOG("boot: ready at %lu us\r\n", (unsigned long)g_boot_report.ready_us);
+    }
+    else
+    {
+        sent = DEBUG_LOG("ram: pool %lu/%u bytes in %lu blocks, %lu late, heap %u free (min %u)\r\n",
+                         (unsigned long)g_static_pool_stats.used, (unsigned int)STATIC_POOL_SIZE,
+                         (unsigned long)g_static_pool_stats.allocations,
+                         (unsigned long)g_static_pool_stats.late_allocations,
+                         (unsigned int)xPortGetFreeHeapSize(), (unsigned int)xPortGetMinimumEverFreeHeapSize());
+    }
+    if (sent)
+    {
+        line++;
+    }
+}
+
+#ifdef BOOST_SCHEDULER_ENABLED
+static uint32_t g_boost_reported_matches = 0;
+static uint8_t g_boost_report_line = 0;
+
+/**
+ * @brief How the last match spent the supercap's energy, two lines once the robot is
+ * disabled, when the chassis group has stopped adding to the totals.
+ */
+static void Debug_Report_Boost(void)
+{
+    if (g_robot_state.state != DISABLED || g_boost_reported_matches == g_boost_scheduler.matches)
+    {
+        return;
+    }
+
+    const Boost_Match_t *match = &g_boost_scheduler.match;
+    uint8_t sent;
+    if (g_boost_report_line == 0)
+    {
+        sent = DEBUG_LOG("boost: match %lu, %lu ms, boosted %lu ms, tapering %lu ms, cap empty %lu ms\r\n",
+                         (unsigned long)g_boost_scheduler.matches, (unsigned long)match->duration_ms,
+                         (unsigned long)match->boost_ms, (unsigned long)match->taper_ms,
+                         (unsigned long)match->empty_ms);
+    }
+    else
+    {
+        sent = DEBUG_LOG("boost: spent %lu J translating, %lu J spinning, recharged %lu J, min %lu %%\r\n",
+                         (unsigned long)match->spent_translation, (unsigned long)match->spent_spintop,
+                         (unsigned long)match->recharged, (unsigned long)match->min_percent);
+    }
+    if (sent && ++g_boost_report_line == 2)
+    {
+        g_boost_report_line = 0;
+        g_boost_reported_matches = g_boost_scheduler.matches;
+    }
+}
+#endif
+
+#ifdef PROFILER_ENABLED
+#define PROFILER_REPORT_IDLE (-2)
+#define PROFILER_REPORT_HEADER (-1)
+static int8_t g_profiler_report_line = PROFILER_REPORT_IDLE;
+
+/**
+ * @brief Stream the profiler summary one line per debug period once requested,
+ * so a report never blocks the debug task for more than a line.
+ */
+static void Debug_Stream_Profiler_Report(void)
+{
+    if (g_profiler_report_line == PROFILER_REPORT_IDLE)
+    {
+        if (!g_profiler_report_requested)
+        {
+            return;
+        }
+        g_profiler_report_requested = 0;
+        g_profiler_report_line = PROFILER_REPORT_HEADER;
+    }
+
+    uint8_t sent;
+    if (g_profiler_report_line == PROFILER_REPORT_HEADER)
+    {
+        sent = DEBUG_LOG("%s", "profiler (us): section count min p50 p99 max deadline_misses\r\n");
+    }
+    else if (g_profiler_report_line < PROFILE_SECTION_COUNT)
+    {
+        Profile_Section_e index = (Profile_Section_e)g_profiler_report_line;
+        Profiler_Section_t *section = &g_profiler_sections[index];
+        sent = DEBUG_LOG("%s %lu %lu %lu %lu %lu %lu\r\n", section->name,
+                         (unsigned long)section->count,
+                         (unsigned long)(section->count ? Profiler_Cycles_To_Us(section->min) : 0),
+                         (unsigned long)Profiler_Cycles_To_Us(Profiler_Get_Percentile(index, 50.0f)),
+                         (unsigned long)Profiler_Cycles_To_Us(Profiler_Get_Percentile(index, 99.0f)),
+                         (unsigned long)Profiler_Cycles_To_Us(section->max),
+                         (unsigned long)section->deadline_misses);
+    }
+    else
+    {
+        sent = DEBUG_LOG("%s", bottom_border);
+        if (sent)
+        {
+            g_profiler_report_line = PROFILER_REPORT_IDLE;
+        }
+        return;
+    }
+
+    if (sent)
+    {
+        g_profiler_report_line++;
+    }
+}
+#endif
+
 void Debug_Task_Loop(void)
 {
 #ifdef DEBUG_ENABLED
+    Debug_Report_Boot();
+#ifdef BOOST_SCHEDULER_ENABLED
+    Debug_Report_Boost();
+#endif
+#ifdef PROFILER_ENABLED
+    Debug_Stream_Profiler_Report();
+#endif
 // static uint32_t counter = 0;
 #ifdef PRINT_RUNTIME_STATS
     if (counter % 100 == 0) // Print every 100 cycles
@@ -44,6 +209,7 @@ void Debug_Task_Loop(void)
     //  DEBUG_PRINTF(&huart6, ">time:%.1f\n>yaw:%f\n>pitch:%f\n>roll:%f\n", (float) counter / 1000.0f * DEBUG_PERIOD,
     //              g_imu.deg.yaw, g_imu.deg.pitch, g_imu.deg.roll);
     //  DEBUG_PRINTF(&huart6, ">remote_daemon:%d\n", g_remote_daemon->counter);
+    //  DEBUG_PRINTF(&huart6, ">latency_us:%f\n>latency_max:%lu\n", Control_Sync_Get_Average_Latency_Us(), g_control_sync_stats.max_latency);
     //  counter++;
     //  if (counter > 0xFFFFFFFF) {
     //      counter = 0;
@@ -0,0 +1,62 @@
+#include "fast_math.h"
+
+#include <math.h>
+#include <stdint.h>
+#include "arm_math.h"
+
+float Fast_Atan2f(float y, float x)
+{
+    float abs_x = fabsf(x);
+    float abs_y = fabsf(y);
+    float max_xy = abs_x > abs_y ? abs_x : abs_y;
+    float min_xy = abs_x > abs_y ? abs_y : abs_x;
+    if (max_xy == 0.0f)
+    {
+        return 0.0f;
+    }
+
+    // atan(z) on [0, 1]
+    float z = min_xy / max_xy;
+    float z2 = z * z;
+    float result = z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f + z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+
+    // unfold octant and quadrant
+    if (abs_y > abs_x)
+    {
+        result = HALF_PI_F - result;
+    }
+    if (x < 0.0f)
+    {
+        result = PI_F - result;
+    }
+    if (y < 0.0f)
+    {
+        result = -result;
+    }
+    return result;
+}
+
+void Fast_Sin_Cos(float angle, float *sin_out, float *cos_out)
+{
+    *sin_out = arm_sin_f32(angle);
+    *cos_out = arm_cos_f32(angle);
+}
+
+float Wrap_Angle(float angle)
+{
+    return angle - TWO_PI_F * (float)(int32_t)(angle / TWO_PI_F);
+}
+
+float Angle_Difference(float to, float from)
+{
+    float difference = Wrap_Angle(to - from);
+    if (difference > PI_F)
+    {
+        difference -= TWO_PI_F;
+    }
+    else if (difference < -PI_F)
+    {
+        difference += TWO_PI_F;
+    }
+    return difference;
+}
@@ -1,18 +1,43 @@
 #include "gimbal_task.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
 #include "robot.h"
 #include "remote.h"
 #include "user_math.h"
+#include "fast_math.h"
 #include "dji_motor.h"
 #include "imu_task.h"
 #include "jetson_orin.h"
+#include "control_sync.h"
+#include "can_tx_scheduler.h"
+#include "input_snapshot.h"
+#include "chassis_setpoint.h"
+#include "imu_history.h"
+#include "aim_tracker.h"
+#include "rate_group.h"
+
+// rad per gimbal group call the auto aim setpoint may move, 0.2 rad per 2 ms call as tuned
+#define GIMBAL_AIM_SLEW_STEP (0.2f * RATE_GROUP_GIMBAL_PERIOD / RATE_GROUP_TUNED_PERIOD)
 
 extern Robot_State_t g_robot_state;
 extern Remote_t g_remote;
 extern IMU_t g_imu;
 extern Jetson_Orin_Data_t g_orin_data;
+extern swerve_chassis_state_t g_chassis_state;
 
 DJI_Motor_Handle_t *g_yaw, *g_pitch;
+Input_Snapshot_t g_gimbal_inputs = {0}; // gimbal group view, sampled fresh every cycle
+Gimbal_Yaw_Feedforward_t g_gimbal_yaw_feedforward = {0};
+
+// the reader (the gimbal group) outranks the writer (the command group), a seqlock read would
+// spin forever on a publish it preempted, so the slot it copies is never the one being written
+static Gimbal_Command_t g_gimbal_command[2];
+static volatile uint8_t g_gimbal_command_index = 0;
+
+#ifdef AIM_TRACKER_ENABLED
+static uint32_t g_gimbal_aim_sequence = 0; // last aim offset taken
+#endif
 
 void Gimbal_Task_Init()
 {
@@ -70,26 +95,118 @@ void Gimbal_Task_Init()
 
     g_yaw = DJI_Motor_Init(&yaw_motor_config, GM6020);
     g_pitch = DJI_Motor_Init(&pitch_motor_config, GM6020);
+
+    Control_Sync_Register_Feedback(g_yaw);
+    Control_Sync_Register_Feedback(g_pitch);
+
+    CAN_TX_Scheduler_Prioritize_Motor(g_yaw);
+    CAN_TX_Scheduler_Prioritize_Motor(g_pitch);
+}
+
+/**
+ * @brief World attitude the aim offset points at, the offset added to the gimbal attitude at
+ * its capture tick.
+ */
+static void Gimbal_Aim_Target(const Aim_Command_t *aim, float *yaw, float *pitch)
+{
+    float base_yaw = g_gimbal_inputs.imu.yaw;
+    float base_pitch = g_gimbal_inputs.imu.pitch;
+#ifdef AIM_LATENCY_COMPENSATION_ENABLED
+    IMU_History_Lookup(aim->capture_tick, &base_yaw, &base_pitch);
+#endif
+    *yaw = base_yaw + aim->yaw * DEG_TO_RAD_F;
+    *pitch = base_pitch + aim->pitch * DEG_TO_RAD_F;
+}
+
+/**
+ * @brief Operator's rates for the gimbal group, from a lower priority task.
+ */
+void Gimbal_Set_Command(const Gimbal_Command_t *command)
+{
+    uint8_t index = g_gimbal_command_index ^ 1;
+    g_gimbal_command[index] = *command;
+    __atomic_store_n(&g_gimbal_command_index, index, __ATOMIC_RELEASE);
 }
 
 void Gimbal_Ctrl_Loop()
 {
+    // operator input, the command group only publishes rates so this is the setpoint's only writer
+    Gimbal_Command_t command = g_gimbal_command[__atomic_load_n(&g_gimbal_command_index, __ATOMIC_ACQUIRE)];
+    g_robot_state.gimbal.yaw_angle += command.yaw_rate * (RATE_GROUP_GIMBAL_PERIOD * 0.001f);
+    g_robot_state.gimbal.pitch_angle += command.pitch_rate * (RATE_GROUP_GIMBAL_PERIOD * 0.001f);
 
     if (g_robot_state.launch.IS_AUTO_AIMING_ENABLED) {
-        if (g_orin_data.receiving.auto_aiming.yaw != 0 || g_orin_data.receiving.auto_aiming.pitch != 0)
+        const Aim_Command_t *aim = &g_gimbal_inputs.aim;
+        float target_yaw, target_pitch;
+#ifdef AIM_TRACKER_ENABLED
+        if (aim->sequence != g_gimbal_aim_sequence)
         {
-            float imu_yaw_delta = g_imu.rad.yaw + g_orin_data.receiving.auto_aiming.yaw / 180.0f * PI;
-            float imu_pitch_delta = g_imu.rad.pitch + g_orin_data.receiving.auto_aiming.pitch / 180.0f * PI;
-            __SLEW_RATE_LIMIT(g_robot_state.gimbal.yaw_angle, imu_yaw_delta, 0.2);
-            __SLEW_RATE_LIMIT(g_robot_state.gimbal.pitch_angle, imu_pitch_delta, 0.2);
+            g_gimbal_aim_sequence = aim->sequence;
+            if (aim->target_valid)
+            {
+                Gimbal_Aim_Target(aim, &target_yaw, &target_pitch);
+                Aim_Tracker_Measure(aim->capture_tick, target_yaw, target_pitch);
+            }
+            else
+            {
+                Aim_Tracker_Drop();
+            }
+        }
+        uint8_t target_valid = Aim_Tracker_Predict(xTaskGetTickCount(), &target_yaw, &target_pitch);
+#else
+        uint8_t target_valid = aim->target_valid;
+        if (target_valid)
+        {
+            Gimbal_Aim_Target(aim, &target_yaw, &target_pitch);
+        }
+#endif
+        if (target_valid)
+        {
+            __SLEW_RATE_LIMIT(g_robot_state.gimbal.yaw_angle, target_yaw, GIMBAL_AIM_SLEW_STEP);
+            __SLEW_RATE_LIMIT(g_robot_state.gimbal.pitch_angle, target_pitch, GIMBAL_AIM_SLEW_STEP);
         }
     }
 
     // hardware limits for gimbal pitch (prevent self collision)
-    g_robot_state.gimbal.yaw_angle = fmod(g_robot_state.gimbal.yaw_angle, 2 * PI);
+    g_robot_state.gimbal.yaw_angle = Wrap_Angle(g_robot_state.gimbal.yaw_angle);
     __MAX_LIMIT(g_robot_state.gimbal.pitch_angle, -0.4f, 0.4f);
 
     // Control loop for gimbal
     DJI_Motor_Set_Angle(g_pitch, g_robot_state.gimbal.pitch_angle);
     DJI_Motor_Set_Angle(g_yaw, g_robot_state.gimbal.yaw_angle);
 }
+
+#ifdef GIMBAL_YAW_FEEDFORWARD_ENABLED
+/**
+ * @brief Add the back-EMF of the chassis rotation to the yaw command just staged, call between
+ * DJI_Motor_Send and CAN_TX_Scheduler_Flush. The yaw motor is mounted normal, so the staged
+ * command is in the motor's own direction.
+ */
+void Gimbal_Yaw_Feedforward_Apply(void)
+{
+    float chassis_omega = 0.0f;
+    if (g_robot_state.state == ENABLED)
+    {
+#if defined(GIMBAL_YAW_FEEDFORWARD_MEASURED)
+        chassis_omega = g_imu.bmi088_raw.gyro[2] - DJI_Motor_Get_Velocity(g_yaw) * (TWO_PI_F / 60.0f);
+#elif defined(CHASSIS_SETPOINT_ENABLED)
+        chassis_omega = g_chassis_setpoint.setpoint.omega;
+#else
+        chassis_omega = g_chassis_state.omega;
+#endif
+    }
+    uint8_t *data = CAN_TX_Scheduler_Staged_Motor_Data(g_yaw);
+    float command = -GIMBAL_YAW_FEEDFORWARD_GAIN * chassis_omega;
+    g_gimbal_yaw_feedforward.chassis_omega = chassis_omega;
+    g_gimbal_yaw_feedforward.command = command;
+    if (data == NULL || command == 0.0f)
+    {
+        return;
+    }
+    float output = (int16_t)((data[0] << 8) | data[1]) + command;
+    __MAX_LIMIT(output, -GM6020_MAX_CURRENT, GM6020_MAX_CURRENT);
+    int16_t value = (int16_t)output;
+    data[0] = (uint16_t)value >> 8;
+    data[1] = value & 0xFF;
+}
+#endif
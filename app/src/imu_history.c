@@ -0,0 +1,53 @@
+#include "imu_history.h"
+
+#include <stddef.h>
+#include "fast_math.h"
+
+IMU_History_Stats_t g_imu_history_stats = {0};
+
+static IMU_History_Sample_t g_imu_history[IMU_HISTORY_LENGTH];
+static uint32_t g_imu_history_count = 0; // samples pushed, the newest is at count - 1
+
+void IMU_History_Push(uint32_t tick, float yaw, float pitch)
+{
+    IMU_History_Sample_t *sample = &g_imu_history[g_imu_history_count % IMU_HISTORY_LENGTH];
+    sample->tick = tick;
+    sample->yaw = yaw;
+    sample->pitch = pitch;
+    g_imu_history_count++;
+}
+
+/**
+ * @brief Attitude at tick, interpolated between the samples around it (yaw the short way round).
+ * @return 1 if tick is inside the history, 0 and the attitude untouched otherwise
+ */
+uint8_t IMU_History_Lookup(uint32_t tick, float *yaw, float *pitch)
+{
+    g_imu_history_stats.lookups++;
+    uint32_t available = g_imu_history_count < IMU_HISTORY_LENGTH ? g_imu_history_count : IMU_HISTORY_LENGTH;
+    const IMU_History_Sample_t *newer = NULL;
+    // newest first, a lookup is a camera latency back, a few dozen samples at most
+    for (uint32_t i = 1; i <= available; i++)
+    {
+        const IMU_History_Sample_t *sample = &g_imu_history[(g_imu_history_count - i) % IMU_HISTORY_LENGTH];
+        if ((int32_t)(tick - sample->tick) >= 0)
+        {
+            if (newer == NULL)
+            {
+                // newer than the history, only an exact hit on the newest sample counts
+                if (tick != sample->tick)
+                {
+                    break;
+                }
+                newer = sample;
+            }
+            float fraction = newer->tick == sample->tick ? 0.0f : (float)(tick - sample->tick) / (float)(newer->tick - sample->tick);
+            *yaw = Wrap_Angle(sample->yaw + fraction * Angle_Difference(newer->yaw, sample->yaw));
+            *pitch = sample->pitch + fraction * (newer->pitch - sample->pitch);
+            return 1;
+        }
+        newer = sample;
+    }
+    g_imu_history_stats.misses++;
+    return 0;
+}
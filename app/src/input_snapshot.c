@@ -0,0 +1,79 @@
+#include "input_snapshot.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "imu_task.h"
+#include "jetson_orin.h"
+#include "orin_link.h"
+
+extern IMU_t g_imu;
+extern Remote_t g_remote;
+extern Jetson_Orin_Data_t g_orin_data;
+
+Input_Snapshot_t g_inputs = {0};
+
+static IMU_Attitude_t g_imu_snapshot_buffer;
+static Remote_t g_remote_snapshot_buffer;
+static Aim_Command_t g_aim_snapshot_buffer;
+Snapshot_t g_imu_snapshot = SNAPSHOT_INIT(g_imu_snapshot_buffer);
+Snapshot_t g_remote_snapshot = SNAPSHOT_INIT(g_remote_snapshot_buffer);
+Snapshot_t g_aim_snapshot = SNAPSHOT_INIT(g_aim_snapshot_buffer);
+
+/**
+ * @brief Sample the raw globals into inputs and publish them for the other rate groups.
+ * Called by the fastest group only. g_remote and g_orin_data are written by UART ISRs and
+ * g_imu by the highest priority task, so a matching double copy is a coherent one.
+ */
+void Input_Snapshot_Update(Input_Snapshot_t *inputs)
+{
+    __typeof__(g_imu.rad) attitude;
+    __typeof__(g_imu.bmi088_raw.gyro) gyro;
+    inputs->sample_retries += SNAPSHOT_SAMPLE(attitude, g_imu.rad);
+    inputs->sample_retries += SNAPSHOT_SAMPLE(gyro, g_imu.bmi088_raw.gyro);
+    inputs->imu.yaw = attitude.yaw;
+    inputs->imu.pitch = attitude.pitch;
+    inputs->imu.roll = attitude.roll;
+    for (int i = 0; i < 3; i++)
+    {
+        inputs->imu.gyro[i] = gyro[i];
+    }
+
+    inputs->sample_retries += SNAPSHOT_SAMPLE(inputs->remote, g_remote);
+
+#ifdef ORIN_LINK_ENABLED
+    Orin_Link_Aim_t link_aim;
+    Orin_Link_Get_Aim(&link_aim);
+    inputs->aim.yaw = link_aim.yaw;
+    inputs->aim.pitch = link_aim.pitch;
+    inputs->aim.capture_tick = link_aim.capture_tick;
+    inputs->aim.sequence = link_aim.sequence;
+    inputs->aim.target_valid = link_aim.target_valid;
+#else
+    __typeof__(g_orin_data.receiving.auto_aiming) auto_aiming;
+    inputs->sample_retries += SNAPSHOT_SAMPLE(auto_aiming, g_orin_data.receiving.auto_aiming);
+    if (auto_aiming.yaw != inputs->aim.yaw || auto_aiming.pitch != inputs->aim.pitch)
+    {
+        // a new offset, dated back to the exposure it was computed from
+        inputs->aim.capture_tick = xTaskGetTickCount() - AIM_CAPTURE_LATENCY;
+        inputs->aim.sequence++;
+        // the packet has no target flag, the Orin sends a zero offset when it sees nothing
+        inputs->aim.target_valid = auto_aiming.yaw != 0 || auto_aiming.pitch != 0;
+    }
+    inputs->aim.yaw = auto_aiming.yaw;
+    inputs->aim.pitch = auto_aiming.pitch;
+#endif
+
+    Snapshot_Publish(&g_imu_snapshot, &inputs->imu);
+    Snapshot_Publish(&g_remote_snapshot, &inputs->remote);
+    Snapshot_Publish(&g_aim_snapshot, &inputs->aim);
+}
+
+/**
+ * @brief Copy the latest published inputs, each part coherent, at the start of a group's cycle.
+ */
+void Input_Snapshot_Take(Input_Snapshot_t *inputs)
+{
+    Snapshot_Read(&g_imu_snapshot, &inputs->imu);
+    Snapshot_Read(&g_remote_snapshot, &inputs->remote);
+    Snapshot_Read(&g_aim_snapshot, &inputs->aim);
+}
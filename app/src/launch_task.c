@@ -7,12 +7,26 @@
 #include "referee_system.h"
 #include "laser.h"
 #include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
 
 extern Robot_State_t g_robot_state;
 extern Remote_t g_remote;
 
 DJI_Motor_Handle_t *g_flywheel_left, *g_flywheel_right, *g_feed_motor;
 
+Feed_Stats_t g_feed_stats;
+static uint32_t g_shot_start_tick = 0;   // shot commanded, or the last pocket in full auto
+static float g_next_pocket_angle = 0;    // rad, full auto counts a shot each time the feeder passes it
+static uint8_t g_shot_rejiggling = 0;    // single fire shot waiting on its rejiggle to be counted
+#ifdef FEED_JAM_DETECTION_ENABLED
+static uint32_t g_feed_moving_tick = 0;  // last tick the feeder was not stalled
+static uint32_t g_jam_reverse_tick = 0;
+static uint8_t g_jam_retries = 0;        // of the shot in progress
+static Fire_Mode_e g_jam_retry_mode = IDLE;
+static uint8_t g_jam_latched = 0;        // gave up on a jam, no firing until the trigger is let go
+#endif
+
 void Launch_Task_Init()
 {
     // Init Launch Hardware
@@ -90,7 +104,11 @@ void Launch_Ctrl_Loop()
         switch (g_robot_state.launch.busy_mode)
         {
         case REJIGGLE:
+#ifdef FEED_JAM_DETECTION_ENABLED
+            clearJam();
+#else
             rejiggle();
+#endif
             break;
         case SINGLE_FIRE:
             handleSingleFire();
@@ -104,6 +122,14 @@ void Launch_Ctrl_Loop()
             break;
         }
     } else {
+#ifdef FEED_JAM_DETECTION_ENABLED
+        if (g_jam_latched) { // do not grind into the jam again, wait for NO_FIRE
+            if (g_robot_state.launch.fire_mode != NO_FIRE) {
+                return;
+            }
+            g_jam_latched = 0;
+        }
+#endif
         // Control loop for launch to see if new mode is set
         switch (g_robot_state.launch.fire_mode)
         {
@@ -132,6 +158,39 @@ void resetRelPos() {
 #define ticksToRad(ticks) ((ticks) * 360.0f / DJI_MAX_TICKS)
 #define degreesToTicks(degrees) ((degrees) * DJI_MAX_TICKS / 360.0f)
 float g_curr_angle = 0;
+
+static void recordShot(uint32_t cycle_ms) {
+    g_feed_stats.shots++;
+    g_feed_stats.last_cycle_ms = cycle_ms;
+    g_feed_stats.total_cycle_ms += cycle_ms;
+    g_feed_stats.average_cycle_ms = (float)g_feed_stats.total_cycle_ms / g_feed_stats.shots;
+}
+
+#ifdef FEED_JAM_DETECTION_ENABLED
+/**
+ * @brief Call only while the feeder is commanded to move, 1 once it has been stalled for FEED_JAM_TIME
+ */
+static uint8_t isFeedStalled() {
+    uint32_t tick = xTaskGetTickCount();
+    if (abs(g_feed_motor->stats->current_torq) < FEED_JAM_CURRENT ||
+        fabsf(DJI_Motor_Get_Velocity(g_feed_motor)) > FEED_JAM_SPEED) {
+        g_feed_moving_tick = tick;
+        return 0;
+    }
+    return tick - g_feed_moving_tick >= FEED_JAM_TIME;
+}
+
+static void reverseJam(Fire_Mode_e retry_mode) {
+    g_feed_stats.jams++;
+    g_jam_retry_mode = retry_mode;
+    g_jam_reverse_tick = xTaskGetTickCount();
+    g_robot_state.launch.IS_BUSY = 1;
+    g_robot_state.launch.busy_mode = REJIGGLE;
+    DJI_Motor_Set_Control_Mode(g_feed_motor, POSITION_CONTROL_TOTAL_ANGLE);
+    DJI_Motor_Set_Angle(g_feed_motor, DJI_Motor_Get_Total_Angle(g_feed_motor) - FEED_JAM_REVERSE_RAD);
+}
+#endif
+
 // TODO check if at ref
 void handleSingleFire() {
     if (g_robot_state.launch.IS_BUSY) {
@@ -139,14 +198,29 @@ void handleSingleFire() {
         {
             g_robot_state.launch.IS_BUSY = 0;
             g_robot_state.launch.busy_mode = IDLE;
+#ifdef FEED_JAM_DETECTION_ENABLED
+            g_jam_retries = 0;
+            recordShot(xTaskGetTickCount() - g_shot_start_tick);
+#else
+            g_shot_rejiggling = 1;
             rejiggle();
+#endif
         }
+#ifdef FEED_JAM_DETECTION_ENABLED
+        else if (isFeedStalled()) {
+            reverseJam(SINGLE_FIRE);
+        }
+#endif
     }
     else {
         g_robot_state.launch.IS_BUSY = 1;
         g_robot_state.launch.busy_mode = SINGLE_FIRE;
         // set a new position reference x degrees forward
         resetRelPos();
+        g_shot_start_tick = xTaskGetTickCount();
+#ifdef FEED_JAM_DETECTION_ENABLED
+        g_feed_moving_tick = g_shot_start_tick;
+#endif
 
         DJI_Motor_Set_Control_Mode(g_feed_motor, POSITION_CONTROL_TOTAL_ANGLE);
         g_curr_angle = DJI_Motor_Get_Total_Angle(g_feed_motor); // rad
@@ -166,6 +240,10 @@ void rejiggle() {
             g_robot_state.launch.IS_BUSY = 0;
             DJI_Motor_Set_Control_Mode(g_feed_motor, POSITION_CONTROL_TOTAL_ANGLE);
             DJI_Motor_Set_Angle(g_feed_motor, curr_angle_rad + SHOT_ANGLE_OFFSET_RAD);
+            if (g_shot_rejiggling) {
+                g_shot_rejiggling = 0;
+                recordShot(xTaskGetTickCount() - g_shot_start_tick);
+            }
         }
     }
     else {
@@ -176,6 +254,41 @@ void rejiggle() {
     }
 }
 
+#ifdef FEED_JAM_DETECTION_ENABLED
+void clearJam() {
+    uint32_t tick = xTaskGetTickCount();
+    if (!DJI_Motor_Is_At_Angle(g_feed_motor, FEED_TOLERANCE) && tick - g_jam_reverse_tick < FEED_JAM_REVERSE_TIME) {
+        return; // still backing off
+    }
+
+    if (g_jam_retries >= FEED_JAM_MAX_RETRIES) { // give up on it, hold here until the trigger is let go
+        g_feed_stats.abandoned++;
+        g_jam_retries = 0;
+        g_jam_latched = 1;
+        DJI_Motor_Set_Angle(g_feed_motor, DJI_Motor_Get_Total_Angle(g_feed_motor));
+        g_robot_state.launch.IS_BUSY = 0;
+        g_robot_state.launch.busy_mode = IDLE;
+        return;
+    }
+
+    g_jam_retries++;
+    g_feed_stats.retries++;
+    g_feed_moving_tick = tick;
+    if (g_jam_retry_mode == SINGLE_FIRE) {
+        g_robot_state.launch.busy_mode = SINGLE_FIRE;
+        DJI_Motor_Set_Angle(g_feed_motor, g_curr_angle + SHOT_ANGLE_OFFSET_RAD);
+    } else if (g_robot_state.launch.fire_mode == FULL_AUTO) {
+        g_robot_state.launch.busy_mode = FULL_AUTO;
+        DJI_Motor_Set_Control_Mode(g_feed_motor, VELOCITY_CONTROL);
+        DJI_Motor_Set_Velocity(g_feed_motor, FEED_RATE);
+    } else { // released while backing off
+        g_jam_retries = 0;
+        g_robot_state.launch.IS_BUSY = 0;
+        g_robot_state.launch.busy_mode = IDLE;
+    }
+}
+#endif
+
 void handleFullAuto() {
     if (g_robot_state.launch.IS_BUSY) {
         if (g_robot_state.launch.fire_mode == NO_FIRE) {
@@ -183,13 +296,37 @@ void handleFullAuto() {
             DJI_Motor_Set_Velocity(g_feed_motor, 0);
             g_robot_state.launch.IS_BUSY = 0;
             g_robot_state.launch.busy_mode = IDLE;
+#ifdef FEED_JAM_DETECTION_ENABLED
+            g_jam_retries = 0;
+#else
             rejiggle();
+#endif
+            return;
+        }
+        uint32_t tick = xTaskGetTickCount();
+        while (DJI_Motor_Get_Total_Angle(g_feed_motor) >= g_next_pocket_angle) {
+            recordShot(tick - g_shot_start_tick);
+            g_shot_start_tick = tick;
+            g_next_pocket_angle += SHOT_ANGLE_OFFSET_RAD;
+#ifdef FEED_JAM_DETECTION_ENABLED
+            g_jam_retries = 0;
+#endif
+        }
+#ifdef FEED_JAM_DETECTION_ENABLED
+        if (isFeedStalled()) {
+            reverseJam(FULL_AUTO);
         }
+#endif
     } else {
         DJI_Motor_Set_Control_Mode(g_feed_motor, VELOCITY_CONTROL);
         DJI_Motor_Set_Velocity(g_feed_motor, FEED_RATE);
         g_robot_state.launch.IS_BUSY = 1;
         g_robot_state.launch.busy_mode = FULL_AUTO;
+        g_shot_start_tick = xTaskGetTickCount();
+#ifdef FEED_JAM_DETECTION_ENABLED
+        g_feed_moving_tick = g_shot_start_tick;
+#endif
+        g_next_pocket_angle = DJI_Motor_Get_Total_Angle(g_feed_motor) + SHOT_ANGLE_OFFSET_RAD;
     }
 }
 
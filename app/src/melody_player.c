@@ -0,0 +1,70 @@
+#include "melody_player.h"
+
+#include "cmsis_os.h"
+#include "tim.h"
+
+static osTimerId g_melody_timer = NULL;
+static Melody_t g_melody;
+static uint16_t g_melody_note_index = 0;
+static volatile uint8_t g_melody_playing = 0;
+
+static void Melody_Player_Set_Tone(uint16_t frequency, float loudness)
+{
+    if (frequency == 0)
+    {
+        __HAL_TIM_SET_COMPARE(&MELODY_PLAYER_TIMER, MELODY_PLAYER_CHANNEL, 0);
+        return;
+    }
+    // APB1 timers run at twice PCLK1 while the APB1 prescaler is not 1
+    uint32_t timer_hz = HAL_RCC_GetPCLK1Freq() * 2U / (MELODY_PLAYER_TIMER.Instance->PSC + 1U);
+    uint32_t period = timer_hz / frequency;
+    __HAL_TIM_SET_AUTORELOAD(&MELODY_PLAYER_TIMER, period - 1U);
+    // 50% duty is the loudest square wave, loudness scales it down
+    __HAL_TIM_SET_COMPARE(&MELODY_PLAYER_TIMER, MELODY_PLAYER_CHANNEL, (uint32_t)((float)period * 0.5f * loudness));
+}
+
+/**
+ * @brief Timer callback at each note boundary, sounds the next note and rearms for its duration.
+ */
+static void Melody_Player_Next_Note(void const *argument)
+{
+    (void)argument;
+    if (g_melody_note_index >= g_melody.note_num)
+    {
+        Melody_Player_Set_Tone(0, 0.0f);
+        g_melody_playing = 0;
+        return;
+    }
+    const Note_t *note = &g_melody.notes[g_melody_note_index++];
+    Melody_Player_Set_Tone(note->note, g_melody.loudness);
+    osTimerStart(g_melody_timer, note->duration > 0 ? note->duration : 1);
+}
+
+osTimerDef(melody_timer, Melody_Player_Next_Note);
+
+void Melody_Player_Init(void)
+{
+    g_melody_timer = osTimerCreate(osTimer(melody_timer), osTimerOnce, NULL);
+}
+
+/**
+ * @brief Start a melody and return immediately, replacing any melody still playing.
+ * Safe before the scheduler starts, the first note sounds now and the rest once it runs.
+ */
+void Melody_Player_Start(Melody_t melody)
+{
+    if (g_melody_timer == NULL)
+    {
+        return;
+    }
+    osTimerStop(g_melody_timer);
+    g_melody = melody;
+    g_melody_note_index = 0;
+    g_melody_playing = 1;
+    Melody_Player_Next_Note(NULL);
+}
+
+uint8_t Melody_Player_Is_Playing(void)
+{
+    return g_melody_playing;
+}
@@ -3,13 +3,29 @@
 // #include "dm_motor.h"
 // #include "mf_motor.h"
 #include "supercap.h"
+#include "control_sync.h"
+#include "can_tx_scheduler.h"
+#include "profiler.h"
+#include "power_limiter.h"
+#include "gimbal_task.h"
 
 extern Supercap_t g_supercap;
 
 void Motor_Task_Loop() {
+    PROFILE_BEGIN(PROFILE_MOTOR);
+    CAN_TX_Scheduler_Begin();
     DJI_Motor_Send();
+#ifdef POWER_LIMITER_ENABLED
+    Power_Limiter_Apply(); // on the chassis currents just staged
+#endif
+#ifdef GIMBAL_YAW_FEEDFORWARD_ENABLED
+    Gimbal_Yaw_Feedforward_Apply();
+#endif
     // MF_Motor_Send();
     // DM_Motor_Send();
     Supercap_Send();
+    CAN_TX_Scheduler_Flush();
+    Control_Sync_Transmit_Done();
+    PROFILE_END(PROFILE_MOTOR);
 }
 
@@ -0,0 +1,419 @@
+#include "orin_link.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "usart.h"
+#include "cobs_frame.h"
+#include "cycle_counter.h"
+#include "input_snapshot.h"
+#include "snapshot.h"
+#include "swerve_locomotion.h"
+#include "chassis_odometry.h"
+
+#define ORIN_LINK_HEADER_SIZE (7) // type, sequence, tick
+#define ORIN_LINK_CRC_SIZE (2)
+#define ORIN_LINK_MAX_ENCODED_SIZE (COBS_FRAME_ENCODED_SIZE(ORIN_LINK_MAX_FRAME_SIZE) - 1) // without the delimiter
+#define ORIN_LINK_RX_MASK (ORIN_LINK_RX_BUFFER_SIZE - 1)
+#define ORIN_LINK_RATE_PERIOD (1000) // ms the byte rates are taken over
+#define ORIN_LINK_WIRE_SIZE(body) COBS_FRAME_ENCODED_SIZE(ORIN_LINK_HEADER_SIZE + (body) + ORIN_LINK_CRC_SIZE)
+// what the link puts on huart6, budgeted by the telemetry stream as TELEMETRY_SEND_BYTE_RATE
+#define ORIN_LINK_TX_BYTE_RATE (ORIN_LINK_WIRE_SIZE(sizeof(Orin_Link_State_Frame_t)) * 1000 / ORIN_LINK_STATE_PERIOD + \
+                                ORIN_LINK_WIRE_SIZE(sizeof(Orin_Link_Sync_Request_Frame_t)) * 1000 / ORIN_LINK_SYNC_PERIOD)
+// us a sync answer takes to cross the line, its delimiter arrives this long after the Orin's t3
+#define ORIN_LINK_SYNC_RESPONSE_WIRE_US \
+    (ORIN_LINK_WIRE_SIZE(sizeof(Orin_Link_Sync_Response_Frame_t)) * 10U * 1000000U / TELEMETRY_BAUD_RATE)
+
+_Static_assert((ORIN_LINK_RX_BUFFER_SIZE & ORIN_LINK_RX_MASK) == 0, "ORIN_LINK_RX_BUFFER_SIZE must be a power of two");
+_Static_assert(ORIN_LINK_MAX_ENCODED_SIZE < ORIN_LINK_RX_BUFFER_SIZE / 2, "a frame must fit half the receive buffer");
+_Static_assert(sizeof(Orin_Link_State_Frame_t) <= TELEMETRY_MAX_SEND_LENGTH, "state frame does not fit Telemetry_Send");
+_Static_assert(ORIN_LINK_TX_BYTE_RATE <= TELEMETRY_SEND_BYTE_RATE, "the link outgrows its share of huart6, see TELEMETRY_SEND_BYTE_RATE");
+
+extern swerve_chassis_state_t g_chassis_state;
+
+Orin_Link_Stats_t g_orin_link_stats = {0};
+
+static uint8_t g_orin_link_started = 0;
+
+// the cycle counter extended to 64 bits, it wraps every 25 s on the board and is read every link period
+static uint64_t g_orin_link_clock_cycles = 0;
+static uint32_t g_orin_link_clock_last = 0;
+// us at this and the last parse, frames parsed now arrived in between
+static uint64_t g_orin_link_parse_us = 0;
+static uint64_t g_orin_link_last_parse_us = 0;
+
+// written by the DMA in a circle, bytes up to its position are parsed by the link task
+static uint8_t g_orin_link_rx[ORIN_LINK_RX_BUFFER_SIZE];
+static uint16_t g_orin_link_rx_position = 0; // DMA write index at the last parse
+static uint32_t g_orin_link_rx_count = 0;    // bytes received, free running
+static uint32_t g_orin_link_rx_frame = 0;    // byte count where the frame being received starts
+static uint8_t g_orin_link_rx_straddling[ORIN_LINK_MAX_ENCODED_SIZE];
+static uint16_t g_orin_link_rx_sequence = 0;
+static uint8_t g_orin_link_rx_synced = 0; // a frame was received, its sequence is the reference
+
+// the reader (the gimbal group) outranks the link task, so the slot it copies is never being written
+static Orin_Link_Aim_t g_orin_link_aim[2];
+static volatile uint8_t g_orin_link_aim_index = 0;
+
+static uint64_t g_orin_link_sync_t1 = 0; // us, MCU clock the request awaiting an answer was made at, its tag
+static uint8_t g_orin_link_sync_pending = 0;
+static uint32_t g_orin_link_sync_samples = 0; // accepted exchanges the filter has seen
+
+static uint32_t g_orin_link_state_tick = 0;
+static uint32_t g_orin_link_sync_tick = 0;
+static uint32_t g_orin_link_rate_tick = 0;
+static uint32_t g_orin_link_rate_tx_bytes = 0;
+static uint32_t g_orin_link_rate_rx_bytes = 0;
+
+static void Orin_Link_Take_Aim(const uint8_t *body, uint32_t tick)
+{
+    Orin_Link_Aim_Frame_t frame;
+    memcpy(&frame, body, sizeof(frame));
+    uint8_t index = g_orin_link_aim_index ^ 1;
+    Orin_Link_Aim_t *aim = &g_orin_link_aim[index];
+    aim->yaw = frame.yaw;
+    aim->pitch = frame.pitch;
+    aim->target_valid = (frame.flags & ORIN_LINK_AIM_TARGET_VALID) != 0;
+    aim->arrival_tick = tick;
+    aim->capture_tick = tick - frame.age_ms;
+    aim->sequence = g_orin_link_aim[g_orin_link_aim_index].sequence + 1;
+    __atomic_store_n(&g_orin_link_aim_index, index, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Orin_Link_Time_Us at cycle counter value cycles, which is at most a wrap before now.
+ */
+static uint64_t Orin_Link_Cycles_To_Us(uint32_t cycles)
+{
+    uint64_t now = Orin_Link_Time_Us();
+    return now - (uint32_t)(g_orin_link_clock_last - cycles) / (CYCLE_COUNTER_HZ / 1000000U);
+}
+
+/**
+ * @brief One two-way exchange whose answer arrived between the parses at earliest and latest.
+ * t1 is when the request's delimiter left the line, not when it was queued behind the telemetry
+ * ring, and t4 the middle of the two parses less the answer's time on the line, so both legs are
+ * the latency past the last byte. The round trip is taken to latest, so it is never short. The
+ * first exchange sets the offset, then the gains start at those of a least squares line through
+ * the exchanges so far and settle at ORIN_LINK_SYNC_ALPHA and ORIN_LINK_SYNC_BETA.
+ */
+static void Orin_Link_Take_Sync(const uint8_t *body, uint64_t earliest, uint64_t latest)
+{
+    Orin_Link_Sync_Response_Frame_t response;
+    memcpy(&response, body, sizeof(response));
+    Orin_Link_Sync_t *sync = &g_orin_link_stats.sync;
+    sync->exchanges++;
+    uint32_t sent_cycles;
+    if (!g_orin_link_sync_pending || response.t1 != (uint32_t)g_orin_link_sync_t1 ||
+        !Telemetry_Get_Timed_Cycles(&sent_cycles))
+    {
+        sync->rejected++;
+        return;
+    }
+    g_orin_link_sync_pending = 0;
+
+    uint64_t t1 = Orin_Link_Cycles_To_Us(sent_cycles);
+    uint64_t t4 = earliest + (latest - earliest) / 2 - ORIN_LINK_SYNC_RESPONSE_WIRE_US;
+    int64_t round_trip = (int64_t)(latest - ORIN_LINK_SYNC_RESPONSE_WIRE_US - t1) - (int64_t)(response.t3 - response.t2);
+    if (round_trip < 0 || round_trip > UINT32_MAX)
+    {
+        sync->rejected++; // the Orin took longer than the whole exchange
+        return;
+    }
+    if (sync->accepted == 0 || round_trip <= sync->min_round_trip_us)
+    {
+        sync->min_round_trip_us = (uint32_t)round_trip;
+    }
+    else
+    {
+        sync->min_round_trip_us += ORIN_LINK_SYNC_ROUND_TRIP_AGING;
+    }
+    if (round_trip > sync->min_round_trip_us + ORIN_LINK_SYNC_ROUND_TRIP_MARGIN)
+    {
+        sync->rejected++;
+        return;
+    }
+    sync->accepted++;
+    sync->round_trip_us = (uint32_t)round_trip;
+
+    int64_t measured = ((int64_t)(response.t2 - t1) + (int64_t)(response.t3 - t4)) / 2;
+    uint64_t reference = t1 + (uint64_t)((int64_t)(t4 - t1) / 2); // middle of the exchange, t4 may be before t1
+    float elapsed = (float)(int64_t)(reference - sync->reference_us);
+    int64_t predicted = sync->offset_us + (int64_t)(sync->drift * elapsed);
+    if (sync->synced && (measured - predicted > ORIN_LINK_SYNC_STEP || predicted - measured > ORIN_LINK_SYNC_STEP))
+    {
+        sync->steps++; // the Orin's clock was set, start over from this exchange
+        sync->synced = 0;
+    }
+    if (!sync->synced)
+    {
+        sync->offset_us = measured;
+        sync->reference_us = reference;
+        sync->drift = 0.0f;
+        sync->residual_us = 0.0f;
+        g_orin_link_sync_samples = 1;
+        sync->synced = 1;
+        return;
+    }
+
+    float residual = (float)(measured - predicted);
+    float n = (float)++g_orin_link_sync_samples;
+    float alpha = 2.0f * (2.0f * n - 1.0f) / (n * (n + 1.0f));
+    float beta = 6.0f / (n * (n + 1.0f));
+    alpha = alpha > ORIN_LINK_SYNC_ALPHA ? alpha : ORIN_LINK_SYNC_ALPHA;
+    beta = beta > ORIN_LINK_SYNC_BETA ? beta : ORIN_LINK_SYNC_BETA;
+    sync->offset_us = predicted + (int64_t)(alpha * residual);
+    if (elapsed > 0.0f)
+    {
+        sync->drift += beta * residual / elapsed;
+    }
+    sync->drift_ppm = sync->drift * 1e6f;
+    sync->residual_us = residual;
+    sync->reference_us = reference;
+}
+
+/**
+ * @brief Check and dispatch one decoded frame.
+ */
+static void Orin_Link_Take_Frame(const uint8_t *frame, uint16_t length, uint32_t tick)
+{
+    if (length < ORIN_LINK_HEADER_SIZE + ORIN_LINK_CRC_SIZE)
+    {
+        g_orin_link_stats.rx.dropped++;
+        return;
+    }
+    length -= ORIN_LINK_CRC_SIZE;
+    uint16_t crc = (uint16_t)(frame[length] | (frame[length + 1] << 8));
+    if (COBS_Frame_CRC16(frame, length) != crc)
+    {
+        g_orin_link_stats.rx.dropped++;
+        return;
+    }
+
+    uint16_t sequence;
+    memcpy(&sequence, &frame[1], sizeof(sequence));
+    if (g_orin_link_rx_synced)
+    {
+        g_orin_link_stats.rx.lost += (uint16_t)(sequence - g_orin_link_rx_sequence - 1);
+    }
+    g_orin_link_rx_sequence = sequence;
+    g_orin_link_rx_synced = 1;
+    g_orin_link_stats.rx.frames++;
+    g_orin_link_stats.last_rx_tick = tick;
+
+    const uint8_t *body = &frame[ORIN_LINK_HEADER_SIZE];
+    uint16_t body_length = length - ORIN_LINK_HEADER_SIZE;
+    if (frame[0] == ORIN_LINK_FRAME_AIM && body_length == sizeof(Orin_Link_Aim_Frame_t))
+    {
+        Orin_Link_Take_Aim(body, tick);
+    }
+    else if (frame[0] == ORIN_LINK_FRAME_SYNC_RESPONSE && body_length == sizeof(Orin_Link_Sync_Response_Frame_t))
+    {
+        Orin_Link_Take_Sync(body, g_orin_link_last_parse_us, g_orin_link_parse_us);
+    }
+    else
+    {
+        g_orin_link_stats.rx_unknown++;
+    }
+}
+
+/**
+ * @brief Decode the frame that ends before the delimiter at byte count end, in place unless it
+ * straddles the end of the buffer.
+ */
+static void Orin_Link_Parse_Frame(uint32_t end, uint32_t tick)
+{
+    uint32_t length = end - g_orin_link_rx_frame;
+    if (length == 0)
+    {
+        return;
+    }
+    if (length > ORIN_LINK_MAX_ENCODED_SIZE)
+    {
+        g_orin_link_stats.rx.dropped++;
+        return;
+    }
+    uint32_t start = g_orin_link_rx_frame & ORIN_LINK_RX_MASK;
+    uint8_t *frame = &g_orin_link_rx[start];
+    if (start + length > ORIN_LINK_RX_BUFFER_SIZE)
+    {
+        uint32_t first = ORIN_LINK_RX_BUFFER_SIZE - start;
+        memcpy(g_orin_link_rx_straddling, frame, first);
+        memcpy(&g_orin_link_rx_straddling[first], g_orin_link_rx, length - first);
+        frame = g_orin_link_rx_straddling;
+    }
+    uint16_t decoded = COBS_Frame_Decode(frame, (uint16_t)length, frame);
+    if (decoded == 0)
+    {
+        g_orin_link_stats.rx.dropped++;
+        return;
+    }
+    Orin_Link_Take_Frame(frame, decoded, tick);
+}
+
+/**
+ * @brief Parse what the DMA wrote since the last call. More than the buffer in one link period
+ * is not detected, ORIN_LINK_RX_BUFFER_SIZE covers several periods at the link's baud rate.
+ */
+static void Orin_Link_Receive(uint32_t tick)
+{
+    uint16_t position = (uint16_t)((ORIN_LINK_RX_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(huart6.hdmarx)) & ORIN_LINK_RX_MASK);
+    uint32_t received = (position - g_orin_link_rx_position) & ORIN_LINK_RX_MASK;
+    g_orin_link_rx_position = position;
+    g_orin_link_stats.rx.bytes += received;
+    for (uint32_t i = 0; i < received; i++)
+    {
+        uint32_t count = g_orin_link_rx_count++;
+        if (g_orin_link_rx[count & ORIN_LINK_RX_MASK] == 0)
+        {
+            Orin_Link_Parse_Frame(count, tick);
+            g_orin_link_rx_frame = count + 1;
+        }
+    }
+}
+
+static uint8_t Orin_Link_Send(uint8_t type, const void *body, uint16_t length, uint8_t timed)
+{
+    if (!(timed ? Telemetry_Send_Timed(type, body, length) : Telemetry_Send(type, body, length)))
+    {
+        g_orin_link_stats.tx.dropped++;
+        return 0;
+    }
+    g_orin_link_stats.tx.frames++;
+    g_orin_link_stats.tx.bytes += ORIN_LINK_WIRE_SIZE(length);
+    return 1;
+}
+
+static int16_t Orin_Link_Fixed(float value, float scale)
+{
+    float fixed = value * scale;
+    if (fixed > 32767.0f)
+    {
+        return 32767;
+    }
+    if (fixed < -32767.0f)
+    {
+        return -32767;
+    }
+    return (int16_t)lroundf(fixed);
+}
+
+static void Orin_Link_Send_State(void)
+{
+    IMU_Attitude_t imu;
+    Snapshot_Read(&g_imu_snapshot, &imu);
+#ifdef CHASSIS_ODOMETRY_ENABLED
+    Chassis_Odometry_State_t chassis;
+    Snapshot_Read(&g_chassis_odometry_snapshot, &chassis);
+#else
+    swerve_chassis_state_t chassis;
+    SNAPSHOT_SAMPLE(chassis, g_chassis_state); // the chassis group outranks the link task
+#endif
+
+    uint64_t now = Orin_Link_Time_Us();
+    Orin_Link_State_Frame_t state = {
+        .time_us = (uint32_t)(g_orin_link_stats.sync.synced ? Orin_Link_To_Orin_Time(now) : now),
+        .attitude = {
+            Orin_Link_Fixed(imu.yaw, ORIN_LINK_ANGLE_SCALE),
+            Orin_Link_Fixed(imu.pitch, ORIN_LINK_ANGLE_SCALE),
+            Orin_Link_Fixed(imu.roll, ORIN_LINK_ANGLE_SCALE),
+        },
+        .gyro = {
+            Orin_Link_Fixed(imu.gyro[0], ORIN_LINK_RATE_SCALE),
+            Orin_Link_Fixed(imu.gyro[1], ORIN_LINK_RATE_SCALE),
+            Orin_Link_Fixed(imu.gyro[2], ORIN_LINK_RATE_SCALE),
+        },
+        .velocity = {
+            Orin_Link_Fixed(chassis.v_x, ORIN_LINK_SPEED_SCALE),
+            Orin_Link_Fixed(chassis.v_y, ORIN_LINK_SPEED_SCALE),
+            Orin_Link_Fixed(chassis.omega, ORIN_LINK_RATE_SCALE),
+        },
+        .flags = g_orin_link_stats.sync.synced ? ORIN_LINK_STATE_SYNCED : 0,
+    };
+    Orin_Link_Send(ORIN_LINK_FRAME_STATE, &state, sizeof(state), 0);
+}
+
+/**
+ * @brief A new request replaces one still unanswered, whose answer is then rejected.
+ */
+static void Orin_Link_Send_Sync_Request(void)
+{
+    uint64_t t1 = Orin_Link_Time_Us();
+    Orin_Link_Sync_Request_Frame_t request = {.t1 = (uint32_t)t1};
+    if (Orin_Link_Send(ORIN_LINK_FRAME_SYNC_REQUEST, &request, sizeof(request), 1))
+    {
+        g_orin_link_sync_t1 = t1;
+        g_orin_link_sync_pending = 1;
+    }
+}
+
+/**
+ * @brief us since the link started, the MCU's clock in the time sync. Link task only.
+ */
+uint64_t Orin_Link_Time_Us(void)
+{
+    uint32_t cycles = Cycle_Counter_Get();
+    g_orin_link_clock_cycles += (uint32_t)(cycles - g_orin_link_clock_last);
+    g_orin_link_clock_last = cycles;
+    return g_orin_link_clock_cycles / (CYCLE_COUNTER_HZ / 1000000U);
+}
+
+/**
+ * @brief The Orin's clock at MCU time mcu_us, from the last offset and drift estimate.
+ */
+uint64_t Orin_Link_To_Orin_Time(uint64_t mcu_us)
+{
+    const Orin_Link_Sync_t *sync = &g_orin_link_stats.sync;
+    float elapsed = (float)(int64_t)(mcu_us - sync->reference_us);
+    return mcu_us + (uint64_t)(sync->offset_us + (int64_t)(sync->drift * elapsed));
+}
+
+void Orin_Link_Init(void)
+{
+    g_orin_link_clock_last = Cycle_Counter_Get();
+    // circular, so reception never stops between two parses
+    huart6.hdmarx->Init.Mode = DMA_CIRCULAR;
+    HAL_DMA_Init(huart6.hdmarx);
+    HAL_UART_Receive_DMA(&huart6, g_orin_link_rx, ORIN_LINK_RX_BUFFER_SIZE);
+    __atomic_store_n(&g_orin_link_started, 1, __ATOMIC_RELEASE);
+}
+
+void Orin_Link_Task_Loop(void)
+{
+    if (!__atomic_load_n(&g_orin_link_started, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+    uint32_t tick = xTaskGetTickCount();
+    g_orin_link_last_parse_us = g_orin_link_parse_us;
+    g_orin_link_parse_us = Orin_Link_Time_Us();
+    Orin_Link_Receive(tick);
+    if (tick - g_orin_link_sync_tick >= ORIN_LINK_SYNC_PERIOD)
+    {
+        g_orin_link_sync_tick = tick;
+        Orin_Link_Send_Sync_Request();
+    }
+    if (tick - g_orin_link_state_tick >= ORIN_LINK_STATE_PERIOD)
+    {
+        g_orin_link_state_tick = tick;
+        Orin_Link_Send_State();
+    }
+    if (tick - g_orin_link_rate_tick >= ORIN_LINK_RATE_PERIOD)
+    {
+        g_orin_link_stats.tx.byte_rate = g_orin_link_stats.tx.bytes - g_orin_link_rate_tx_bytes;
+        g_orin_link_stats.rx.byte_rate = g_orin_link_stats.rx.bytes - g_orin_link_rate_rx_bytes;
+        g_orin_link_rate_tx_bytes = g_orin_link_stats.tx.bytes;
+        g_orin_link_rate_rx_bytes = g_orin_link_stats.rx.bytes;
+        g_orin_link_rate_tick = tick;
+    }
+}
+
+/**
+ * @brief Copy of the last aim frame. Only for tasks the link task can not preempt.
+ */
+void Orin_Link_Get_Aim(Orin_Link_Aim_t *aim)
+{
+    *aim = g_orin_link_aim[__atomic_load_n(&g_orin_link_aim_index, __ATOMIC_ACQUIRE)];
+}
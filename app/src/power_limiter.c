@@ -0,0 +1,227 @@
+#include "power_limiter.h"
+
+#include "arm_math.h"
+#include "can_tx_scheduler.h"
+#include "fast_math.h"
+#include "referee_system.h"
+#include "robot.h"
+
+// electrical models at the rotor, DJI datasheet values
+#define M3508_AMPS_PER_COMMAND (20.0f / M3508_MAX_CURRENT)
+#define M3508_RESISTANCE (0.194f) // ohm
+#define M3508_BACK_EMF (0.0248f)  // V per rad/s
+#define GM6020_VOLTS_PER_COMMAND (24.0f / GM6020_MAX_CURRENT)
+#define GM6020_RESISTANCE (1.8f)  // ohm
+#define GM6020_BACK_EMF (0.716f)  // V per rad/s
+#define RPM_TO_RAD_PER_SECOND (TWO_PI_F / 60.0f)
+
+typedef struct
+{
+    DJI_Motor_Handle_t *motor_handle;
+    float direction; // turns feedback into the direction of the command on the bus
+    uint8_t is_drive;
+} Power_Limiter_Motor_t;
+
+Power_Limiter_t g_power_limiter = {
+    .limit = POWER_LIMITER_DEFAULT_LIMIT, .drive_scale = 1.0f, .azimuth_scale = 1.0f};
+
+static Power_Limiter_Motor_t g_power_limiter_motors[POWER_LIMITER_MAX_MOTORS];
+static uint8_t g_power_limiter_motor_count = 0;
+
+// predicted power over the same referee samples as g_robot_state.chassis.power_buffer
+static float g_predicted_ring[BUFFER_SIZE];
+static float g_predicted_total = 0.0f;
+static float g_predicted_since_sample = 0.0f; // summed per cycle since the last referee sample
+static uint32_t g_cycles_since_sample = 0;
+static float g_buffer_max = 0.0f;
+static float g_last_chassis_power = -1.0f;
+static float g_last_power_buffer = -1.0f;
+
+void Power_Limiter_Register_Motor(DJI_Motor_Handle_t *motor_handle, Motor_Reversal_t reversal, uint8_t is_drive)
+{
+    if (g_power_limiter_motor_count >= POWER_LIMITER_MAX_MOTORS)
+    {
+        return;
+    }
+    Power_Limiter_Motor_t *motor = &g_power_limiter_motors[g_power_limiter_motor_count++];
+    motor->motor_handle = motor_handle;
+    motor->direction = reversal == MOTOR_REVERSAL_REVERSED ? -1.0f : 1.0f;
+    motor->is_drive = is_drive;
+}
+
+/**
+ * @brief Take a new referee sample: push it and the predicted power since the last one into
+ * the rings (running sums, O(1) per sample) and restart the buffer prediction from it.
+ */
+void Power_Limiter_Referee_Sample(float chassis_power, float power_buffer, float power_limit)
+{
+    Chassis_State_t *chassis = &g_robot_state.chassis;
+    float predicted = g_cycles_since_sample > 0 ? g_predicted_since_sample / g_cycles_since_sample : 0.0f;
+    g_predicted_since_sample = 0.0f;
+    g_cycles_since_sample = 0;
+
+    uint16_t index = chassis->power_index;
+    if (chassis->power_count == BUFFER_SIZE)
+    {
+        chassis->total_power -= chassis->power_buffer[index];
+        g_predicted_total -= g_predicted_ring[index];
+    }
+    else
+    {
+        chassis->power_count++;
+    }
+    chassis->power_buffer[index] = chassis_power;
+    g_predicted_ring[index] = predicted;
+    chassis->total_power += chassis_power;
+    g_predicted_total += predicted;
+    chassis->power_index = (index + 1) % BUFFER_SIZE;
+    if (chassis->power_index == 0)
+    {
+        // re-sum once per lap so the running sums cannot drift
+        chassis->total_power = 0.0f;
+        g_predicted_total = 0.0f;
+        for (int i = 0; i < chassis->power_count; i++)
+        {
+            chassis->total_power += chassis->power_buffer[i];
+            g_predicted_total += g_predicted_ring[i];
+        }
+    }
+    chassis->avg_power = chassis->total_power / chassis->power_count;
+
+    float offset = chassis->avg_power - g_predicted_total / chassis->power_count;
+    __MAX_LIMIT(offset, -POWER_LIMITER_MAX_OFFSET, POWER_LIMITER_MAX_OFFSET);
+    g_power_limiter.model_offset = offset;
+    g_power_limiter.limit = power_limit > 0.0f ? power_limit : POWER_LIMITER_DEFAULT_LIMIT;
+    g_power_limiter.buffer = power_buffer;
+    g_buffer_max = power_buffer > g_buffer_max ? power_buffer : g_buffer_max;
+    g_power_limiter.referee_samples++;
+}
+
+/**
+ * @brief Largest scale s in [0, 1] with a s^2 + b s <= budget, the predicted power of a group
+ * of commands all scaled by s. a >= 0, and budget >= 0 puts the other root at or below 0.
+ */
+static float Power_Limiter_Scale(float a, float b, float budget)
+{
+    if (a + b <= budget)
+    {
+        return 1.0f;
+    }
+    if (budget <= 0.0f)
+    {
+        return 0.0f;
+    }
+    float scale;
+    if (a < 1e-6f)
+    {
+        scale = budget / b; // b > budget > 0 here
+    }
+    else
+    {
+        float root;
+        arm_sqrt_f32(b * b + 4.0f * a * budget, &root);
+        scale = (root - b) / (2.0f * a);
+    }
+    __MAX_LIMIT(scale, 0.0f, 1.0f);
+    return scale;
+}
+
+static int16_t Power_Limiter_Read_Command(const uint8_t *data)
+{
+    return (int16_t)((data[0] << 8) | data[1]);
+}
+
+static void Power_Limiter_Write_Command(uint8_t *data, float command)
+{
+    int16_t value = (int16_t)command;
+    data[0] = (uint16_t)value >> 8;
+    data[1] = value & 0xFF;
+}
+
+/**
+ * @brief Predict, scale and rewrite the staged chassis commands, call between DJI_Motor_Send
+ * and CAN_TX_Scheduler_Flush.
+ */
+void Power_Limiter_Apply(void)
+{
+    if (Referee_Robot_State.Chassis_Power != g_last_chassis_power ||
+        Referee_Robot_State.Power_Buffer != g_last_power_buffer)
+    {
+        g_last_chassis_power = Referee_Robot_State.Chassis_Power;
+        g_last_power_buffer = Referee_Robot_State.Power_Buffer;
+        Power_Limiter_Referee_Sample(g_last_chassis_power, g_last_power_buffer, Referee_Robot_State.Chassis_Power_Max);
+    }
+
+    // P(s) = a s^2 + b s per group for its commands scaled by s
+    uint8_t *data[POWER_LIMITER_MAX_MOTORS];
+    float drive_a = 0.0f, drive_b = 0.0f, azimuth_a = 0.0f, azimuth_b = 0.0f;
+    for (int i = 0; i < g_power_limiter_motor_count; i++)
+    {
+        Power_Limiter_Motor_t *motor = &g_power_limiter_motors[i];
+        data[i] = CAN_TX_Scheduler_Staged_Motor_Data(motor->motor_handle);
+        if (data[i] == NULL)
+        {
+            continue;
+        }
+        float command = Power_Limiter_Read_Command(data[i]);
+        float speed = motor->direction * DJI_Motor_Get_Velocity(motor->motor_handle) * RPM_TO_RAD_PER_SECOND;
+        if (motor->is_drive)
+        {
+            float current = command * M3508_AMPS_PER_COMMAND;
+            drive_a += M3508_RESISTANCE * current * current;
+            drive_b += M3508_BACK_EMF * speed * M3508_REDUCTION_RATIO * current;
+        }
+        else
+        {
+            float voltage = command * GM6020_VOLTS_PER_COMMAND;
+            azimuth_a += voltage * voltage / GM6020_RESISTANCE;
+            azimuth_b -= voltage * GM6020_BACK_EMF * speed / GM6020_RESISTANCE;
+        }
+    }
+    float predicted = drive_a + drive_b + azimuth_a + azimuth_b;
+    g_power_limiter.predicted_power = predicted;
+
+    float azimuth_scale = 1.0f, drive_scale = 1.0f;
+    if (g_power_limiter.referee_samples > 0)
+    {
+        float budget = g_power_limiter.limit + g_power_limiter.cap_power +
+                       (g_power_limiter.buffer - POWER_LIMITER_BUFFER_RESERVE) / POWER_LIMITER_BUFFER_HORIZON -
+                       g_power_limiter.model_offset;
+        budget = budget > 0.0f ? budget : 0.0f;
+        g_power_limiter.budget = budget;
+
+        azimuth_scale = Power_Limiter_Scale(azimuth_a, azimuth_b, budget);
+        float azimuth_power = (azimuth_a * azimuth_scale + azimuth_b) * azimuth_scale;
+        drive_scale = Power_Limiter_Scale(drive_a, drive_b, budget - azimuth_power);
+    }
+    if (azimuth_scale < 1.0f || drive_scale < 1.0f)
+    {
+        for (int i = 0; i < g_power_limiter_motor_count; i++)
+        {
+            if (data[i] != NULL)
+            {
+                float scale = g_power_limiter_motors[i].is_drive ? drive_scale : azimuth_scale;
+                Power_Limiter_Write_Command(data[i], Power_Limiter_Read_Command(data[i]) * scale);
+            }
+        }
+        g_power_limiter.limited_cycles++;
+    }
+    float limited = (azimuth_a * azimuth_scale + azimuth_b) * azimuth_scale + (drive_a * drive_scale + drive_b) * drive_scale;
+    g_power_limiter.limited_power = limited;
+    g_power_limiter.azimuth_scale = azimuth_scale;
+    g_power_limiter.drive_scale = drive_scale;
+    g_robot_state.chassis.power_increment_ratio = drive_scale;
+
+    // the supercap covers what goes above the limit up to cap_power, the referee sees the rest
+    float from_cap = limited - g_power_limiter.limit;
+    __MAX_LIMIT(from_cap, 0.0f, g_power_limiter.cap_power);
+    float drawn = limited - from_cap;
+
+    // the referee buffer drains with what is drawn above the limit until its next sample
+    g_predicted_since_sample += drawn;
+    g_cycles_since_sample++;
+    float buffer = g_power_limiter.buffer -
+                   (drawn + g_power_limiter.model_offset - g_power_limiter.limit) * POWER_LIMITER_PERIOD;
+    __MAX_LIMIT(buffer, 0.0f, g_buffer_max);
+    g_power_limiter.buffer = buffer;
+}
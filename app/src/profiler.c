@@ -0,0 +1,134 @@
+#include "profiler.h"
+
+#include "cycle_counter.h"
+#include "jetson_orin.h"
+#include "orin_link.h"
+#include "rate_group.h"
+
+// deadlines are the rate group and task periods
+Profiler_Section_t g_profiler_sections[PROFILE_SECTION_COUNT] = {
+    [PROFILE_ROBOT_COMMAND] = {.name = "robot_command", .deadline_us = RATE_GROUP_COMMAND_PERIOD * 1000},
+    [PROFILE_CHASSIS] = {.name = "chassis", .deadline_us = RATE_GROUP_CHASSIS_PERIOD * 1000},
+    [PROFILE_GIMBAL] = {.name = "gimbal", .deadline_us = RATE_GROUP_GIMBAL_PERIOD * 1000},
+    [PROFILE_LAUNCH] = {.name = "launch", .deadline_us = RATE_GROUP_COMMAND_PERIOD * 1000},
+    [PROFILE_MOTOR] = {.name = "motor", .deadline_us = 1000},
+#ifdef ORIN_LINK_ENABLED
+    [PROFILE_JETSON_SEND] = {.name = "orin_link", .deadline_us = ORIN_LINK_PERIOD * 1000},
+#else
+    [PROFILE_JETSON_SEND] = {.name = "jetson_send", .deadline_us = JETSON_ORIN_PERIOD * 1000},
+#endif
+};
+
+volatile uint8_t g_profiler_report_requested = 0;
+
+uint32_t Profiler_Cycles_To_Us(uint32_t cycles)
+{
+    return (uint32_t)((uint64_t)cycles * 1000000U / CYCLE_COUNTER_HZ);
+}
+
+void Profiler_Init(void)
+{
+    Cycle_Counter_Init();
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++)
+    {
+        g_profiler_sections[i].deadline_cycles = (uint32_t)((uint64_t)g_profiler_sections[i].deadline_us * CYCLE_COUNTER_HZ / 1000000U);
+    }
+    Profiler_Reset();
+}
+
+void Profiler_Reset(void)
+{
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++)
+    {
+        Profiler_Section_t *section = &g_profiler_sections[i];
+        section->count = 0;
+        section->min = UINT32_MAX;
+        section->max = 0;
+        section->deadline_misses = 0;
+        for (int b = 0; b < PROFILER_BUCKETS; b++)
+        {
+            section->histogram[b] = 0;
+        }
+    }
+}
+
+// log-linear bucket: the top bit picks the octave, the next PROFILER_SUB_BUCKETS_BITS bits split it
+static uint32_t Profiler_Bucket(uint32_t cycles)
+{
+    if (cycles < (1U << PROFILER_SUB_BUCKETS_BITS))
+    {
+        return cycles;
+    }
+    uint32_t msb = 31 - __builtin_clz(cycles);
+    uint32_t sub = (cycles >> (msb - PROFILER_SUB_BUCKETS_BITS)) & ((1U << PROFILER_SUB_BUCKETS_BITS) - 1);
+    return ((msb - PROFILER_SUB_BUCKETS_BITS + 1) << PROFILER_SUB_BUCKETS_BITS) + sub;
+}
+
+// largest value that lands in a bucket
+static uint32_t Profiler_Bucket_Upper_Bound(uint32_t bucket)
+{
+    if (bucket < (1U << PROFILER_SUB_BUCKETS_BITS))
+    {
+        return bucket;
+    }
+    uint32_t msb = (bucket >> PROFILER_SUB_BUCKETS_BITS) + PROFILER_SUB_BUCKETS_BITS - 1;
+    uint32_t sub = bucket & ((1U << PROFILER_SUB_BUCKETS_BITS) - 1);
+    uint32_t lower = (1U << msb) | (sub << (msb - PROFILER_SUB_BUCKETS_BITS));
+    return lower + (1U << (msb - PROFILER_SUB_BUCKETS_BITS)) - 1;
+}
+
+void Profiler_Begin(Profile_Section_e section)
+{
+    g_profiler_sections[section].start = Cycle_Counter_Get();
+}
+
+void Profiler_End(Profile_Section_e section)
+{
+    Profiler_Section_t *s = &g_profiler_sections[section];
+    uint32_t cycles = Cycle_Counter_Get() - s->start;
+
+    s->count++;
+    if (cycles < s->min)
+    {
+        s->min = cycles;
+    }
+    if (cycles > s->max)
+    {
+        s->max = cycles;
+    }
+    if (s->deadline_cycles != 0 && cycles > s->deadline_cycles)
+    {
+        s->deadline_misses++;
+    }
+    s->histogram[Profiler_Bucket(cycles)]++;
+}
+
+/**
+ * @brief Upper bound (in cycles) of the bucket holding the given percentile (0-100), clamped to max.
+ */
+uint32_t Profiler_Get_Percentile(Profile_Section_e section, float percentile)
+{
+    Profiler_Section_t *s = &g_profiler_sections[section];
+    if (s->count == 0)
+    {
+        return 0;
+    }
+    // nearest rank
+    float rank = (float)s->count * percentile / 100.0f;
+    uint32_t target = (uint32_t)rank;
+    if ((float)target < rank || target == 0)
+    {
+        target++;
+    }
+    uint32_t cumulative = 0;
+    for (uint32_t b = 0; b < PROFILER_BUCKETS; b++)
+    {
+        cumulative += s->histogram[b];
+        if (cumulative >= target)
+        {
+            uint32_t bound = Profiler_Bucket_Upper_Bound(b);
+            return bound < s->max ? bound : s->max;
+        }
+    }
+    return s->max;
+}
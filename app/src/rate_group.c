@@ -0,0 +1,82 @@
+#include "rate_group.h"
+
+#include "task.h"
+#include "robot.h"
+#include "control_sync.h"
+#include "cycle_counter.h"
+
+Rate_Group_t g_rate_groups[RATE_GROUP_COUNT] = {
+    [RATE_GROUP_GIMBAL] = {.name = "gimbal", .period_ms = RATE_GROUP_GIMBAL_PERIOD, .priority = osPriorityHigh, .loop = Robot_Gimbal_Loop},
+    [RATE_GROUP_CHASSIS] = {.name = "chassis", .period_ms = RATE_GROUP_CHASSIS_PERIOD, .priority = osPriorityAboveNormal, .loop = Robot_Chassis_Loop},
+    [RATE_GROUP_COMMAND] = {.name = "robot_command", .period_ms = RATE_GROUP_COMMAND_PERIOD, .priority = osPriorityNormal, .loop = Robot_Command_Loop},
+};
+
+void Rate_Group_Init(void)
+{
+    Cycle_Counter_Init();
+    for (int i = 0; i < RATE_GROUP_COUNT; i++)
+    {
+        g_rate_groups[i].period_cycles = (uint32_t)((uint64_t)g_rate_groups[i].period_ms * CYCLE_COUNTER_HZ / 1000U);
+    }
+}
+
+/**
+ * @brief Block until the group's next release: its period, or with EVENT_DRIVEN_CONTROL the
+ * motor feedback set that lines up with it (timing out one tick late if feedback stops).
+ */
+void Rate_Group_Wait(Rate_Group_e group, TickType_t *last_wake_time)
+{
+#ifdef EVENT_DRIVEN_CONTROL
+    (void)last_wake_time;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(g_rate_groups[group].period_ms + 1)) == 0)
+    {
+        g_rate_groups[group].release_timeouts++;
+    }
+#else
+    vTaskDelayUntil(last_wake_time, pdMS_TO_TICKS(g_rate_groups[group].period_ms));
+#endif
+}
+
+/**
+ * @brief One cycle of the group, call right after Rate_Group_Wait. A response time past
+ * the period (preemption included) means the next release was missed, counted as an overrun.
+ */
+void Rate_Group_Run(Rate_Group_e group)
+{
+    Rate_Group_t *rate_group = &g_rate_groups[group];
+    uint32_t release = Cycle_Counter_Get();
+    rate_group->loop();
+
+    uint32_t response = Cycle_Counter_Get() - release;
+    rate_group->runs++;
+    if (response > rate_group->period_cycles)
+    {
+        rate_group->overruns++;
+    }
+    if (response > rate_group->max_response_cycles)
+    {
+        rate_group->max_response_cycles = response;
+    }
+
+#ifdef EVENT_DRIVEN_CONTROL
+    // the fastest group runs on every feedback set, the motor task sends right after it
+    if (group == RATE_GROUP_GIMBAL)
+    {
+        Control_Sync_Command_Done();
+    }
+#endif
+}
+
+/**
+ * @brief Release every group whose period lines up with this feedback set (motor feedback is 1 kHz).
+ */
+void Rate_Group_Release_From_ISR(uint32_t feedback_set, BaseType_t *higher_priority_task_woken)
+{
+    for (int i = 0; i < RATE_GROUP_COUNT; i++)
+    {
+        if (g_rate_groups[i].handle != NULL && feedback_set % g_rate_groups[i].period_ms == 0)
+        {
+            vTaskNotifyGiveFromISR(g_rate_groups[i].handle, higher_priority_task_woken);
+        }
+    }
+}
@@ -10,11 +10,25 @@
 #include "buzzer.h"
 #include "supercap.h"
 #include "user_math.h"
-#include "math.h"
+#include "fast_math.h"
 #include "rate_limiter.h"
+#include "control_sync.h"
+#include "input_snapshot.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "static_pool.h"
+#include "boot.h"
+#include "melody_player.h"
+#include "rate_group.h"
+#include "can_tx_scheduler.h"
+#include "power_limiter.h"
+#include "boost_scheduler.h"
+#include "imu_history.h"
+#include "aim_tracker.h"
+#include "orin_link.h"
+#include "chassis_odometry.h"
 
 Robot_State_t g_robot_state = {0};
-extern Remote_t g_remote;
 extern Supercap_t g_supercap;
 
 extern DJI_Motor_Handle_t *g_yaw;
@@ -23,49 +37,145 @@ Input_State_t g_input_state = {0};
 rate_limiter_t controller_limit_x = {0};
 rate_limiter_t controller_limit_y = {0};
 
-#define KEYBOARD_RAMP_COEF (0.004f)
+// per command group call, 0.004 per 2 ms call as tuned
+#define KEYBOARD_RAMP_COEF (0.004f * RATE_GROUP_COMMAND_PERIOD / RATE_GROUP_TUNED_PERIOD)
+// gimbal rad/s per unit of stick or mouse, from the increments tuned per 2 ms call
+#define GIMBAL_INPUT_RATE (1000.0f / RATE_GROUP_TUNED_PERIOD)
 
 /**
  * @brief This function initializes the robot.
  * This means setting the state to STARTING_UP,
  * initializing the buzzer, and calling the
- * Robot_Task_Start() for the task scheduling
+ * Robot_Task_Start() for the task scheduling.
+ * The start up melody plays in the background while the tasks bring up the hardware.
  */
 void Robot_Init()
 {
+    Boot_Begin();
     g_robot_state.state = STARTING_UP;
 
     Buzzer_Init();
+    Melody_Player_Init();
     Melody_t system_init_melody = {
         .notes = SYSTEM_INITIALIZING,
         .loudness = 0.5f,
         .note_num = SYSTEM_INITIALIZING_NOTE_NUM,
     };
-    Buzzer_Play_Melody(system_init_melody); // TODO: Change to non-blocking
+    Melody_Player_Start(system_init_melody);
+
+    Profiler_Init();
+    Telemetry_Init();
+    Rate_Group_Init();
 
     // Initialize all tasks
     Robot_Tasks_Start();
 }
 
+static void Boot_CAN(void)
+{
+    CAN_Service_Init();
+    CAN_TX_Scheduler_Init();
+}
+
+static void Boot_Referee_System(void)
+{
+    Referee_System_Init(&huart1);
+}
+
+static void Boot_Supercap(void)
+{
+    Supercap_Init(&g_supercap);
+}
+
+static void Boot_Remote(void)
+{
+    Remote_Init(&huart3);
+}
+
+static void Boot_Telemetry(void)
+{
+#ifdef TELEMETRY_ENABLED
+    TELEMETRY_REGISTER("imu_yaw", &g_gimbal_inputs.imu.yaw);
+    TELEMETRY_REGISTER("imu_pitch", &g_gimbal_inputs.imu.pitch);
+    TELEMETRY_REGISTER("imu_roll", &g_gimbal_inputs.imu.roll);
+    TELEMETRY_REGISTER("aim_yaw", &g_gimbal_inputs.aim.yaw);
+    TELEMETRY_REGISTER("aim_pitch", &g_gimbal_inputs.aim.pitch);
+#ifdef AIM_TRACKER_ENABLED
+    TELEMETRY_REGISTER("aim_target_valid", &g_aim_tracker.target_valid);
+#endif
+    TELEMETRY_REGISTER("chassis_power", &Referee_Robot_State.Chassis_Power);
+    TELEMETRY_REGISTER("power_buffer", &Referee_Robot_State.Power_Buffer);
+    TELEMETRY_REGISTER("chassis_power_max", &Referee_Robot_State.Chassis_Power_Max);
+#ifdef POWER_LIMITER_ENABLED
+    TELEMETRY_REGISTER("power_budget", &g_power_limiter.budget);
+    TELEMETRY_REGISTER("power_drive_scale", &g_power_limiter.drive_scale);
+#endif
+#ifdef GIMBAL_YAW_FEEDFORWARD_ENABLED
+    TELEMETRY_REGISTER("yaw_feedforward", &g_gimbal_yaw_feedforward.command);
+#endif
+#ifdef BOOST_SCHEDULER_ENABLED
+    TELEMETRY_REGISTER("supercap_percent", &g_supercap.supercap_percent);
+    TELEMETRY_REGISTER("boost_speed_scale", &g_boost_scheduler.speed_scale);
+#endif
+#ifdef CHASSIS_ODOMETRY_ENABLED
+    TELEMETRY_REGISTER("odom_x", &g_chassis_odometry.state.x);
+    TELEMETRY_REGISTER("odom_y", &g_chassis_odometry.state.y);
+    TELEMETRY_REGISTER("odom_slip_cycles", &g_chassis_odometry.slip_cycles);
+#endif
+    TELEMETRY_REGISTER("can1_load", &g_can_tx_stats.bus[0].load_percent);
+    TELEMETRY_REGISTER("can2_load", &g_can_tx_stats.bus[1].load_percent);
+#ifdef ORIN_LINK_ENABLED
+    TELEMETRY_REGISTER("orin_rx_frames", &g_orin_link_stats.rx.frames);
+    TELEMETRY_REGISTER("orin_rx_lost", &g_orin_link_stats.rx.lost);
+    TELEMETRY_REGISTER("orin_rx_dropped", &g_orin_link_stats.rx.dropped);
+    TELEMETRY_REGISTER("orin_rx_byte_rate", &g_orin_link_stats.rx.byte_rate);
+    TELEMETRY_REGISTER("orin_tx_byte_rate", &g_orin_link_stats.tx.byte_rate);
+    TELEMETRY_REGISTER("orin_sync_drift_ppm", &g_orin_link_stats.sync.drift_ppm);
+    TELEMETRY_REGISTER("orin_sync_residual", &g_orin_link_stats.sync.residual_us);
+    TELEMETRY_REGISTER("orin_sync_round_trip", &g_orin_link_stats.sync.round_trip_us);
+    TELEMETRY_REGISTER("orin_sync_rejected", &g_orin_link_stats.sync.rejected);
+#endif
+    Telemetry_Start();
+#endif
+}
+
+/*
+ * Start up stages in dependency order. They stay on the command task: the CAN device,
+ * daemon and UART registries in control-base are not safe to fill from two tasks at once.
+ * Things that can overlap already do, the melody on its timer and the IMU in its own task.
+ */
+static const Boot_Stage_t g_boot_stages[] = {
+    {"control_sync", Control_Sync_Init},
+    {"can", Boot_CAN},
+    {"referee", Boot_Referee_System},
+    {"supercap", Boot_Supercap},
+    {"chassis", Chassis_Task_Init},
+    {"gimbal", Gimbal_Task_Init},
+    {"launch", Launch_Task_Init},
+    {"remote", Boot_Remote},
+    {"telemetry", Boot_Telemetry},
+#ifdef ORIN_LINK_ENABLED
+    {"orin_link", Orin_Link_Init},
+#endif
+};
+
 /**
  * @brief This function handles the starting up state of the robot, initializing all hardware.
  */
 void Handle_Starting_Up_State()
 {
+    Boot_Mark("scheduler_started");
     // Initialize all hardware
-    CAN_Service_Init();
-    Referee_System_Init(&huart1);
-    Supercap_Init(&g_supercap);
-    Chassis_Task_Init();
-    Gimbal_Task_Init();
-    Launch_Task_Init();
+    Boot_Run(g_boot_stages, sizeof(g_boot_stages) / sizeof(g_boot_stages[0]));
 
-    Remote_Init(&huart3);
+    // every driver handle is allocated by now, later allocations show up as late in the boot report
+    Static_Pool_Lock();
 
     // ! this should be 4, we just made it high to disable the rate limiter for now
     #define MAX_ACCEL 100 // %/s^2 defined here for local context
-    rate_limiter_init(&g_robot_state.rate_limiters.controller_limit_x, MAX_ACCEL);
-    rate_limiter_init(&g_robot_state.rate_limiters.controller_limit_y, MAX_ACCEL);
+    // the limiter steps max_rate per call as if called every 2 ms, it runs in the command group
+    rate_limiter_init(&g_robot_state.rate_limiters.controller_limit_x, MAX_ACCEL * RATE_GROUP_COMMAND_PERIOD / RATE_GROUP_TUNED_PERIOD);
+    rate_limiter_init(&g_robot_state.rate_limiters.controller_limit_y, MAX_ACCEL * RATE_GROUP_COMMAND_PERIOD / RATE_GROUP_TUNED_PERIOD);
 
     g_robot_state.state = DISABLED;
 }
@@ -76,17 +186,16 @@ void Handle_Starting_Up_State()
  */
 void Handle_Enabled_State()
 {
-    if ((g_remote.online_flag == REMOTE_OFFLINE) || (g_remote.controller.right_switch == DOWN))
+    if ((g_inputs.remote.online_flag == REMOTE_OFFLINE) || (g_inputs.remote.controller.right_switch == DOWN))
     {
         g_robot_state.state = DISABLED;
     }
     else
     {
         // Process movement and components in enabled state
+        // chassis and gimbal control run in their own rate groups, see Robot_Chassis_Loop and Robot_Gimbal_Loop
         Referee_Set_Robot_State();
         Process_Remote_Input();
-        Process_Chassis_Control();
-        Process_Gimbal_Control();
         Process_Launch_Control();
     }
 }
@@ -103,8 +212,11 @@ void Handle_Disabled_State()
     g_robot_state.launch.IS_FLYWHEEL_ENABLED = 0;
     g_robot_state.chassis.x_speed = 0;
     g_robot_state.chassis.y_speed = 0;
+    g_supercap.supercap_enabled_flag = 0; // the boost scheduler turns it back on once enabled
+    const Gimbal_Command_t gimbal_hold = {0};
+    Gimbal_Set_Command(&gimbal_hold); // no rates left over for the next enable
 
-    if ((g_remote.online_flag == REMOTE_ONLINE) && (g_remote.controller.right_switch != DOWN))
+    if ((g_inputs.remote.online_flag == REMOTE_ONLINE) && (g_inputs.remote.controller.right_switch != DOWN))
     {
         g_robot_state.state = ENABLED;
         DJI_Motor_Enable_All();
@@ -114,52 +226,58 @@ void Handle_Disabled_State()
 void Process_Remote_Input()
 {
     // Process remote input
-    g_robot_state.input.vy_keyboard = ((1.0f - KEYBOARD_RAMP_COEF) * g_robot_state.input.vy_keyboard + g_remote.keyboard.W * KEYBOARD_RAMP_COEF - g_remote.keyboard.S * KEYBOARD_RAMP_COEF);
-    g_robot_state.input.vx_keyboard = ((1.0f - KEYBOARD_RAMP_COEF) * g_robot_state.input.vx_keyboard - g_remote.keyboard.A * KEYBOARD_RAMP_COEF + g_remote.keyboard.D * KEYBOARD_RAMP_COEF);
-    float temp_x = g_robot_state.input.vx_keyboard + g_remote.controller.left_stick.x / REMOTE_STICK_MAX;
-    float temp_y = g_robot_state.input.vy_keyboard + g_remote.controller.left_stick.y / REMOTE_STICK_MAX;
+    g_robot_state.input.vy_keyboard = ((1.0f - KEYBOARD_RAMP_COEF) * g_robot_state.input.vy_keyboard + g_inputs.remote.keyboard.W * KEYBOARD_RAMP_COEF - g_inputs.remote.keyboard.S * KEYBOARD_RAMP_COEF);
+    g_robot_state.input.vx_keyboard = ((1.0f - KEYBOARD_RAMP_COEF) * g_robot_state.input.vx_keyboard - g_inputs.remote.keyboard.A * KEYBOARD_RAMP_COEF + g_inputs.remote.keyboard.D * KEYBOARD_RAMP_COEF);
+    float temp_x = g_robot_state.input.vx_keyboard + g_inputs.remote.controller.left_stick.x / REMOTE_STICK_MAX;
+    float temp_y = g_robot_state.input.vy_keyboard + g_inputs.remote.controller.left_stick.y / REMOTE_STICK_MAX;
     g_robot_state.input.vx = rate_limiter(&g_robot_state.rate_limiters.controller_limit_x, temp_x);
     g_robot_state.input.vy = rate_limiter(&g_robot_state.rate_limiters.controller_limit_y, temp_y);
 
 
     // Calculate Gimbal Oriented Control
     float theta = DJI_Motor_Get_Absolute_Angle(g_yaw);
-    g_robot_state.chassis.x_speed = -g_robot_state.input.vy * sin(theta) + g_robot_state.input.vx * cos(theta);
-    g_robot_state.chassis.y_speed = g_robot_state.input.vy * cos(theta) + g_robot_state.input.vx * sin(theta);
-
-    g_robot_state.gimbal.yaw_angle -= (g_remote.controller.right_stick.x / 50000.0f + g_remote.mouse.x / 10000.0f);    // controller and mouse
-    g_robot_state.gimbal.pitch_angle -= (g_remote.controller.right_stick.y / 100000.0f - g_remote.mouse.y / 50000.0f);
+    float sin_theta, cos_theta;
+    Fast_Sin_Cos(theta, &sin_theta, &cos_theta);
+    g_robot_state.chassis.x_speed = -g_robot_state.input.vy * sin_theta + g_robot_state.input.vx * cos_theta;
+    g_robot_state.chassis.y_speed = g_robot_state.input.vy * cos_theta + g_robot_state.input.vx * sin_theta;
+
+    // controller and mouse, the gimbal group integrates the rates into the setpoint
+    Gimbal_Command_t gimbal_command = {
+        .yaw_rate = -(g_inputs.remote.controller.right_stick.x / 50000.0f + g_inputs.remote.mouse.x / 10000.0f) * GIMBAL_INPUT_RATE,
+        .pitch_rate = -(g_inputs.remote.controller.right_stick.y / 100000.0f - g_inputs.remote.mouse.y / 50000.0f) * GIMBAL_INPUT_RATE,
+    };
+    Gimbal_Set_Command(&gimbal_command);
 
     // keyboard toggles
-    if (__IS_TOGGLED(g_remote.keyboard.B, g_input_state.prev_B))
+    if (__IS_TOGGLED(g_inputs.remote.keyboard.B, g_input_state.prev_B))
     {
         g_robot_state.launch.IS_FIRING_ENABLED ^= 0x01; // Toggle firing
     }
-    if (__IS_TOGGLED(g_remote.keyboard.B, g_input_state.prev_B))
+    if (__IS_TOGGLED(g_inputs.remote.keyboard.B, g_input_state.prev_B))
     {
         g_robot_state.chassis.IS_SPINTOP_ENABLED ^= 0x01; // Toggle spintop
     }
-    if (__IS_TOGGLED(g_remote.keyboard.B, g_input_state.prev_B))
+    if (__IS_TOGGLED(g_inputs.remote.keyboard.B, g_input_state.prev_B))
     {
         g_robot_state.UI_ENABLED ^= 0x01; // Toggle UI
     }
-    if (__IS_TOGGLED(g_remote.keyboard.Shift, g_input_state.prev_Shift))
+    if (__IS_TOGGLED(g_inputs.remote.keyboard.Shift, g_input_state.prev_Shift))
     {
         g_robot_state.IS_SUPER_CAPACITOR_ENABLED ^= 0x01; // Toggle supercap
     }
 
     // controller toggles
-    if (__IS_TRANSITIONED(g_remote.controller.left_switch, g_input_state.prev_left_switch, MID))
+    if (__IS_TRANSITIONED(g_inputs.remote.controller.left_switch, g_input_state.prev_left_switch, MID))
     {
         g_robot_state.chassis.IS_SPINTOP_ENABLED = 1;
     }
-    if (__IS_TRANSITIONED(g_remote.controller.left_switch, g_input_state.prev_left_switch, DOWN) ||
-        __IS_TRANSITIONED(g_remote.controller.left_switch, g_input_state.prev_left_switch, UP))
+    if (__IS_TRANSITIONED(g_inputs.remote.controller.left_switch, g_input_state.prev_left_switch, DOWN) ||
+        __IS_TRANSITIONED(g_inputs.remote.controller.left_switch, g_input_state.prev_left_switch, UP))
     {
         g_robot_state.chassis.IS_SPINTOP_ENABLED = 0;
     }
 
-    if (g_remote.controller.left_switch == UP)
+    if (g_inputs.remote.controller.left_switch == UP)
     {
         g_robot_state.launch.IS_FIRING_ENABLED = 1;
     }
@@ -168,7 +286,7 @@ void Process_Remote_Input()
         g_robot_state.launch.IS_FIRING_ENABLED = 0;
     }
 
-    if ((g_remote.controller.right_switch == UP) || (g_remote.mouse.right == 1)) // mouse right button auto aim
+    if ((g_inputs.remote.controller.right_switch == UP) || (g_inputs.remote.mouse.right == 1)) // mouse right button auto aim
     {
         g_robot_state.launch.IS_AUTO_AIMING_ENABLED = 1;
     }
@@ -177,11 +295,11 @@ void Process_Remote_Input()
         g_robot_state.launch.IS_AUTO_AIMING_ENABLED = 0;
     }
 
-    if (g_remote.controller.wheel < -50.0f)
+    if (g_inputs.remote.controller.wheel < -50.0f)
     { // dial wheel forward single fire
         g_robot_state.launch.fire_mode = SINGLE_FIRE;
     }
-    else if (g_remote.controller.wheel > 50.0f)
+    else if (g_inputs.remote.controller.wheel > 50.0f)
     { // dial wheel backward burst `fire
         g_robot_state.launch.fire_mode = FULL_AUTO;
     }
@@ -192,7 +310,7 @@ void Process_Remote_Input()
 
     // cycle burst flags with keyboard
     // TODO: assign a key for this
-    // if (__IS_TOGGLED(g_remote.keyboard.G, g_input_state.prev_G))
+    // if (__IS_TOGGLED(g_inputs.remote.keyboard.G, g_input_state.prev_G))
     // {
     //     if (g_robot_state.launch.fire_mode == FULL_AUTO)
     //     {
@@ -206,49 +324,91 @@ void Process_Remote_Input()
 
 
 
-    // TODO: implement controller toggle for supercap
-    // if (g_remote.controller.wheel > 50.0f && !g_robot_state.launch.IS_FLYWHEEL_ENABLED)
-    // {
-    //     g_supercap.supercap_enabled_flag = 1;
-    // }
-    // else
-    // {
-    //     g_supercap.supercap_enabled_flag = 0;
-    // }
+    // controller supercap, held with the dial wheel back while the flywheels are off, the boost
+    // scheduler decides whether the cap output actually turns on
+    uint8_t supercap_held = (g_inputs.remote.controller.wheel > 50.0f) && !g_robot_state.launch.IS_FLYWHEEL_ENABLED;
+    if (supercap_held != g_input_state.prev_supercap_held)
+    {
+        g_robot_state.IS_SUPER_CAPACITOR_ENABLED = supercap_held;
+    }
+    g_input_state.prev_supercap_held = supercap_held;
 
     // Update previous states keyboard
-    g_input_state.prev_B = g_remote.keyboard.B;
-    g_input_state.prev_G = g_remote.keyboard.G;
-    g_input_state.prev_V = g_remote.keyboard.V;
-    g_input_state.prev_Z = g_remote.keyboard.Z;
-    g_input_state.prev_Shift = g_remote.keyboard.Shift;
+    g_input_state.prev_B = g_inputs.remote.keyboard.B;
+    g_input_state.prev_G = g_inputs.remote.keyboard.G;
+    g_input_state.prev_V = g_inputs.remote.keyboard.V;
+    g_input_state.prev_Z = g_inputs.remote.keyboard.Z;
+    g_input_state.prev_Shift = g_inputs.remote.keyboard.Shift;
 
     // Update previous states remote
-    g_input_state.prev_left_switch = g_remote.controller.left_switch;
-    g_input_state.prev_right_switch = g_remote.controller.right_switch;
+    g_input_state.prev_left_switch = g_inputs.remote.controller.left_switch;
+    g_input_state.prev_right_switch = g_inputs.remote.controller.right_switch;
 }
 
 void Process_Chassis_Control()
 {
+    PROFILE_BEGIN(PROFILE_CHASSIS);
     Chassis_Ctrl_Loop();
+    PROFILE_END(PROFILE_CHASSIS);
 }
 
 void Process_Gimbal_Control()
 {
+    PROFILE_BEGIN(PROFILE_GIMBAL);
     Gimbal_Ctrl_Loop();
+    PROFILE_END(PROFILE_GIMBAL);
 }
 
 void Process_Launch_Control()
 {
+    PROFILE_BEGIN(PROFILE_LAUNCH);
     Launch_Ctrl_Loop();
+    PROFILE_END(PROFILE_LAUNCH);
+}
+
+/**
+ * @brief Gimbal rate group, the fastest one. It samples the shared inputs for every group.
+ */
+void Robot_Gimbal_Loop()
+{
+    Input_Snapshot_Update(&g_gimbal_inputs);
+#ifdef AIM_LATENCY_COMPENSATION_ENABLED
+    IMU_History_Push(xTaskGetTickCount(), g_gimbal_inputs.imu.yaw, g_gimbal_inputs.imu.pitch);
+#endif
+    if (g_robot_state.state == ENABLED)
+    {
+        Process_Gimbal_Control();
+    }
+}
+
+/**
+ * @brief Chassis rate group. Odometry runs enabled or not, the robot may be pushed around.
+ */
+void Robot_Chassis_Loop()
+{
+#ifdef CHASSIS_ODOMETRY_ENABLED
+    if (g_robot_state.state != STARTING_UP)
+    {
+        Chassis_Odometry_Update(RATE_GROUP_CHASSIS_PERIOD * 0.001f);
+    }
+#endif
+    if (g_robot_state.state == ENABLED)
+    {
+        Process_Chassis_Control();
+    }
 }
 
 /*
  * @brief It serves as the top level state machine for the robot based on the current state.
- *  Appropriate functions are called.
+ *  Appropriate functions are called. Runs as the command rate group.
  */
 void Robot_Command_Loop()
 {
+    PROFILE_BEGIN(PROFILE_ROBOT_COMMAND);
+
+    // every handler this cycle sees the same coherent inputs
+    Input_Snapshot_Take(&g_inputs);
+
     switch (g_robot_state.state)
     {
     case STARTING_UP:
@@ -264,4 +424,6 @@ void Robot_Command_Loop()
         Error_Handler();
         break;
     }
+
+    PROFILE_END(PROFILE_ROBOT_COMMAND);
 }
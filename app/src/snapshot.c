@@ -0,0 +1,48 @@
+#include "snapshot.h"
+
+#include <string.h>
+
+// Full barrier, a DMB on the M4 and a real fence for the host stress test
+#define SNAPSHOT_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+void Snapshot_Publish(Snapshot_t *snapshot, const void *src)
+{
+    uint32_t sequence = snapshot->sequence;
+    snapshot->sequence = sequence + 1; // odd, write in progress
+    SNAPSHOT_BARRIER();
+    memcpy(snapshot->data, src, snapshot->size);
+    SNAPSHOT_BARRIER();
+    snapshot->sequence = sequence + 2;
+}
+
+void Snapshot_Read(const Snapshot_t *snapshot, void *dst)
+{
+    uint32_t sequence_begin, sequence_end;
+    do
+    {
+        sequence_begin = snapshot->sequence;
+        SNAPSHOT_BARRIER();
+        memcpy(dst, snapshot->data, snapshot->size);
+        SNAPSHOT_BARRIER();
+        sequence_end = snapshot->sequence;
+    } while ((sequence_begin & 1U) || (sequence_begin != sequence_end));
+}
+
+uint32_t Snapshot_Sample(void *dst, const volatile void *src, uint16_t size)
+{
+    uint8_t check[SNAPSHOT_SAMPLE_MAX_SIZE];
+    uint32_t retries = 0;
+
+    memcpy(dst, (const void *)src, size);
+    while (1)
+    {
+        SNAPSHOT_BARRIER();
+        memcpy(check, (const void *)src, size);
+        if (memcmp(dst, check, size) == 0)
+        {
+            return retries;
+        }
+        memcpy(dst, check, size);
+        retries++;
+    }
+}
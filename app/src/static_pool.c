@@ -0,0 +1,95 @@
+#include "static_pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "main.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+Static_Pool_Stats_t g_static_pool_stats = {0};
+
+static uint8_t g_static_pool[STATIC_POOL_SIZE] __attribute__((aligned(STATIC_POOL_ALIGNMENT)));
+static uint32_t g_static_pool_offset = 0;
+static uint8_t g_static_pool_locked = 0;
+
+static uint8_t Static_Pool_Contains(const void *ptr)
+{
+    return (const uint8_t *)ptr >= g_static_pool && (const uint8_t *)ptr < g_static_pool + STATIC_POOL_SIZE;
+}
+
+/**
+ * @brief Mark the end of start up. Later allocations are counted as late and go to the heap,
+ * where freeing them gives the memory back.
+ */
+void Static_Pool_Lock(void)
+{
+    g_static_pool_locked = 1;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    if (g_static_pool_locked)
+    {
+        __atomic_fetch_add(&g_static_pool_stats.late_allocations, 1, __ATOMIC_RELAXED);
+        return __real_malloc(size);
+    }
+    uint32_t aligned_size = (uint32_t)((size + STATIC_POOL_ALIGNMENT - 1) & ~(size_t)(STATIC_POOL_ALIGNMENT - 1));
+    // lock free bump so tasks initializing concurrently cannot hand out the same block
+    uint32_t offset = __atomic_fetch_add(&g_static_pool_offset, aligned_size, __ATOMIC_RELAXED);
+    if (offset + aligned_size > STATIC_POOL_SIZE)
+    {
+        Error_Handler(); // STATIC_POOL_SIZE too small, see g_static_pool_stats.used
+        return NULL;
+    }
+    __atomic_fetch_add(&g_static_pool_stats.used, aligned_size, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_static_pool_stats.allocations, 1, __ATOMIC_RELAXED);
+    return &g_static_pool[offset];
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    if (size != 0 && count > SIZE_MAX / size)
+    {
+        return NULL; // count * size overflows
+    }
+    if (g_static_pool_locked)
+    {
+        __atomic_fetch_add(&g_static_pool_stats.late_allocations, 1, __ATOMIC_RELAXED);
+        return __real_calloc(count, size);
+    }
+    void *ptr = __wrap_malloc(count * size);
+    if (ptr != NULL)
+    {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+    {
+        return __wrap_malloc(size);
+    }
+    if (Static_Pool_Contains(ptr))
+    {
+        Error_Handler(); // pool blocks do not record their size and cannot grow
+        return NULL;
+    }
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    if (Static_Pool_Contains(ptr))
+    {
+        __atomic_fetch_add(&g_static_pool_stats.ignored_frees, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    __real_free(ptr);
+}
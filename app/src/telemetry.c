@@ -0,0 +1,382 @@
+#include "telemetry.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "usart.h"
+#include "cobs_frame.h"
+#include "cycle_counter.h"
+
+#define TELEMETRY_HEADER_SIZE (7) // type, sequence, tick
+#define TELEMETRY_CRC_SIZE (2)
+#define TELEMETRY_MAX_RAW_SIZE (TELEMETRY_HEADER_SIZE + 1 + TELEMETRY_MAX_CHANNELS * (2 + TELEMETRY_MAX_NAME_LENGTH) + TELEMETRY_CRC_SIZE)
+#define TELEMETRY_MAX_ENCODED_SIZE COBS_FRAME_ENCODED_SIZE(TELEMETRY_MAX_RAW_SIZE)
+#define TELEMETRY_RING_MASK (TELEMETRY_RING_SIZE - 1)
+
+// sample frames get what the budget leaves after Telemetry_Send, sized for every channel 4 bytes
+#define TELEMETRY_SAMPLE_BYTE_RATE (TELEMETRY_BAUD_RATE / 10 * TELEMETRY_LOAD / 100 - TELEMETRY_SEND_BYTE_RATE)
+#define TELEMETRY_MAX_SAMPLE_SIZE COBS_FRAME_ENCODED_SIZE(TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_CHANNELS * 4 + TELEMETRY_CRC_SIZE)
+#define TELEMETRY_DECIMATION ((TELEMETRY_MAX_SAMPLE_SIZE * 1000 / TELEMETRY_PERIOD + TELEMETRY_SAMPLE_BYTE_RATE - 1) / TELEMETRY_SAMPLE_BYTE_RATE)
+
+_Static_assert((TELEMETRY_RING_SIZE & TELEMETRY_RING_MASK) == 0, "TELEMETRY_RING_SIZE must be a power of two");
+_Static_assert(TELEMETRY_MAX_ENCODED_SIZE < TELEMETRY_RING_SIZE, "schema frame does not fit the ring");
+_Static_assert(TELEMETRY_SAMPLE_BYTE_RATE > 0, "Telemetry_Send takes the whole huart6 budget");
+_Static_assert(TELEMETRY_MAX_SAMPLE_SIZE * 1000 / (TELEMETRY_PERIOD * TELEMETRY_DECIMATION) <= TELEMETRY_SAMPLE_BYTE_RATE,
+               "sample frames overrun huart6 at TELEMETRY_BAUD_RATE");
+
+static const uint8_t g_telemetry_type_size[] = {
+    [TELEMETRY_U8] = 1,
+    [TELEMETRY_I8] = 1,
+    [TELEMETRY_U16] = 2,
+    [TELEMETRY_I16] = 2,
+    [TELEMETRY_U32] = 4,
+    [TELEMETRY_I32] = 4,
+    [TELEMETRY_F32] = 4,
+};
+
+Telemetry_Stats_t g_telemetry_stats = {0};
+
+static Telemetry_Channel_t g_telemetry_channels[TELEMETRY_MAX_CHANNELS];
+static uint8_t g_telemetry_channel_count = 0;
+static uint8_t g_telemetry_started = 0;
+static uint16_t g_telemetry_sequence = 0;
+static uint16_t g_telemetry_decimation_counter = 0;
+
+// written only by the telemetry task, the DMA reads [tail, tail + dma_length)
+static uint8_t g_telemetry_ring[TELEMETRY_RING_SIZE];
+static uint32_t g_telemetry_ring_head = 0;
+static uint32_t g_telemetry_ring_tail = 0;
+static uint16_t g_telemetry_dma_length = 0;
+
+static uint8_t g_telemetry_raw[TELEMETRY_MAX_RAW_SIZE];
+static uint8_t g_telemetry_encoded[TELEMETRY_MAX_ENCODED_SIZE];
+
+// single slot mailbox so lower priority tasks can log without touching the ring
+static char g_telemetry_log_buffer[TELEMETRY_MAX_LOG_LENGTH];
+static uint8_t g_telemetry_log_pending = 0;
+
+// and a queue of whole frames of another module (the Orin link's), one sending task
+typedef struct
+{
+    uint8_t type;
+    uint8_t timed;
+    uint16_t length;
+    uint8_t body[TELEMETRY_MAX_SEND_LENGTH];
+} Telemetry_Send_Slot_t;
+
+static Telemetry_Send_Slot_t g_telemetry_send_slots[TELEMETRY_SEND_SLOTS];
+static uint32_t g_telemetry_send_head = 0; // written by the sender
+static uint32_t g_telemetry_send_tail = 0; // written by the telemetry task
+
+// the last Telemetry_Send_Timed frame: taken by the sender, where it ends in the ring, when that left
+static uint32_t g_telemetry_timed_taken = 0; // written by the sender
+static uint32_t g_telemetry_timed_queued = 0;
+static uint32_t g_telemetry_timed_end = 0;
+static uint32_t g_telemetry_timed_cycles = 0;
+static uint32_t g_telemetry_timed_sent = 0; // g_telemetry_timed_taken of the frame g_telemetry_timed_cycles is for
+
+static uint16_t Telemetry_Begin_Frame(Telemetry_Frame_e type)
+{
+    uint32_t tick = xTaskGetTickCount();
+    g_telemetry_raw[0] = type;
+    memcpy(&g_telemetry_raw[1], &g_telemetry_sequence, sizeof(g_telemetry_sequence));
+    memcpy(&g_telemetry_raw[3], &tick, sizeof(tick));
+    return TELEMETRY_HEADER_SIZE;
+}
+
+/**
+ * @brief Checksum, encode and queue the frame in g_telemetry_raw, dropping it whole if the ring is full.
+ */
+static uint8_t Telemetry_Queue_Frame(uint16_t length)
+{
+    uint16_t crc = COBS_Frame_CRC16(g_telemetry_raw, length);
+    g_telemetry_raw[length++] = (uint8_t)(crc & 0xFF);
+    g_telemetry_raw[length++] = (uint8_t)(crc >> 8);
+    uint16_t encoded_length = COBS_Frame_Encode(g_telemetry_raw, length, g_telemetry_encoded);
+
+    uint32_t pending = g_telemetry_ring_head - g_telemetry_ring_tail;
+    if (pending + encoded_length > TELEMETRY_RING_SIZE)
+    {
+        g_telemetry_stats.dropped_frames++;
+        return 0;
+    }
+
+    uint32_t start = g_telemetry_ring_head & TELEMETRY_RING_MASK;
+    uint32_t first = TELEMETRY_RING_SIZE - start;
+    if (first > encoded_length)
+    {
+        first = encoded_length;
+    }
+    memcpy(&g_telemetry_ring[start], g_telemetry_encoded, first);
+    memcpy(g_telemetry_ring, &g_telemetry_encoded[first], encoded_length - first);
+    g_telemetry_ring_head += encoded_length;
+    g_telemetry_sequence++;
+
+    pending += encoded_length;
+    if (pending > g_telemetry_stats.ring_high_water)
+    {
+        g_telemetry_stats.ring_high_water = (uint16_t)pending;
+    }
+    return 1;
+}
+
+static void Telemetry_Queue_Schema(void)
+{
+    uint16_t length = Telemetry_Begin_Frame(TELEMETRY_FRAME_SCHEMA);
+    g_telemetry_raw[length++] = g_telemetry_channel_count;
+    for (uint8_t i = 0; i < g_telemetry_channel_count; i++)
+    {
+        uint8_t name_length = (uint8_t)strnlen(g_telemetry_channels[i].name, TELEMETRY_MAX_NAME_LENGTH);
+        g_telemetry_raw[length++] = g_telemetry_channels[i].type;
+        g_telemetry_raw[length++] = name_length;
+        memcpy(&g_telemetry_raw[length], g_telemetry_channels[i].name, name_length);
+        length += name_length;
+    }
+    Telemetry_Queue_Frame(length);
+}
+
+static void Telemetry_Queue_Sample(void)
+{
+    uint16_t length = Telemetry_Begin_Frame(TELEMETRY_FRAME_SAMPLE);
+    for (uint8_t i = 0; i < g_telemetry_channel_count; i++)
+    {
+        uint8_t size = g_telemetry_type_size[g_telemetry_channels[i].type];
+        memcpy(&g_telemetry_raw[length], g_telemetry_channels[i].source, size);
+        length += size;
+    }
+    if (Telemetry_Queue_Frame(length))
+    {
+        g_telemetry_stats.frames++;
+    }
+}
+
+static void Telemetry_Queue_Log(void)
+{
+    if (!__atomic_load_n(&g_telemetry_log_pending, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+    uint16_t length = Telemetry_Begin_Frame(TELEMETRY_FRAME_LOG);
+    uint16_t text_length = (uint16_t)strnlen(g_telemetry_log_buffer, TELEMETRY_MAX_LOG_LENGTH);
+    memcpy(&g_telemetry_raw[length], g_telemetry_log_buffer, text_length);
+    if (Telemetry_Queue_Frame(length + text_length))
+    {
+        __atomic_store_n(&g_telemetry_log_pending, 0, __ATOMIC_RELEASE);
+    }
+}
+
+static void Telemetry_Queue_Send(void)
+{
+    uint32_t head = __atomic_load_n(&g_telemetry_send_head, __ATOMIC_ACQUIRE);
+    while (g_telemetry_send_tail != head)
+    {
+        const Telemetry_Send_Slot_t *slot = &g_telemetry_send_slots[g_telemetry_send_tail % TELEMETRY_SEND_SLOTS];
+        uint16_t length = Telemetry_Begin_Frame(slot->type);
+        memcpy(&g_telemetry_raw[length], slot->body, slot->length);
+        if (!Telemetry_Queue_Frame(length + slot->length))
+        {
+            g_telemetry_stats.dropped_sends++;
+        }
+        else if (slot->timed)
+        {
+            g_telemetry_timed_queued = g_telemetry_send_tail + 1; // nonzero
+            g_telemetry_timed_end = g_telemetry_ring_head;
+        }
+        __atomic_store_n(&g_telemetry_send_tail, g_telemetry_send_tail + 1, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief When the timed frame ends, if the transfer just started at cycles carries it. The bytes
+ * go out back to back at TELEMETRY_BAUD_RATE from the start of the transfer.
+ */
+static void Telemetry_Time_Timed(uint32_t cycles)
+{
+    uint32_t end = g_telemetry_timed_end - g_telemetry_ring_tail;
+    if (g_telemetry_timed_queued == 0 || end == 0 || end > g_telemetry_dma_length)
+    {
+        return;
+    }
+    g_telemetry_timed_cycles = cycles + (uint32_t)((uint64_t)end * 10U * CYCLE_COUNTER_HZ / TELEMETRY_BAUD_RATE);
+    __atomic_store_n(&g_telemetry_timed_sent, g_telemetry_timed_queued, __ATOMIC_RELEASE);
+    g_telemetry_timed_queued = 0;
+}
+
+/**
+ * @brief Retire the finished DMA transfer and start the next contiguous run of the ring.
+ * Polls gState instead of hooking HAL_UART_TxCpltCallback, which the BSP may already own.
+ */
+static void Telemetry_Flush(void)
+{
+    if (g_telemetry_dma_length != 0)
+    {
+        if (huart6.gState != HAL_UART_STATE_READY)
+        {
+            return;
+        }
+        g_telemetry_ring_tail += g_telemetry_dma_length;
+        g_telemetry_dma_length = 0;
+    }
+
+    uint32_t pending = g_telemetry_ring_head - g_telemetry_ring_tail;
+    if (pending == 0)
+    {
+        return;
+    }
+    uint32_t start = g_telemetry_ring_tail & TELEMETRY_RING_MASK;
+    uint16_t length = (uint16_t)((pending < TELEMETRY_RING_SIZE - start) ? pending : TELEMETRY_RING_SIZE - start);
+    uint32_t cycles = Cycle_Counter_Get();
+    if (HAL_UART_Transmit_DMA(&huart6, &g_telemetry_ring[start], length) == HAL_OK)
+    {
+        g_telemetry_dma_length = length;
+        g_telemetry_stats.dma_transfers++;
+        Telemetry_Time_Timed(cycles);
+    }
+}
+
+void Telemetry_Init(void)
+{
+    if (huart6.Init.BaudRate != TELEMETRY_BAUD_RATE)
+    {
+        huart6.Init.BaudRate = TELEMETRY_BAUD_RATE; // before any transfer, the Orin link starts its receive later
+        HAL_UART_Init(&huart6);
+    }
+    g_telemetry_channel_count = 0;
+    g_telemetry_started = 0;
+    g_telemetry_ring_head = 0;
+    g_telemetry_ring_tail = 0;
+    g_telemetry_dma_length = 0;
+    memset(&g_telemetry_stats, 0, sizeof(g_telemetry_stats));
+}
+
+/**
+ * @brief Add a channel to the sample frame. The source is read every sample, so it must
+ * stay valid for the life of the program. Channels are fixed once Telemetry_Start is called.
+ * @return 1 if registered, 0 if full, started or the type is unknown
+ */
+uint8_t Telemetry_Register(const char *name, Telemetry_Type_e type, const void *source)
+{
+    if (g_telemetry_started || g_telemetry_channel_count >= TELEMETRY_MAX_CHANNELS || type > TELEMETRY_F32)
+    {
+        return 0;
+    }
+    g_telemetry_channels[g_telemetry_channel_count++] = (Telemetry_Channel_t){
+        .name = name,
+        .type = type,
+        .source = source,
+    };
+    return 1;
+}
+
+/**
+ * @brief Freeze the channel list and begin sampling. Call once every task has registered.
+ */
+void Telemetry_Start(void)
+{
+    uint16_t raw_size = TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE;
+    for (uint8_t i = 0; i < g_telemetry_channel_count; i++)
+    {
+        raw_size += g_telemetry_type_size[g_telemetry_channels[i].type];
+    }
+    g_telemetry_stats.frame_size = COBS_FRAME_ENCODED_SIZE(raw_size);
+    g_telemetry_stats.sample_rate = 1000 / (TELEMETRY_PERIOD * TELEMETRY_DECIMATION);
+    __atomic_store_n(&g_telemetry_started, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief printf style text frame for the host decoder, integer formats only.
+ * @return 1 if queued, 0 if the previous line has not gone out yet (retry next period)
+ */
+uint8_t Telemetry_Log(const char *format, ...)
+{
+    if (__atomic_load_n(&g_telemetry_log_pending, __ATOMIC_ACQUIRE))
+    {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    vsnprintf(g_telemetry_log_buffer, sizeof(g_telemetry_log_buffer), format, args);
+    va_end(args);
+    __atomic_store_n(&g_telemetry_log_pending, 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+/**
+ * @brief Put a frame of another module on the stream, framed like the telemetry's own with the
+ * next sequence number. The body is copied, the frame goes out with the next telemetry period.
+ * Only one task may send.
+ * @return 1 if taken, 0 if TELEMETRY_SEND_SLOTS frames are still waiting or the body is too long
+ */
+static uint8_t Telemetry_Send_Slot(uint8_t type, const void *body, uint16_t length, uint8_t timed)
+{
+    uint32_t head = g_telemetry_send_head;
+    if (length > TELEMETRY_MAX_SEND_LENGTH ||
+        head - __atomic_load_n(&g_telemetry_send_tail, __ATOMIC_ACQUIRE) >= TELEMETRY_SEND_SLOTS)
+    {
+        return 0;
+    }
+    Telemetry_Send_Slot_t *slot = &g_telemetry_send_slots[head % TELEMETRY_SEND_SLOTS];
+    slot->type = type;
+    slot->timed = timed;
+    slot->length = length;
+    memcpy(slot->body, body, length);
+    if (timed)
+    {
+        g_telemetry_timed_taken = head + 1;
+    }
+    __atomic_store_n(&g_telemetry_send_head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+uint8_t Telemetry_Send(uint8_t type, const void *body, uint16_t length)
+{
+    return Telemetry_Send_Slot(type, body, length, 0);
+}
+
+/**
+ * @brief Telemetry_Send, and note when the frame's last byte leaves huart6 for
+ * Telemetry_Get_Timed_Cycles. Only the last timed frame is followed.
+ */
+uint8_t Telemetry_Send_Timed(uint8_t type, const void *body, uint16_t length)
+{
+    return Telemetry_Send_Slot(type, body, length, 1);
+}
+
+/**
+ * @brief Cycle counter when the last Telemetry_Send_Timed frame's delimiter left the line, known
+ * once its DMA transfer has started. Sending task only.
+ * @return 1 if known, 0 if it is still in the ring or was dropped
+ */
+uint8_t Telemetry_Get_Timed_Cycles(uint32_t *cycles)
+{
+    if (g_telemetry_timed_taken == 0 ||
+        __atomic_load_n(&g_telemetry_timed_sent, __ATOMIC_ACQUIRE) != g_telemetry_timed_taken)
+    {
+        return 0;
+    }
+    *cycles = g_telemetry_timed_cycles;
+    return 1;
+}
+
+void Telemetry_Task_Loop(void)
+{
+    if (!__atomic_load_n(&g_telemetry_started, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+    Telemetry_Queue_Log();
+    Telemetry_Queue_Send();
+    if (++g_telemetry_decimation_counter >= TELEMETRY_DECIMATION)
+    {
+        g_telemetry_decimation_counter = 0;
+        if (g_telemetry_stats.frames % TELEMETRY_SCHEMA_INTERVAL == 0)
+        {
+            Telemetry_Queue_Schema();
+        }
+        Telemetry_Queue_Sample();
+    }
+    Telemetry_Flush();
+}
@@ -0,0 +1,41 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS kernel types used by app/.
+ * The tick is the simulator's virtual clock, 1 tick = 1 ms like configTICK_RATE_HZ on the board.
+ */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef TickType_t portTickType;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef void *TaskHandle_t;
+
+#define configSUPPORT_STATIC_ALLOCATION 1
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+
+typedef struct
+{
+    uint8_t reserved[96];
+} StaticTask_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS (pdTRUE)
+#define pdFAIL (pdFALSE)
+
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+// there is no heap_4 heap on the host, both report 0
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#endif // INC_FREERTOS_H
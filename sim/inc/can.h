@@ -0,0 +1,9 @@
+#ifndef __CAN_H__
+#define __CAN_H__
+
+#include "main.h"
+
+extern CAN_HandleTypeDef hcan1;
+extern CAN_HandleTypeDef hcan2;
+
+#endif // __CAN_H__
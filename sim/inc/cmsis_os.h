@@ -0,0 +1,78 @@
+/**
+ * @file cmsis_os.h
+ * @brief Host stand-in for the CMSIS-RTOS v1 wrapper.
+ * osThreadCreate only records the thread; the simulator steps the task loops itself on the virtual clock.
+ */
+#ifndef CMSIS_OS_H_
+#define CMSIS_OS_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef enum
+{
+    osPriorityIdle = -3,
+    osPriorityLow = -2,
+    osPriorityBelowNormal = -1,
+    osPriorityNormal = 0,
+    osPriorityAboveNormal = +1,
+    osPriorityHigh = +2,
+    osPriorityRealtime = +3,
+    osPriorityError = 0x84
+} osPriority;
+
+typedef void (*os_pthread)(void const *argument);
+typedef TaskHandle_t osThreadId;
+typedef StaticTask_t osStaticThreadDef_t;
+
+typedef struct os_thread_def
+{
+    char *name;
+    os_pthread pthread;
+    osPriority tpriority;
+    uint32_t instances;
+    uint32_t stacksize;
+    uint32_t *buffer;
+    osStaticThreadDef_t *controlblock;
+} osThreadDef_t;
+
+#define osThreadDef(name, thread, priority, instances, stacksz) \
+    const osThreadDef_t os_thread_def_##name = {#name, (thread), (priority), (instances), (stacksz), NULL, NULL}
+#define osThreadStaticDef(name, thread, priority, instances, stacksz, buffer, control) \
+    const osThreadDef_t os_thread_def_##name = {#name, (thread), (priority), (instances), (stacksz), (buffer), (control)}
+#define osThread(name) &os_thread_def_##name
+
+osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument);
+
+typedef enum
+{
+    osOK = 0,
+    osErrorParameter = 0x80,
+    osErrorResource = 0x81,
+} osStatus;
+
+typedef enum
+{
+    osTimerOnce = 0,
+    osTimerPeriodic = 1
+} os_timer_type;
+
+typedef void (*os_ptimer)(void const *argument);
+typedef struct os_timer_cb *osTimerId;
+
+typedef struct os_timer_def
+{
+    os_ptimer ptimer;
+    void *controlblock;
+} osTimerDef_t;
+
+// software timers fire from Sim_Step on the virtual clock, before the task loops of that tick
+#define osTimerDef(name, function) const osTimerDef_t os_timer_def_##name = {(function), NULL}
+#define osTimer(name) &os_timer_def_##name
+
+osTimerId osTimerCreate(const osTimerDef_t *timer_def, os_timer_type type, void *argument);
+osStatus osTimerStart(osTimerId timer_id, uint32_t millisec);
+osStatus osTimerStop(osTimerId timer_id);
+
+#endif // CMSIS_OS_H_
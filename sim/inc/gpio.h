@@ -0,0 +1,6 @@
+#ifndef __GPIO_H__
+#define __GPIO_H__
+
+#include "main.h"
+
+#endif // __GPIO_H__
@@ -0,0 +1,247 @@
+/**
+ * @file sim.h
+ * @brief Software-in-the-loop (SIL) harness for running app/ on a host.
+ *
+ * The harness owns a virtual millisecond clock. Each Sim_Step advances it by one tick,
+ * updates the plant, delivers CAN feedback, and runs every task loop whose period has
+ * elapsed, mirroring the schedule in robot_tasks.h. Nothing waits on wall time, so
+ * control cycles run as fast as the host allows, except with SocketCAN (-c) where the
+ * plant is another process and ticks are paced at 1 ms of wall time.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bsp_can.h"
+#include "usart.h"
+
+#define SIM_MAX_TASKS (12)
+#define SIM_MAX_TIMERS (4)
+#define SIM_MAX_CAN_BUS (2)
+#define SIM_CAN_MAILBOXES (3)
+#define SIM_CAN_BITRATE (1000000U)  // bit/s, both buses
+#define SIM_CAN_LOAD_WINDOW (1000)  // ms the peak wire load is taken over
+#define SIM_PLANT_MODULES (4)
+#define SIM_STEP_MAX_SAMPLES (2000) // ms a step response is recorded for
+#define SIM_DT (0.001f)             // s per tick
+
+typedef struct
+{
+    const char *name;
+    void (*loop)(void);
+    uint32_t period_ms;
+    void **event_handle; // with EVENT_DRIVEN_CONTROL: run when this thread is notified, period_ms becomes the timeout
+    uint32_t last_run_tick;
+    uint64_t runs;
+    double wall_time; // s spent inside loop() across all runs
+} Sim_Task_t;
+
+typedef struct
+{
+    const char *name;
+    const char *description;
+    void (*init)(void);
+    void (*update)(uint32_t tick); // drives g_remote and any other inputs before the tasks run
+    void (*report)(void);          // prints the scenario's metrics at exit, may be NULL
+} Sim_Scenario_t;
+
+typedef struct
+{
+    uint64_t frames_tx[SIM_MAX_CAN_BUS];
+    uint64_t frames_rx[SIM_MAX_CAN_BUS];
+    uint64_t mailbox_full[SIM_MAX_CAN_BUS];
+    uint64_t send_errors[SIM_MAX_CAN_BUS]; // SocketCAN writes that failed (interface queue full)
+    uint64_t wire_bits[SIM_MAX_CAN_BUS];   // TX and RX, stuff bits included
+    double peak_load[SIM_MAX_CAN_BUS];     // %, most wire bits in a SIM_CAN_LOAD_WINDOW
+    double max_backlog_us[SIM_MAX_CAN_BUS]; // longest the wire was behind on what it was given
+} Sim_CAN_Stats_t;
+
+typedef struct
+{
+    uint64_t tx_bytes; // huart6, on the line
+} Sim_UART_Stats_t;
+
+// Rigid-body state of the plant, world frame unless noted, angles counter-clockwise
+typedef struct
+{
+    float x, y;                // m
+    float heading;             // rad, chassis
+    float v_x, v_y;            // m/s
+    float omega;               // rad/s, chassis
+    float module_angle[SIM_PLANT_MODULES]; // rad, chassis frame
+    float module_rate[SIM_PLANT_MODULES];  // rad/s
+    float wheel_speed[SIM_PLANT_MODULES];  // m/s at the contact patch
+    float wheel_slip[SIM_PLANT_MODULES];   // m/s, contact patch over the floor, both directions
+    float gimbal_yaw;          // rad
+    float gimbal_yaw_rate;     // rad/s
+    float gimbal_pitch;        // rad, up positive
+    float gimbal_pitch_rate;   // rad/s
+    float feeder_angle;        // rad at the output, forward positive
+    float feeder_jam;          // rad at the output the feeder stops at while jammed
+    uint8_t feeder_jammed;
+    uint8_t feeder_jam_reached; // the feeder has run into the jam, backing off frees it
+} Sim_Plant_State_t;
+
+// What the plant took to do it, over the whole run
+typedef struct
+{
+    double scrub_energy;        // J dissipated by wheels sliding sideways
+    double slip_energy;         // J dissipated by wheels spinning or skidding
+    double chassis_energy;      // J drawn by the drive and azimuth motors
+    double azimuth_charge;      // A s through the azimuth motors
+    float chassis_power;        // W, drive and azimuth motors, last update
+    float peak_chassis_power;   // W, over one update
+    float peak_chassis_current; // A, sum of the drive and azimuth motors
+    uint32_t feeder_jams;       // wedged by the scenario
+    uint32_t feeder_jams_cleared;
+} Sim_Plant_Stats_t;
+
+// Step response of one signal, recorded for up to SIM_STEP_MAX_SAMPLES ms after the step
+typedef struct
+{
+    const char *name;
+    const char *unit;
+    uint32_t start_tick;
+    uint32_t window_ms;
+    float initial;
+    float target;
+    float samples[SIM_STEP_MAX_SAMPLES];
+    uint32_t count;
+} Sim_Step_Response_t;
+
+// Error of a signal tracking a moving reference
+typedef struct
+{
+    const char *name;
+    const char *unit;
+    uint64_t count;
+    double sum_squares;
+    float max_abs;
+} Sim_Tracking_t;
+
+// Virtual clock, Sim_Get_Time is in s and follows the wall clock when paced in real time
+uint32_t Sim_Get_Tick(void);
+double Sim_Get_Time(void);
+uint8_t Sim_Is_Real_Time(void);
+void Sim_Step(void);
+
+// Software timers due at tick, called by Sim_Step
+void Sim_Timers_Update(uint32_t tick);
+
+// Task notifications, see Sim_Step for how they are consumed
+uint32_t Sim_Take_Notification(void *task_handle);
+
+// CAN bus stand-in
+typedef void (*Sim_CAN_Frame_Callback_t)(uint8_t can_bus, uint16_t can_id, const uint8_t data[8]);
+void Sim_CAN_Receive(uint8_t can_bus, uint16_t rx_id, const uint8_t data[8]);
+const Sim_CAN_Stats_t *Sim_CAN_Get_Stats(void);
+// candump -l style log of every frame sent and received, timestamped with Sim_Get_Time
+int Sim_CAN_Open_Trace(const char *path);
+void Sim_CAN_Log_Frame(FILE *log, double time_s, const char *interface, uint16_t can_id, const uint8_t data[8]);
+
+// SocketCAN transport (Linux only): bus n is <prefix><n-1>, e.g. vcan0/vcan1. While open,
+// CAN_Transmit writes to the interfaces instead of the in-process plant
+int Sim_SocketCAN_Open(const char *prefix);
+void Sim_SocketCAN_Close(void);
+uint8_t Sim_SocketCAN_Is_Open(void);
+const char *Sim_SocketCAN_Interface(uint8_t can_bus);
+int Sim_SocketCAN_Send(uint8_t can_bus, uint16_t can_id, const uint8_t data[8]);
+int Sim_SocketCAN_Poll(Sim_CAN_Frame_Callback_t on_frame);
+
+// huart6 bytes (telemetry or DEBUG_PRINTF) go to path, "-" for stdout; dropped if never opened.
+// A transmit DMA drains at huart6's baud rate in Sim_UART_Update, called by Sim_Step
+int Sim_UART_Open_Output(const char *path);
+void Sim_UART_Receive(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t length);
+void Sim_UART_Update(void);
+const Sim_UART_Stats_t *Sim_UART_Get_Stats(void);
+
+// huart6 over a pseudo-terminal (Linux only), for a host stand-in of the Orin: transmits are
+// written to it and what the stand-in writes is delivered to huart6's receive DMA every tick
+const char *Sim_PTY_Open(void);
+void Sim_PTY_Close(void);
+uint8_t Sim_PTY_Is_Open(void);
+void Sim_PTY_Write(const uint8_t *data, uint16_t length);
+void Sim_PTY_Poll(void);
+
+// Orin stand-in on huart6: aim frames as the Orin link expects them, answers to its time sync
+// requests on a clock of its own, and the error of the link's estimate of that clock. It is
+// given the time the MCU's bytes crossed the line, and Sim_Orin_Poll, called by Sim_Step,
+// delivers an answer once it has crossed back
+void Sim_Orin_Send_Aim(float yaw_deg, float pitch_deg, uint8_t target_valid, uint16_t age_ms);
+void Sim_Orin_On_Transmit(const uint8_t *data, uint16_t length, double time, double byte_time);
+void Sim_Orin_Poll(void);
+void Sim_Orin_Update(uint32_t tick);
+void Sim_Orin_Report(void);
+
+// Referee stand-in, measures the plant's chassis power and keeps the buffer energy like the
+// referee system does: the power above the limit drains it, below the limit it refills
+typedef struct
+{
+    float power_limit;      // W, scenarios may change it
+    float buffer_max;       // J
+    float buffer;           // J
+    float min_buffer;       // J over the run
+    uint32_t empty_ms;      // ms with the buffer at 0, the referee penalizes these
+    uint32_t samples;
+} Sim_Referee_t;
+
+extern Sim_Referee_t g_sim_referee;
+
+// Supercap board stand-in between the battery and the chassis: with its output enabled the cap
+// supplies what the chassis draws above the referee limit, and spare power below the limit
+// charges it. The referee measures what the board draws
+typedef struct
+{
+    float energy;           // J stored, scenarios may change it
+    float energy_max;       // J at 100 %
+    float input_power;      // W the board draws, what the referee measures
+    float supplied;         // J into the chassis over the run
+    float charged;          // J into the cap over the run
+    uint8_t output_enabled; // last supercap_enabled_flag on the bus
+    uint32_t output_ms;     // ms with the output enabled
+} Sim_Supercap_t;
+
+extern Sim_Supercap_t g_sim_supercap;
+
+// Plant stand-in
+void Sim_Plant_Init(void);
+void Sim_Plant_On_Transmit(uint8_t can_bus, uint16_t tx_id, const uint8_t data[8]);
+void Sim_Plant_Update(float dt);
+void Sim_Plant_Set_Wheel_Friction(int module, float friction);
+void Sim_Plant_Jam_Feeder(float distance);
+void Sim_Plant_Set_Motor_Online(uint8_t can_bus, uint16_t rx_id, uint8_t online);
+const Sim_Plant_State_t *Sim_Plant_Get_State(void);
+const Sim_Plant_Stats_t *Sim_Plant_Get_Stats(void);
+
+// g_imu from the plant's gimbal attitude, called after every plant update
+void Sim_IMU_Update(void);
+// Referee_Robot_State from the supercap board's input power, called after every plant update
+void Sim_Referee_Init(void);
+void Sim_Referee_Update(uint32_t tick);
+// supercap board on the plant's chassis power, called before Sim_Referee_Update
+void Sim_Supercap_Init(void);
+void Sim_Supercap_On_Transmit(uint8_t can_bus, uint16_t tx_id, const uint8_t data[8]);
+void Sim_Supercap_Update(uint32_t tick);
+
+// Scenario metrics
+void Sim_Step_Response_Begin(Sim_Step_Response_t *response, uint32_t tick, float initial, float target);
+void Sim_Step_Response_Sample(Sim_Step_Response_t *response, uint32_t tick, float value);
+void Sim_Step_Response_Report(const Sim_Step_Response_t *response);
+void Sim_Tracking_Sample(Sim_Tracking_t *tracking, float error);
+void Sim_Tracking_Report(const Sim_Tracking_t *tracking);
+// chassis odometry against the plant, in every scenario, called after the tasks
+void Sim_Odometry_Update(uint32_t tick);
+void Sim_Odometry_Report(void);
+
+// Stress checks, return 0 on success
+int Sim_Stress_Snapshot(uint32_t duration_ms);
+int Sim_Stress_Power_Replay(const char *trace_path);
+int Sim_Stress_Aim_Replay(const char *trace_path);
+
+// Scenarios
+const Sim_Scenario_t *Sim_Find_Scenario(const char *name);
+void Sim_List_Scenarios(void);
+
+#endif // SIM_H
@@ -0,0 +1,8 @@
+#ifndef __SPI_H__
+#define __SPI_H__
+
+#include "main.h"
+
+extern SPI_HandleTypeDef hspi1;
+
+#endif // __SPI_H__
@@ -0,0 +1,138 @@
+/**
+ * @file stm32f4xx_hal.h
+ * @brief Host stand-in for the STM32F4 HAL used by the software-in-the-loop build.
+ * Only the types, macros and calls that control-base and app/ touch are provided.
+ */
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif
+#ifndef __packed
+#define __packed __attribute__((packed))
+#endif
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define CAN_ID_STD (0x00000000U)
+#define CAN_ID_EXT (0x00000004U)
+#define CAN_RTR_DATA (0x00000000U)
+#define CAN_RTR_REMOTE (0x00000002U)
+
+typedef struct
+{
+    uint32_t StdId;
+    uint32_t ExtId;
+    uint32_t IDE;
+    uint32_t RTR;
+    uint32_t DLC;
+    uint32_t TransmitGlobalTime;
+} CAN_TxHeaderTypeDef;
+
+typedef struct
+{
+    uint32_t StdId;
+    uint32_t ExtId;
+    uint32_t IDE;
+    uint32_t RTR;
+    uint32_t DLC;
+    uint32_t Timestamp;
+    uint32_t FilterMatchIndex;
+} CAN_RxHeaderTypeDef;
+
+typedef struct
+{
+    uint8_t bus;
+} CAN_HandleTypeDef;
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(const CAN_HandleTypeDef *hcan);
+
+typedef enum
+{
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY_TX = 0x21U,
+} HAL_UART_StateTypeDef;
+
+#define DMA_NORMAL (0x00000000U)
+#define DMA_CIRCULAR (0x00000100U)
+
+typedef struct
+{
+    struct
+    {
+        uint32_t Mode;
+    } Init;
+    volatile uint32_t counter; // NDTR, bytes left before the buffer wraps
+    uint8_t *buffer;           // of the running receive, written by Sim_UART_Receive
+    uint16_t size;
+} DMA_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__) ((__HANDLE__)->counter)
+
+typedef struct
+{
+    struct
+    {
+        uint32_t BaudRate; // huart6 transmit DMA drains at this in the SIL, 0 sends at once
+    } Init;
+    uint8_t port;
+    volatile HAL_UART_StateTypeDef gState; // BUSY_TX while a transmit DMA drains
+    DMA_HandleTypeDef *hdmarx;
+} UART_HandleTypeDef;
+
+typedef struct
+{
+    uint32_t PSC;
+    uint32_t ARR;
+    uint32_t CCR1;
+    uint32_t CCR2;
+    uint32_t CCR3;
+    uint32_t CCR4;
+} TIM_TypeDef;
+
+typedef struct
+{
+    uint8_t timer;
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+#define TIM_CHANNEL_1 (0x00000000U)
+#define TIM_CHANNEL_2 (0x00000004U)
+#define TIM_CHANNEL_3 (0x00000008U)
+#define TIM_CHANNEL_4 (0x0000000CU)
+
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__) ((__HANDLE__)->Instance->ARR = (__AUTORELOAD__))
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__) \
+    (*(&(__HANDLE__)->Instance->CCR1 + ((__CHANNEL__) >> 2U)) = (__COMPARE__))
+
+typedef struct
+{
+    uint8_t port;
+} SPI_HandleTypeDef;
+
+typedef struct
+{
+    uint8_t port;
+} I2C_HandleTypeDef;
+
+uint32_t HAL_GetTick(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+void HAL_Delay(uint32_t Delay);
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+
+#endif // STM32F4XX_HAL_H
@@ -0,0 +1,8 @@
+#ifndef __TIM_H__
+#define __TIM_H__
+
+#include "main.h"
+
+extern TIM_HandleTypeDef htim4;
+
+#endif // __TIM_H__
@@ -0,0 +1,10 @@
+#ifndef __USART_H__
+#define __USART_H__
+
+#include "main.h"
+
+extern UART_HandleTypeDef huart1;
+extern UART_HandleTypeDef huart3;
+extern UART_HandleTypeDef huart6;
+
+#endif // __USART_H__
@@ -0,0 +1,209 @@
+/**
+ * @file sim_plant_main.c
+ * @brief Stand-alone motor plant on SocketCAN for the SIL firmware run with -c.
+ *
+ * Answers the DJI current frames on <prefix>0/<prefix>1 with GM6020/M3508/M2006 style
+ * feedback at 1 kHz (the plant model in sim_plant.c), and reports what it saw on the
+ * buses: command rate and period jitter per identifier, feedback sent, and bus occupancy.
+ *
+ * Usage: control-template-sil-plant [-c socketcan_prefix] [-t duration_ms] [-d candump_log]
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+
+#define SIM_PLANT_PERIOD_NS (1000000L)
+#define SIM_PLANT_MAX_IDS (8)     // command identifiers tracked per bus
+#define SIM_PLANT_FRAME_BITS (111) // 8 byte standard frame incl. IFS, no stuff bits
+#define SIM_PLANT_BITRATE (1000000.0)
+
+typedef struct
+{
+    uint16_t can_id;
+    uint64_t count;
+    double last_time;
+    double min_period;
+    double max_period;
+} Sim_Plant_ID_Stats_t;
+
+typedef struct
+{
+    uint64_t commands_rx;
+    uint64_t feedback_tx;
+    uint64_t send_errors;
+    Sim_Plant_ID_Stats_t ids[SIM_PLANT_MAX_IDS];
+    uint8_t id_count;
+} Sim_Plant_Bus_Stats_t;
+
+static Sim_Plant_Bus_Stats_t g_plant_bus_stats[SIM_MAX_CAN_BUS];
+static FILE *g_plant_trace = NULL;
+static volatile sig_atomic_t g_plant_running = 1;
+static uint32_t g_plant_tick = 0;
+
+static double Sim_Plant_Time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// the shared stand-ins in sim.h that the plant model and transport expect
+uint32_t Sim_Get_Tick(void)
+{
+    return g_plant_tick;
+}
+
+double Sim_Get_Time(void)
+{
+    return Sim_Plant_Time();
+}
+
+/**
+ * @brief Feedback from the plant model goes out on the bus instead of into device callbacks.
+ */
+void Sim_CAN_Receive(uint8_t can_bus, uint16_t rx_id, const uint8_t data[8])
+{
+    Sim_Plant_Bus_Stats_t *stats = &g_plant_bus_stats[can_bus - 1];
+    if (Sim_SocketCAN_Send(can_bus, rx_id, data) != 0)
+    {
+        stats->send_errors++;
+        return;
+    }
+    stats->feedback_tx++;
+    if (g_plant_trace != NULL)
+    {
+        Sim_CAN_Log_Frame(g_plant_trace, Sim_Plant_Time(), Sim_SocketCAN_Interface(can_bus), rx_id, data);
+    }
+}
+
+static void Sim_Plant_On_Frame(uint8_t can_bus, uint16_t can_id, const uint8_t data[8])
+{
+    double now = Sim_Plant_Time();
+    Sim_Plant_Bus_Stats_t *stats = &g_plant_bus_stats[can_bus - 1];
+    stats->commands_rx++;
+    if (g_plant_trace != NULL)
+    {
+        Sim_CAN_Log_Frame(g_plant_trace, now, Sim_SocketCAN_Interface(can_bus), can_id, data);
+    }
+
+    Sim_Plant_ID_Stats_t *id_stats = NULL;
+    for (int i = 0; i < stats->id_count; i++)
+    {
+        if (stats->ids[i].can_id == can_id)
+        {
+            id_stats = &stats->ids[i];
+        }
+    }
+    if (id_stats == NULL && stats->id_count < SIM_PLANT_MAX_IDS)
+    {
+        id_stats = &stats->ids[stats->id_count++];
+        id_stats->can_id = can_id;
+        id_stats->min_period = 1e9;
+    }
+    if (id_stats != NULL)
+    {
+        if (id_stats->count > 0)
+        {
+            double period = now - id_stats->last_time;
+            id_stats->min_period = period < id_stats->min_period ? period : id_stats->min_period;
+            id_stats->max_period = period > id_stats->max_period ? period : id_stats->max_period;
+        }
+        id_stats->last_time = now;
+        id_stats->count++;
+    }
+
+    Sim_Plant_On_Transmit(can_bus, can_id, data);
+}
+
+static void Sim_Plant_Stop(int signal_number)
+{
+    (void)signal_number;
+    g_plant_running = 0;
+}
+
+static void Sim_Plant_Report(double elapsed)
+{
+    printf("[plant] %.3f s, %u ticks\n", elapsed, g_plant_tick);
+    for (int bus = 0; bus < SIM_MAX_CAN_BUS; bus++)
+    {
+        Sim_Plant_Bus_Stats_t *stats = &g_plant_bus_stats[bus];
+        double occupancy = (stats->commands_rx + stats->feedback_tx) * SIM_PLANT_FRAME_BITS / (SIM_PLANT_BITRATE * elapsed);
+        printf("[plant]   %-6s %10llu commands  %10llu feedback  %llu send errors  occupancy %.1f%%\n",
+               Sim_SocketCAN_Interface(bus + 1), (unsigned long long)stats->commands_rx,
+               (unsigned long long)stats->feedback_tx, (unsigned long long)stats->send_errors, 100.0 * occupancy);
+        for (int i = 0; i < stats->id_count; i++)
+        {
+            Sim_Plant_ID_Stats_t *id_stats = &stats->ids[i];
+            printf("[plant]     0x%03X %10llu frames  %7.1f Hz  period %.3f..%.3f ms\n", id_stats->can_id,
+                   (unsigned long long)id_stats->count, id_stats->count / elapsed,
+                   id_stats->count > 1 ? id_stats->min_period * 1e3 : 0.0, id_stats->max_period * 1e3);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *prefix = "vcan";
+    uint32_t duration_ms = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            prefix = argv[++i];
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            duration_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            g_plant_trace = strcmp(argv[++i], "-") == 0 ? stdout : fopen(argv[i], "w");
+            if (g_plant_trace == NULL)
+            {
+                perror(argv[i]);
+                return 1;
+            }
+        }
+        else
+        {
+            printf("usage: %s [-c socketcan_prefix] [-t duration_ms] [-d candump_log]\n", argv[0]);
+            printf("  runs until -t ms have passed (0, the default, runs until Ctrl-C)\n");
+            return 1;
+        }
+    }
+
+    if (Sim_SocketCAN_Open(prefix) != 0)
+    {
+        return 1;
+    }
+    signal(SIGINT, Sim_Plant_Stop);
+    signal(SIGTERM, Sim_Plant_Stop);
+    Sim_Plant_Init();
+
+    double start = Sim_Plant_Time();
+    struct timespec next_tick;
+    clock_gettime(CLOCK_MONOTONIC, &next_tick);
+    while (g_plant_running && (duration_ms == 0 || g_plant_tick < duration_ms))
+    {
+        Sim_SocketCAN_Poll(Sim_Plant_On_Frame);
+        Sim_Plant_Update(SIM_PLANT_PERIOD_NS * 1e-9f);
+        g_plant_tick++;
+
+        next_tick.tv_nsec += SIM_PLANT_PERIOD_NS;
+        if (next_tick.tv_nsec >= 1000000000L)
+        {
+            next_tick.tv_nsec -= 1000000000L;
+            next_tick.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_tick, NULL);
+    }
+
+    Sim_Plant_Report(Sim_Plant_Time() - start);
+    Sim_SocketCAN_Close();
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file sim_aim_replay.c
+ * @brief Host check for app/src/aim_tracker.c driven by a recorded auto aim trace.
+ *
+ * The trace is tools/telemetry_decode.py CSV with the tick_ms, imu_yaw, imu_pitch, aim_yaw and
+ * aim_pitch columns. Every millisecond the attitude goes into the IMU history, and a changed
+ * offset becomes a measurement at its capture tick the way Gimbal_Ctrl_Loop takes it. The
+ * setpoint the tracker gives each millisecond is kept, and once the measurement of that tick
+ * arrives (a capture latency later) it is scored against it, together with the setpoint the
+ * gimbal had without the tracker, the last measurement held. Setpoints given for an earlier
+ * track than the measurement's, or while the IMU settles at the start, are not scored. The check fails when the tracker is further off than holding.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "aim_tracker.h"
+#include "imu_history.h"
+#include "input_snapshot.h"
+#include "fast_math.h"
+
+#define REPLAY_LINE_LENGTH (4096)
+#define REPLAY_SETPOINTS (256) // ms of setpoints kept, more than AIM_CAPTURE_LATENCY
+#define REPLAY_SETTLE_MS (1000) // ms at the start of the trace not scored, the IMU attitude is still settling
+
+typedef struct
+{
+    uint32_t tick;
+    uint32_t track; // g_aim_tracker.targets when it was given
+    uint8_t valid;
+    float yaw, pitch;
+} Replay_Setpoint_t;
+
+typedef struct
+{
+    double sum_squared;
+    float max;
+    uint32_t count;
+} Replay_Error_t;
+
+static void Replay_Error_Add(Replay_Error_t *error, float yaw_error, float pitch_error)
+{
+    float error_squared = yaw_error * yaw_error + pitch_error * pitch_error;
+    error->sum_squared += error_squared;
+    error->max = sqrtf(error_squared) > error->max ? sqrtf(error_squared) : error->max;
+    error->count++;
+}
+
+static float Replay_Error_RMS(const Replay_Error_t *error)
+{
+    return error->count > 0 ? (float)sqrt(error->sum_squared / error->count) : 0.0f;
+}
+
+// column index of name in a CSV header, -1 when missing
+static int Replay_Column(const char *line, const char *name)
+{
+    char header[REPLAY_LINE_LENGTH];
+    strcpy(header, line);
+    int column = 0;
+    for (char *field = strtok(header, ",\r\n"); field != NULL; field = strtok(NULL, ",\r\n"), column++)
+    {
+        if (strcmp(field, name) == 0)
+        {
+            return column;
+        }
+    }
+    return -1;
+}
+
+static int Replay_Fields(char *line, double *fields, int max_fields)
+{
+    int count = 0;
+    for (char *field = strtok(line, ",\r\n"); field != NULL && count < max_fields; field = strtok(NULL, ",\r\n"))
+    {
+        fields[count++] = strtod(field, NULL);
+    }
+    return count;
+}
+
+int Sim_Stress_Aim_Replay(const char *trace_path)
+{
+    FILE *trace = trace_path != NULL ? fopen(trace_path, "r") : NULL;
+    if (trace == NULL)
+    {
+        fprintf(stderr, "aim replay needs a trace, -r capture.csv from tools/telemetry_decode.py\n");
+        return 1;
+    }
+
+    static char line[REPLAY_LINE_LENGTH];
+    int tick_column = -1, imu_yaw_column = -1, imu_pitch_column = -1, aim_yaw_column = -1, aim_pitch_column = -1;
+    if (fgets(line, sizeof(line), trace) != NULL)
+    {
+        tick_column = Replay_Column(line, "tick_ms");
+        imu_yaw_column = Replay_Column(line, "imu_yaw");
+        imu_pitch_column = Replay_Column(line, "imu_pitch");
+        aim_yaw_column = Replay_Column(line, "aim_yaw");
+        aim_pitch_column = Replay_Column(line, "aim_pitch");
+    }
+    int last_column = tick_column;
+    int columns[] = {imu_yaw_column, imu_pitch_column, aim_yaw_column, aim_pitch_column};
+    for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++)
+    {
+        last_column = columns[i] < 0 || last_column < 0 ? -1 : (columns[i] > last_column ? columns[i] : last_column);
+    }
+    if (last_column < 0)
+    {
+        fprintf(stderr, "%s: needs tick_ms, imu_yaw, imu_pitch, aim_yaw and aim_pitch columns\n", trace_path);
+        fclose(trace);
+        return 1;
+    }
+
+    static Replay_Setpoint_t tracked[REPLAY_SETPOINTS], held[REPLAY_SETPOINTS];
+    Replay_Error_t tracked_error = {0}, held_error = {0};
+    uint8_t held_valid = 0;
+    float held_yaw = 0.0f, held_pitch = 0.0f, aim_yaw = 0.0f, aim_pitch = 0.0f;
+    uint32_t rows = 0, fresh_setpoints = 0, first_tick = 0;
+    static double fields[REPLAY_LINE_LENGTH / 2];
+    while (fgets(line, sizeof(line), trace) != NULL)
+    {
+        int count = Replay_Fields(line, fields, sizeof(fields) / sizeof(fields[0]));
+        if (count <= last_column)
+        {
+            continue;
+        }
+        rows++;
+        uint32_t tick = (uint32_t)fields[tick_column];
+        first_tick = rows == 1 ? tick : first_tick;
+        float imu_yaw = (float)fields[imu_yaw_column];
+        float imu_pitch = (float)fields[imu_pitch_column];
+        IMU_History_Push(tick, imu_yaw, imu_pitch);
+
+        if ((float)fields[aim_yaw_column] != aim_yaw || (float)fields[aim_pitch_column] != aim_pitch)
+        {
+            aim_yaw = (float)fields[aim_yaw_column];
+            aim_pitch = (float)fields[aim_pitch_column];
+            uint32_t capture_tick = tick - AIM_CAPTURE_LATENCY;
+            held_valid = aim_yaw != 0.0f || aim_pitch != 0.0f;
+            if (held_valid)
+            {
+                float base_yaw = imu_yaw, base_pitch = imu_pitch;
+                IMU_History_Lookup(capture_tick, &base_yaw, &base_pitch);
+                float target_yaw = base_yaw + aim_yaw * DEG_TO_RAD_F;
+                float target_pitch = base_pitch + aim_pitch * DEG_TO_RAD_F;
+
+                Aim_Tracker_Measure(capture_tick, target_yaw, target_pitch);
+
+                // score what both gave at the capture tick against where the target was then,
+                // when it was given for the same track, a switch to another target is not
+                // something either could have seen coming
+                const Replay_Setpoint_t *tracked_then = &tracked[capture_tick % REPLAY_SETPOINTS];
+                const Replay_Setpoint_t *held_then = &held[capture_tick % REPLAY_SETPOINTS];
+                if ((int32_t)(capture_tick - first_tick) >= REPLAY_SETTLE_MS && tracked_then->tick == capture_tick &&
+                    tracked_then->track == g_aim_tracker.targets && tracked_then->valid && held_then->valid)
+                {
+                    Replay_Error_Add(&tracked_error, Angle_Difference(tracked_then->yaw, target_yaw),
+                                     tracked_then->pitch - target_pitch);
+                    Replay_Error_Add(&held_error, Angle_Difference(held_then->yaw, target_yaw),
+                                     held_then->pitch - target_pitch);
+                }
+                held_yaw = target_yaw;
+                held_pitch = target_pitch;
+            }
+            else
+            {
+                Aim_Tracker_Drop();
+            }
+        }
+
+        Replay_Setpoint_t *setpoint = &tracked[tick % REPLAY_SETPOINTS];
+        setpoint->tick = tick;
+        setpoint->track = g_aim_tracker.targets;
+        setpoint->valid = Aim_Tracker_Predict(tick, &setpoint->yaw, &setpoint->pitch);
+        fresh_setpoints += setpoint->valid;
+        held[tick % REPLAY_SETPOINTS] = (Replay_Setpoint_t){.tick = tick, .valid = held_valid, .yaw = held_yaw, .pitch = held_pitch};
+    }
+    fclose(trace);
+
+    float tracked_rms = Replay_Error_RMS(&tracked_error);
+    float held_rms = Replay_Error_RMS(&held_error);
+    printf("[sil] aim replay: %s, %u rows, %u measurements, %u targets, %u timeouts, %u ms tracked\n", trace_path,
+           rows, g_aim_tracker.measurements, g_aim_tracker.targets, g_aim_tracker.timeouts, fresh_setpoints);
+    printf("[sil]   tracker   setpoint error rms %.4f rad  max %.4f rad  over %u measurements\n", (double)tracked_rms,
+           (double)tracked_error.max, tracked_error.count);
+    printf("[sil]   held      setpoint error rms %.4f rad  max %.4f rad\n", (double)held_rms, (double)held_error.max);
+    printf("[sil]   history   %u lookups, %u misses\n", g_imu_history_stats.lookups, g_imu_history_stats.misses);
+    return tracked_error.count > 0 && tracked_rms <= held_rms ? 0 : 1;
+}
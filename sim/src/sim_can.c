@@ -0,0 +1,258 @@
+/**
+ * @file sim_can.c
+ * @brief Host implementation of the bsp_can service.
+ * Transmitted frames are handed to the plant, and plant feedback is dispatched to the
+ * registered device callbacks exactly like the CAN RX FIFO interrupt does on the board.
+ * With SocketCAN open (-c) frames go out on the interfaces and feedback comes from the
+ * plant process instead, see sim_socketcan.c.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "bsp_can.h"
+#include "sim.h"
+
+static CAN_Instance_t g_sim_can_instances[CAN_MAX_DEVICE];
+static CAN_TxHeaderTypeDef g_sim_can_tx_headers[CAN_MAX_DEVICE];
+static uint8_t g_sim_can_device_count = 0;
+static Sim_CAN_Stats_t g_sim_can_stats = {0};
+static FILE *g_sim_can_trace = NULL;
+
+// Each bus is a wire at SIM_CAN_BITRATE carrying the feedback the plant sends and the frames
+// in the TX mailboxes, in the order they were handed to it and with their stuff bits. A mailbox
+// is busy until its frame is off the wire, so a bus asked for more than it carries backs up and
+// runs out of mailboxes. Times are in bit times since the start, a tick is SIM_CAN_BITRATE / 1000.
+#define SIM_CAN_BITS_PER_TICK (SIM_CAN_BITRATE / 1000)
+
+static uint64_t g_sim_can_wire_free[SIM_MAX_CAN_BUS]; // when the wire is done with what it was given
+static uint64_t g_sim_can_mailbox_free[SIM_MAX_CAN_BUS][SIM_CAN_MAILBOXES];
+static uint64_t g_sim_can_window_bits[SIM_MAX_CAN_BUS];
+static uint32_t g_sim_can_window[SIM_MAX_CAN_BUS];
+
+static uint64_t Sim_CAN_Now(void)
+{
+    return (uint64_t)Sim_Get_Tick() * SIM_CAN_BITS_PER_TICK;
+}
+
+/**
+ * @brief Bits on the wire for a standard 8 byte data frame: SOF to CRC with their stuff bits,
+ * then CRC delimiter, ACK, EOF and the 3 bit IFS.
+ */
+static uint32_t Sim_CAN_Frame_Bits(uint16_t can_id, const uint8_t data[8])
+{
+    uint8_t bits[98]; // SOF, 11 bit identifier, RTR, IDE, r0, DLC, 64 data bits, 15 bit CRC
+    uint32_t count = 0;
+    bits[count++] = 0;
+    for (int i = 10; i >= 0; i--)
+    {
+        bits[count++] = (can_id >> i) & 1;
+    }
+    bits[count++] = 0;
+    bits[count++] = 0;
+    bits[count++] = 0;
+    for (int i = 3; i >= 0; i--)
+    {
+        bits[count++] = (8 >> i) & 1;
+    }
+    for (int byte = 0; byte < 8; byte++)
+    {
+        for (int i = 7; i >= 0; i--)
+        {
+            bits[count++] = (data[byte] >> i) & 1;
+        }
+    }
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t feedback = bits[i] ^ ((crc >> 14) & 1);
+        crc = (uint16_t)((crc << 1) & 0x7FFF);
+        if (feedback)
+        {
+            crc ^= 0x4599;
+        }
+    }
+    for (int i = 14; i >= 0; i--)
+    {
+        bits[count++] = (crc >> i) & 1;
+    }
+
+    // after five equal bits the transmitter inserts their complement, which starts the next run
+    uint32_t stuffed = 0;
+    uint8_t last = bits[0];
+    uint32_t run = 1;
+    for (uint32_t i = 1; i < count; i++)
+    {
+        if (bits[i] == last)
+        {
+            run++;
+        }
+        else
+        {
+            last = bits[i];
+            run = 1;
+        }
+        if (run == 5)
+        {
+            stuffed++;
+            last ^= 1;
+            run = 1;
+        }
+    }
+    return count + stuffed + 13;
+}
+
+/**
+ * @brief Put a frame on the wire after everything before it.
+ * @return bit time its last bit is sent at
+ */
+static uint64_t Sim_CAN_Wire_Send(uint8_t bus, uint16_t can_id, const uint8_t data[8])
+{
+    uint64_t now = Sim_CAN_Now();
+    uint64_t start = g_sim_can_wire_free[bus - 1] > now ? g_sim_can_wire_free[bus - 1] : now;
+    uint32_t bits = Sim_CAN_Frame_Bits(can_id, data);
+    g_sim_can_wire_free[bus - 1] = start + bits;
+
+    double backlog_us = (double)(g_sim_can_wire_free[bus - 1] - now) * 1e6 / SIM_CAN_BITRATE;
+    if (backlog_us > g_sim_can_stats.max_backlog_us[bus - 1])
+    {
+        g_sim_can_stats.max_backlog_us[bus - 1] = backlog_us;
+    }
+    uint32_t window = Sim_Get_Tick() / SIM_CAN_LOAD_WINDOW;
+    if (window != g_sim_can_window[bus - 1])
+    {
+        g_sim_can_window[bus - 1] = window;
+        g_sim_can_window_bits[bus - 1] = 0;
+    }
+    g_sim_can_window_bits[bus - 1] += bits;
+    double window_load = 100.0 * g_sim_can_window_bits[bus - 1] / ((double)SIM_CAN_BITRATE * SIM_CAN_LOAD_WINDOW / 1000.0);
+    if (window_load > g_sim_can_stats.peak_load[bus - 1])
+    {
+        g_sim_can_stats.peak_load[bus - 1] = window_load;
+    }
+    g_sim_can_stats.wire_bits[bus - 1] += bits;
+    return g_sim_can_wire_free[bus - 1];
+}
+
+static uint8_t Sim_CAN_Mailboxes_Used(uint8_t bus)
+{
+    uint64_t now = Sim_CAN_Now();
+    uint8_t used = 0;
+    for (int i = 0; i < SIM_CAN_MAILBOXES; i++)
+    {
+        used += g_sim_can_mailbox_free[bus - 1][i] > now;
+    }
+    return used;
+}
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(const CAN_HandleTypeDef *hcan)
+{
+    return SIM_CAN_MAILBOXES - Sim_CAN_Mailboxes_Used(hcan->bus);
+}
+
+void CAN_Service_Init(void)
+{
+    // nothing to start, the virtual bus is always up
+}
+
+CAN_Instance_t *CAN_Device_Register(uint8_t _can_bus, uint16_t _tx_id, uint16_t _rx_id, void (*_can_module_callback)(CAN_Instance_t *can_instance))
+{
+    if (g_sim_can_device_count >= CAN_MAX_DEVICE)
+    {
+        fprintf(stderr, "[sil] CAN device table full\n");
+        return NULL;
+    }
+    CAN_Instance_t *instance = &g_sim_can_instances[g_sim_can_device_count];
+    CAN_TxHeaderTypeDef *tx_header = &g_sim_can_tx_headers[g_sim_can_device_count];
+    g_sim_can_device_count++;
+
+    memset(instance, 0, sizeof(CAN_Instance_t));
+    tx_header->StdId = _tx_id;
+    tx_header->IDE = CAN_ID_STD;
+    tx_header->RTR = CAN_RTR_DATA;
+    tx_header->DLC = 8;
+
+    instance->can_bus = _can_bus;
+    instance->tx_header = tx_header;
+    instance->rx_id = _rx_id;
+    instance->can_module_callback = _can_module_callback;
+    return instance;
+}
+
+int Sim_CAN_Open_Trace(const char *path)
+{
+    g_sim_can_trace = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    return g_sim_can_trace != NULL ? 0 : -1;
+}
+
+static void Sim_CAN_Trace_Frame(uint8_t can_bus, uint16_t can_id, const uint8_t data[8])
+{
+    if (g_sim_can_trace == NULL)
+    {
+        return;
+    }
+    static const char *const in_process_names[SIM_MAX_CAN_BUS] = {"can0", "can1"};
+    const char *interface = Sim_SocketCAN_Is_Open() ? Sim_SocketCAN_Interface(can_bus) : in_process_names[can_bus - 1];
+    Sim_CAN_Log_Frame(g_sim_can_trace, Sim_Get_Time(), interface, can_id, data);
+}
+
+HAL_StatusTypeDef CAN_Transmit(CAN_Instance_t *can_instance)
+{
+    uint8_t bus = can_instance->can_bus;
+    if (bus < 1 || bus > SIM_MAX_CAN_BUS)
+    {
+        return HAL_ERROR;
+    }
+    uint64_t now = Sim_CAN_Now();
+    int mailbox = 0;
+    while (mailbox < SIM_CAN_MAILBOXES && g_sim_can_mailbox_free[bus - 1][mailbox] > now)
+    {
+        mailbox++;
+    }
+    if (mailbox == SIM_CAN_MAILBOXES)
+    {
+        g_sim_can_stats.mailbox_full[bus - 1]++;
+        return HAL_ERROR;
+    }
+    g_sim_can_mailbox_free[bus - 1][mailbox] = Sim_CAN_Wire_Send(bus, can_instance->tx_header->StdId, can_instance->tx_buffer);
+    g_sim_can_stats.frames_tx[bus - 1]++;
+    Sim_CAN_Trace_Frame(bus, can_instance->tx_header->StdId, can_instance->tx_buffer);
+    if (Sim_SocketCAN_Is_Open())
+    {
+        if (Sim_SocketCAN_Send(bus, can_instance->tx_header->StdId, can_instance->tx_buffer) != 0)
+        {
+            g_sim_can_stats.send_errors[bus - 1]++;
+        }
+        return HAL_OK; // the mailbox took it, a full interface queue is a lost frame on the wire
+    }
+    Sim_Plant_On_Transmit(bus, can_instance->tx_header->StdId, can_instance->tx_buffer);
+    Sim_Supercap_On_Transmit(bus, can_instance->tx_header->StdId, can_instance->tx_buffer);
+    return HAL_OK;
+}
+
+void Sim_CAN_Receive(uint8_t can_bus, uint16_t rx_id, const uint8_t data[8])
+{
+    if (can_bus >= 1 && can_bus <= SIM_MAX_CAN_BUS)
+    {
+        Sim_CAN_Wire_Send(can_bus, rx_id, data); // on the wire whether or not a device takes it
+    }
+    for (int i = 0; i < g_sim_can_device_count; i++)
+    {
+        CAN_Instance_t *instance = &g_sim_can_instances[i];
+        if (instance->can_bus == can_bus && instance->rx_id == rx_id)
+        {
+            g_sim_can_stats.frames_rx[can_bus - 1]++;
+            Sim_CAN_Trace_Frame(can_bus, rx_id, data);
+            memcpy(instance->rx_buffer, data, 8);
+            if (instance->can_module_callback != NULL)
+            {
+                instance->can_module_callback(instance);
+            }
+            return;
+        }
+    }
+}
+
+const Sim_CAN_Stats_t *Sim_CAN_Get_Stats(void)
+{
+    return &g_sim_can_stats;
+}
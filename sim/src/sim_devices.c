@@ -0,0 +1,364 @@
+/**
+ * @file sim_devices.c
+ * @brief Stand-ins for the UART/timer/SPI driven devices that app/ talks to.
+ * Globals keep their firmware names so scenarios can drive them directly.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+#include "remote.h"
+#include "referee_system.h"
+#include "imu_task.h"
+#include "jetson_orin.h"
+#include "orin_link.h"
+#include "cobs_frame.h"
+#include "buzzer.h"
+#include "laser.h"
+#include "bsp_daemon.h"
+#include "fast_math.h"
+
+Remote_t g_remote = {0};
+IMU_t g_imu = {0};
+Jetson_Orin_Data_t g_orin_data = {0};
+Referee_Robot_State_t Referee_Robot_State = {0};
+
+void Remote_Init(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+}
+
+void Referee_System_Init(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+}
+
+void Referee_Set_Robot_State(void)
+{
+}
+
+#define SIM_REFEREE_PERIOD (20)         // ms between power samples, 50 Hz
+#define SIM_REFEREE_POWER_LIMIT (60.0f) // W
+#define SIM_REFEREE_BUFFER (60.0f)      // J
+
+Sim_Referee_t g_sim_referee;
+static double g_sim_referee_energy = 0.0; // J drawn since the last sample
+
+void Sim_Referee_Init(void)
+{
+    memset(&g_sim_referee, 0, sizeof(g_sim_referee));
+    g_sim_referee.power_limit = SIM_REFEREE_POWER_LIMIT;
+    g_sim_referee.buffer_max = SIM_REFEREE_BUFFER;
+    g_sim_referee.buffer = SIM_REFEREE_BUFFER;
+    g_sim_referee.min_buffer = SIM_REFEREE_BUFFER;
+    g_sim_referee_energy = 0.0;
+}
+
+/**
+ * @brief Sample the mean chassis power every SIM_REFEREE_PERIOD and settle the buffer with it.
+ * The reading is never negative, braking does not refill the buffer beyond what the limit does.
+ */
+void Sim_Referee_Update(uint32_t tick)
+{
+    g_sim_referee_energy += g_sim_supercap.input_power * SIM_DT;
+    if (g_sim_referee.buffer <= 0.0f)
+    {
+        g_sim_referee.empty_ms++;
+    }
+    if ((tick + 1) % SIM_REFEREE_PERIOD != 0)
+    {
+        return;
+    }
+    float period = SIM_REFEREE_PERIOD * 0.001f;
+    float power = (float)(g_sim_referee_energy / period);
+    power = power > 0.0f ? power : 0.0f;
+    g_sim_referee_energy = 0.0;
+
+    float buffer = g_sim_referee.buffer + (g_sim_referee.power_limit - power) * period;
+    g_sim_referee.buffer = buffer < 0.0f ? 0.0f : (buffer > g_sim_referee.buffer_max ? g_sim_referee.buffer_max : buffer);
+    if (g_sim_referee.buffer < g_sim_referee.min_buffer)
+    {
+        g_sim_referee.min_buffer = g_sim_referee.buffer;
+    }
+    g_sim_referee.samples++;
+
+    Referee_Robot_State.Chassis_Power = power;
+    Referee_Robot_State.Power_Buffer = (uint16_t)g_sim_referee.buffer;
+    Referee_Robot_State.Chassis_Power_Max = (uint16_t)g_sim_referee.power_limit;
+}
+
+#define SIM_SUPERCAP_BUS (2)
+#define SIM_SUPERCAP_TX_ID (0x2C8)        // enable flag from the robot
+#define SIM_SUPERCAP_RX_ID (0x2C7)        // state of charge to the robot
+#define SIM_SUPERCAP_PERIOD (10)          // ms between state of charge frames
+#define SIM_SUPERCAP_ENERGY (1300.0f)     // J, 6 F between 12 V and 24 V
+#define SIM_SUPERCAP_CHARGE_POWER (80.0f) // W, charger limit
+
+Sim_Supercap_t g_sim_supercap;
+
+void Sim_Supercap_Init(void)
+{
+    memset(&g_sim_supercap, 0, sizeof(g_sim_supercap));
+    g_sim_supercap.energy_max = SIM_SUPERCAP_ENERGY;
+    g_sim_supercap.energy = SIM_SUPERCAP_ENERGY;
+}
+
+void Sim_Supercap_On_Transmit(uint8_t can_bus, uint16_t tx_id, const uint8_t data[8])
+{
+    if (can_bus == SIM_SUPERCAP_BUS && tx_id == SIM_SUPERCAP_TX_ID)
+    {
+        g_sim_supercap.output_enabled = data[0];
+    }
+}
+
+/**
+ * @brief Split the plant's chassis power between the battery side and the cap, lossless, and
+ * report the state of charge every SIM_SUPERCAP_PERIOD.
+ */
+void Sim_Supercap_Update(uint32_t tick)
+{
+    Sim_Supercap_t *cap = &g_sim_supercap;
+    float power = Sim_Plant_Get_Stats()->chassis_power;
+    float limit = g_sim_referee.power_limit;
+
+    float from_cap = 0.0f;
+    if (cap->output_enabled && power > limit)
+    {
+        from_cap = power - limit;
+        from_cap = from_cap < cap->energy / SIM_DT ? from_cap : cap->energy / SIM_DT;
+    }
+    float to_cap = limit - power;
+    to_cap = to_cap < SIM_SUPERCAP_CHARGE_POWER ? to_cap : SIM_SUPERCAP_CHARGE_POWER;
+    to_cap = to_cap < (cap->energy_max - cap->energy) / SIM_DT ? to_cap : (cap->energy_max - cap->energy) / SIM_DT;
+    to_cap = to_cap > 0.0f ? to_cap : 0.0f;
+
+    cap->energy += (to_cap - from_cap) * SIM_DT;
+    cap->input_power = power - from_cap + to_cap;
+    cap->supplied += from_cap * SIM_DT;
+    cap->charged += to_cap * SIM_DT;
+    cap->output_ms += cap->output_enabled;
+
+    if (tick % SIM_SUPERCAP_PERIOD == 0)
+    {
+        uint8_t data[8] = {0};
+        data[0] = (uint8_t)(cap->energy / cap->energy_max * 100.0f);
+        Sim_CAN_Receive(SIM_SUPERCAP_BUS, SIM_SUPERCAP_RX_ID, data);
+    }
+}
+
+void IMU_Task(void const *pvParameters)
+{
+    (void)pvParameters;
+}
+
+/**
+ * @brief The IMU sits on the pitch stage. Its yaw is the gimbal's world yaw, and it is
+ * mounted so that roll reads minus the gimbal pitch (see the pitch motor config in
+ * gimbal_task.c). Not called with SocketCAN (-c), g_imu then stays zero.
+ */
+void Sim_IMU_Update(void)
+{
+    const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+    g_imu.rad.yaw = state->gimbal_yaw;
+    g_imu.rad.pitch = 0.0f;
+    g_imu.rad.roll = -state->gimbal_pitch;
+    g_imu.deg.yaw = g_imu.rad.yaw / DEG_TO_RAD_F;
+    g_imu.deg.pitch = 0.0f;
+    g_imu.deg.roll = g_imu.rad.roll / DEG_TO_RAD_F;
+    g_imu.bmi088_raw.gyro[0] = -state->gimbal_pitch_rate;
+    g_imu.bmi088_raw.gyro[1] = 0.0f;
+    g_imu.bmi088_raw.gyro[2] = state->gimbal_yaw_rate;
+}
+
+void Jetson_Orin_Send_Data(void)
+{
+}
+
+/*
+ * Orin stand-in on huart6: answers the link's time sync requests on its own clock, which runs
+ * SIM_ORIN_CLOCK_DRIFT fast from an epoch like offset, and takes the scenario camera's aim
+ * frames. The clocks are the host's monotonic clock, like the SIL cycle counter the MCU's time
+ * is taken from, so requests are only answered when paced in real time (-R). A request is
+ * stamped a random driver latency of up to SIM_ORIN_LINK_DELAY after its last byte crossed the
+ * line, and the answer is delivered once it would have crossed back, after as long again.
+ * Not used while a stand-in is attached to the pseudo-terminal.
+ */
+#define SIM_ORIN_CLOCK_OFFSET (1700000000000000LL) // us
+#define SIM_ORIN_CLOCK_DRIFT (50e-6)               // 50 ppm
+#define SIM_ORIN_LINK_DELAY (200)                  // us, each way, from the line to a time stamp and back
+#define SIM_ORIN_TURNAROUND (50)                   // us from a request arriving to its answer leaving
+#define SIM_ORIN_SYNC_SETTLE (5000)                // ms before the sync error is sampled
+#define SIM_ORIN_RX_SIZE (512)
+
+static uint16_t g_sim_orin_sequence = 0;
+static uint8_t g_sim_orin_rx[SIM_ORIN_RX_SIZE]; // MCU frame being received
+static uint16_t g_sim_orin_rx_length = 0;
+static uint8_t g_sim_orin_answer[COBS_FRAME_ENCODED_SIZE(ORIN_LINK_MAX_FRAME_SIZE)]; // on its way back
+static uint16_t g_sim_orin_answer_length = 0;
+static double g_sim_orin_answer_time = 0.0; // s, Sim_Get_Time its last byte arrives at
+static Sim_Tracking_t g_sim_orin_sync_error = {.name = "orin_sync_error", .unit = "us"};
+
+static uint64_t Sim_Orin_Clock_Us(void)
+{
+    static uint64_t start_us = 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now_us = (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+    if (start_us == 0)
+    {
+        start_us = now_us;
+    }
+    return SIM_ORIN_CLOCK_OFFSET + now_us + (uint64_t)((now_us - start_us) * SIM_ORIN_CLOCK_DRIFT);
+}
+
+static uint16_t Sim_Orin_Encode_Frame(uint8_t type, const void *body, uint16_t length, uint8_t *encoded)
+{
+    uint8_t frame[ORIN_LINK_MAX_FRAME_SIZE];
+    uint32_t tick = Sim_Get_Tick();
+    frame[0] = type;
+    memcpy(&frame[1], &g_sim_orin_sequence, sizeof(g_sim_orin_sequence));
+    memcpy(&frame[3], &tick, sizeof(tick));
+    memcpy(&frame[7], body, length);
+    uint16_t crc = COBS_Frame_CRC16(frame, 7 + length);
+    frame[7 + length] = (uint8_t)crc;
+    frame[8 + length] = (uint8_t)(crc >> 8);
+    g_sim_orin_sequence++;
+    return COBS_Frame_Encode(frame, 9 + length, encoded);
+}
+
+void Sim_Orin_Send_Aim(float yaw_deg, float pitch_deg, uint8_t target_valid, uint16_t age_ms)
+{
+    Orin_Link_Aim_Frame_t aim = {
+        .yaw = yaw_deg,
+        .pitch = pitch_deg,
+        .flags = target_valid ? ORIN_LINK_AIM_TARGET_VALID : 0,
+        .age_ms = age_ms,
+    };
+    uint8_t encoded[COBS_FRAME_ENCODED_SIZE(ORIN_LINK_MAX_FRAME_SIZE)];
+    Sim_UART_Receive(&huart6, encoded, Sim_Orin_Encode_Frame(ORIN_LINK_FRAME_AIM, &aim, sizeof(aim), encoded));
+}
+
+/**
+ * @brief A frame from the MCU whose last byte crossed the line at time (s, Sim_Get_Time).
+ */
+static void Sim_Orin_Take_Frame(double time)
+{
+    uint16_t length = COBS_Frame_Decode(g_sim_orin_rx, g_sim_orin_rx_length, g_sim_orin_rx);
+    if (!Sim_Is_Real_Time() || length != 7 + sizeof(Orin_Link_Sync_Request_Frame_t) + 2 ||
+        g_sim_orin_rx[0] != ORIN_LINK_FRAME_SYNC_REQUEST ||
+        COBS_Frame_CRC16(g_sim_orin_rx, length - 2) != (uint16_t)(g_sim_orin_rx[length - 2] | (g_sim_orin_rx[length - 1] << 8)))
+    {
+        return; // telemetry and state frames, the stand-in has no use for them
+    }
+    Orin_Link_Sync_Request_Frame_t request;
+    memcpy(&request, &g_sim_orin_rx[7], sizeof(request));
+    Orin_Link_Sync_Response_Frame_t response = {.t1 = request.t1};
+    double stamped = time + (rand() % SIM_ORIN_LINK_DELAY) * 1e-6;
+    response.t2 = Sim_Orin_Clock_Us() + (uint64_t)(int64_t)((stamped - Sim_Get_Time()) * 1e6);
+    response.t3 = response.t2 + SIM_ORIN_TURNAROUND;
+    g_sim_orin_answer_length = Sim_Orin_Encode_Frame(ORIN_LINK_FRAME_SYNC_RESPONSE, &response, sizeof(response),
+                                                     g_sim_orin_answer);
+    double byte_time = huart6.Init.BaudRate > 0 ? 10.0 / huart6.Init.BaudRate : 0.0;
+    g_sim_orin_answer_time = stamped + (SIM_ORIN_TURNAROUND + rand() % SIM_ORIN_LINK_DELAY) * 1e-6 +
+                             g_sim_orin_answer_length * byte_time;
+}
+
+/**
+ * @brief huart6 bytes from the MCU, split into frames on the delimiter. The first crossed the
+ * line at time (s, Sim_Get_Time), each next one byte_time later.
+ */
+void Sim_Orin_On_Transmit(const uint8_t *data, uint16_t length, double time, double byte_time)
+{
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if (data[i] == 0)
+        {
+            if (g_sim_orin_rx_length > 0)
+            {
+                Sim_Orin_Take_Frame(time + i * byte_time);
+            }
+            g_sim_orin_rx_length = 0;
+        }
+        else if (g_sim_orin_rx_length < SIM_ORIN_RX_SIZE)
+        {
+            g_sim_orin_rx[g_sim_orin_rx_length++] = data[i];
+        }
+    }
+}
+
+/**
+ * @brief The sync answer, into huart6's receive DMA once it has crossed the line.
+ */
+void Sim_Orin_Poll(void)
+{
+    if (g_sim_orin_answer_length > 0 && Sim_Get_Time() >= g_sim_orin_answer_time)
+    {
+        Sim_UART_Receive(&huart6, g_sim_orin_answer, g_sim_orin_answer_length);
+        g_sim_orin_answer_length = 0;
+    }
+}
+
+/**
+ * @brief Sync error, the MCU's estimate of the Orin's clock against the clock itself.
+ */
+void Sim_Orin_Update(uint32_t tick)
+{
+#ifdef ORIN_LINK_ENABLED
+    if (tick >= SIM_ORIN_SYNC_SETTLE && g_orin_link_stats.sync.synced && !Sim_PTY_Is_Open())
+    {
+        uint64_t estimate = Orin_Link_To_Orin_Time(Orin_Link_Time_Us());
+        Sim_Tracking_Sample(&g_sim_orin_sync_error, (float)(int64_t)(estimate - Sim_Orin_Clock_Us()));
+    }
+#else
+    (void)tick;
+#endif
+}
+
+void Sim_Orin_Report(void)
+{
+#ifdef ORIN_LINK_ENABLED
+    const Orin_Link_Sync_t *sync = &g_orin_link_stats.sync;
+    if (g_sim_orin_sync_error.count > 0)
+    {
+        Sim_Tracking_Report(&g_sim_orin_sync_error);
+    }
+    printf("[sil]   orin sync      %10lu exchanges  %lu accepted  %lu rejected  %lu steps  drift %.1f ppm  "
+           "round trip %lu us (min %lu)\n", (unsigned long)sync->exchanges, (unsigned long)sync->accepted,
+           (unsigned long)sync->rejected, (unsigned long)sync->steps, (double)sync->drift_ppm,
+           (unsigned long)sync->round_trip_us, (unsigned long)sync->min_round_trip_us);
+    if (!Sim_Is_Real_Time())
+    {
+        printf("[sil]   orin clock     not answered, the stand-in's clock is the host's, pace with -R\n");
+    }
+    else if (!Sim_PTY_Is_Open())
+    {
+        printf("[sil]   orin clock     %10.1f ppm drift of the stand-in's clock\n", SIM_ORIN_CLOCK_DRIFT * 1e6);
+    }
+#endif
+}
+
+void Buzzer_Init(void)
+{
+}
+
+void Buzzer_Play_Melody(Melody_t melody)
+{
+    (void)melody;
+}
+
+void Laser_Init(void)
+{
+}
+
+void Laser_On(void)
+{
+}
+
+void Laser_Off(void)
+{
+}
+
+void Daemon_Task_Loop(void)
+{
+}
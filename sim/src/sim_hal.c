@@ -0,0 +1,194 @@
+/**
+ * @file sim_hal.c
+ * @brief HAL peripheral handles and calls for the host build.
+ * huart6 writes go to the file given by Sim_UART_Open_Output (sim_main -u) and the pseudo-terminal
+ * (sim_main -p), bytes for a receive DMA are delivered by Sim_UART_Receive. A huart6 transmit DMA
+ * drains at Init.BaudRate, 8N1, in Sim_UART_Update, so whoever reads the line gets the bytes
+ * when they would have crossed it and a sender that outruns the baud rate finds it busy.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "can.h"
+#include "usart.h"
+#include "tim.h"
+#include "spi.h"
+#include "sim.h"
+
+CAN_HandleTypeDef hcan1 = {.bus = 1};
+CAN_HandleTypeDef hcan2 = {.bus = 2};
+UART_HandleTypeDef huart1 = {.port = 1, .gState = HAL_UART_STATE_READY};
+UART_HandleTypeDef huart3 = {.port = 3, .gState = HAL_UART_STATE_READY};
+static DMA_HandleTypeDef g_sim_huart6_rx_dma;
+UART_HandleTypeDef huart6 = {.port = 6, .gState = HAL_UART_STATE_READY, .hdmarx = &g_sim_huart6_rx_dma};
+static TIM_TypeDef g_sim_tim4;
+TIM_HandleTypeDef htim4 = {.timer = 4, .Instance = &g_sim_tim4};
+SPI_HandleTypeDef hspi1 = {.port = 1};
+
+static FILE *g_sim_uart_output = NULL;
+
+// huart6 transmit DMA in flight
+static const uint8_t *g_sim_uart_tx_data = NULL;
+static uint16_t g_sim_uart_tx_length = 0;
+static uint16_t g_sim_uart_tx_sent = 0;
+static double g_sim_uart_tx_credit = 0.0; // bytes the line could have sent since the transfer began
+static double g_sim_uart_tx_start = 0.0;  // s, Sim_Get_Time the transfer began at
+static Sim_UART_Stats_t g_sim_uart_stats = {0};
+
+int Sim_UART_Open_Output(const char *path)
+{
+    g_sim_uart_output = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+    return g_sim_uart_output != NULL ? 0 : -1;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return Sim_Get_Tick();
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return 42000000U; // APB1 on the 168 MHz board clock tree
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    (void)Delay;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    huart->gState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+/**
+ * @brief Bytes onto huart6's line, the first done crossing it at time (s), each next byte_time later.
+ */
+static void Sim_UART_Write(const uint8_t *data, uint16_t length, double time, double byte_time)
+{
+    if (g_sim_uart_output != NULL)
+    {
+        fwrite(data, 1, length, g_sim_uart_output);
+    }
+    if (Sim_PTY_Is_Open())
+    {
+        Sim_PTY_Write(data, length);
+    }
+    else
+    {
+        Sim_Orin_On_Transmit(data, length, time, byte_time);
+    }
+    g_sim_uart_stats.tx_bytes += length;
+}
+
+/**
+ * @brief Blocking transmit, done at once: the caller would have waited the line out.
+ */
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)Timeout;
+    if (huart == &huart6)
+    {
+        Sim_UART_Write(pData, Size, Sim_Get_Time(), 0.0);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    if (huart != &huart6 || huart->Init.BaudRate == 0)
+    {
+        return HAL_UART_Transmit(huart, pData, Size, 0);
+    }
+    if (huart->gState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    g_sim_uart_tx_data = pData;
+    g_sim_uart_tx_length = Size;
+    g_sim_uart_tx_sent = 0;
+    g_sim_uart_tx_credit = 0.0;
+    g_sim_uart_tx_start = Sim_Get_Time();
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    return HAL_OK;
+}
+
+/**
+ * @brief Put the last tick's worth of the huart6 transmit DMA on the line, READY once it is all out.
+ * The rest of the tick the transfer ends in is idle, the next one is only started by a task.
+ */
+void Sim_UART_Update(void)
+{
+    if (huart6.gState != HAL_UART_STATE_BUSY_TX)
+    {
+        return;
+    }
+    g_sim_uart_tx_credit += huart6.Init.BaudRate / 10.0 * SIM_DT;
+    uint16_t length = g_sim_uart_tx_length - g_sim_uart_tx_sent;
+    if (g_sim_uart_tx_credit < length)
+    {
+        length = (uint16_t)g_sim_uart_tx_credit;
+    }
+    double byte_time = 10.0 / huart6.Init.BaudRate;
+    Sim_UART_Write(&g_sim_uart_tx_data[g_sim_uart_tx_sent], length,
+                   g_sim_uart_tx_start + (g_sim_uart_tx_sent + 1) * byte_time, byte_time);
+    g_sim_uart_tx_sent += length;
+    g_sim_uart_tx_credit -= length;
+    if (g_sim_uart_tx_sent == g_sim_uart_tx_length)
+    {
+        huart6.gState = HAL_UART_STATE_READY;
+    }
+}
+
+const Sim_UART_Stats_t *Sim_UART_Get_Stats(void)
+{
+    return &g_sim_uart_stats;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if (huart->hdmarx == NULL)
+    {
+        return HAL_ERROR;
+    }
+    huart->hdmarx->buffer = pData;
+    huart->hdmarx->size = Size;
+    huart->hdmarx->counter = Size;
+    return HAL_OK;
+}
+
+/**
+ * @brief Bytes arriving on huart's RX line, written where its receive DMA would put them.
+ * Dropped when no receive is running or a normal mode one is full.
+ */
+void Sim_UART_Receive(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t length)
+{
+    DMA_HandleTypeDef *dma = huart->hdmarx;
+    if (dma == NULL || dma->buffer == NULL)
+    {
+        return;
+    }
+    for (uint16_t i = 0; i < length && dma->counter > 0; i++)
+    {
+        dma->buffer[dma->size - dma->counter] = data[i];
+        if (--dma->counter == 0 && dma->Init.Mode == DMA_CIRCULAR)
+        {
+            dma->counter = dma->size;
+        }
+    }
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "[sil] Error_Handler at tick %u\n", Sim_Get_Tick());
+    abort();
+}
@@ -0,0 +1,410 @@
+/**
+ * @file sim_main.c
+ * @brief Entry point of the host software-in-the-loop build.
+ *
+ * Usage: control-template-sil [-s scenario] [-t duration_ms] [-l] [-x snapshot|power|aim] [-r trace.csv]
+ *                             [-u uart6_output] [-p] [-R] [-c socketcan_prefix] [-d candump_log]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+#include "robot.h"
+#include "motor_task.h"
+#include "debug_task.h"
+#include "jetson_orin.h"
+#include "orin_link.h"
+#include "bsp_daemon.h"
+#include "control_sync.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "boot.h"
+#include "rate_group.h"
+#include "can_tx_scheduler.h"
+#include "cmsis_os.h"
+
+extern osThreadId motor_task_handle;
+
+static void Sim_Gimbal_Group(void)
+{
+    Rate_Group_Run(RATE_GROUP_GIMBAL);
+}
+
+static void Sim_Chassis_Group(void)
+{
+    Rate_Group_Run(RATE_GROUP_CHASSIS);
+}
+
+static void Sim_Command_Group(void)
+{
+    Rate_Group_Run(RATE_GROUP_COMMAND);
+}
+
+// Mirrors the periodic threads in robot_tasks.h; within a tick tasks run in table order
+static Sim_Task_t g_sim_tasks[] = {
+#ifdef EVENT_DRIVEN_CONTROL
+    {"gimbal", Sim_Gimbal_Group, RATE_GROUP_GIMBAL_PERIOD + 1, (void **)&g_rate_groups[RATE_GROUP_GIMBAL].handle},
+    {"chassis", Sim_Chassis_Group, RATE_GROUP_CHASSIS_PERIOD + 1, (void **)&g_rate_groups[RATE_GROUP_CHASSIS].handle},
+    {"robot_command", Sim_Command_Group, RATE_GROUP_COMMAND_PERIOD + 1, (void **)&g_rate_groups[RATE_GROUP_COMMAND].handle},
+    {"motor", Motor_Task_Loop, CONTROL_SYNC_MOTOR_TIMEOUT_MS, &motor_task_handle},
+#else
+    {"gimbal", Sim_Gimbal_Group, RATE_GROUP_GIMBAL_PERIOD},
+    {"chassis", Sim_Chassis_Group, RATE_GROUP_CHASSIS_PERIOD},
+    {"robot_command", Sim_Command_Group, RATE_GROUP_COMMAND_PERIOD},
+    {"motor", Motor_Task_Loop, 1}, // sends whatever the groups released this tick computed
+#endif
+#ifdef ORIN_LINK_ENABLED
+    {"jetson_orin", Orin_Link_Task_Loop, ORIN_LINK_PERIOD},
+#else
+    {"jetson_orin", Jetson_Orin_Send_Data, JETSON_ORIN_PERIOD},
+#endif
+    {"daemon", Daemon_Task_Loop, DAEMON_PERIOD},
+    {"debug", Debug_Task_Loop, DEBUG_PERIOD},
+#ifdef TELEMETRY_ENABLED
+    {"telemetry", Telemetry_Task_Loop, TELEMETRY_PERIOD},
+#endif
+};
+
+#define SIM_TASK_COUNT (sizeof(g_sim_tasks) / sizeof(g_sim_tasks[0]))
+
+static uint32_t g_sim_tick = 0;
+static const Sim_Scenario_t *g_sim_scenario = NULL;
+static uint8_t g_sim_real_time = 0; // paced at 1 tick per wall ms, with -R, SocketCAN or the pseudo-terminal
+
+static double Sim_Wall_Time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+uint32_t Sim_Get_Tick(void)
+{
+    return g_sim_tick;
+}
+
+double Sim_Get_Time(void)
+{
+    if (!g_sim_real_time)
+    {
+        return g_sim_tick * 1e-3;
+    }
+    // epoch time, so the trace lines up with candump on the same interfaces
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+uint8_t Sim_Is_Real_Time(void)
+{
+    return g_sim_real_time;
+}
+
+void Sim_Step(void)
+{
+    g_sim_scenario->update(g_sim_tick);
+    Sim_UART_Update(); // what went out on huart6 over the last tick, the Orin stand-in may answer it
+    Sim_Orin_Poll();
+    Sim_PTY_Poll(); // what the Orin stand-in wrote, before the link task parses it
+    if (Sim_SocketCAN_Is_Open())
+    {
+        Sim_SocketCAN_Poll(Sim_CAN_Receive); // feedback from the plant process
+    }
+    else
+    {
+        Sim_Plant_Update(SIM_DT);
+        Sim_IMU_Update();
+        Sim_Supercap_Update(g_sim_tick);
+        Sim_Referee_Update(g_sim_tick);
+    }
+    Sim_Timers_Update(g_sim_tick);
+
+    for (size_t i = 0; i < SIM_TASK_COUNT; i++)
+    {
+        Sim_Task_t *task = &g_sim_tasks[i];
+        uint8_t due;
+        if (task->event_handle != NULL)
+        {
+            // like the firmware threads, every loop runs once at start up before waiting
+            due = Sim_Take_Notification(*task->event_handle) > 0 || task->runs == 0 ||
+                  g_sim_tick - task->last_run_tick >= task->period_ms;
+        }
+        else
+        {
+            due = g_sim_tick % task->period_ms == 0;
+        }
+        if (!due)
+        {
+            continue;
+        }
+
+        double start = Sim_Wall_Time();
+        task->loop();
+        task->wall_time += Sim_Wall_Time() - start;
+        task->last_run_tick = g_sim_tick;
+        task->runs++;
+    }
+    Sim_Orin_Update(g_sim_tick);
+    Sim_Odometry_Update(g_sim_tick);
+    g_sim_tick++;
+}
+
+static void Sim_Usage(const char *prog)
+{
+    printf("usage: %s [-s scenario] [-t duration_ms] [-l] [-x snapshot|power|aim] [-r trace.csv] [-u uart6_output] [-p] [-R]\n", prog);
+    printf("  -u path      write huart6 bytes (telemetry stream) to path, - for stdout\n");
+    printf("  -p           huart6 on a pseudo-terminal in real time for an Orin stand-in, e.g.\n");
+    printf("               python tools/orin_standin.py /dev/pts/N\n");
+    printf("  -R           pace at 1 tick per wall ms, for the Orin link's time sync on the host clock\n");
+    printf("  -c prefix    CAN over SocketCAN <prefix>0/<prefix>1 (e.g. vcan) in real time, run\n");
+    printf("               %s-plant -c prefix alongside for the motor feedback\n", prog);
+    printf("  -d path      candump -l style log of every CAN frame sent and received\n");
+    printf("  -x snapshot  seqlock torn read stress check for -t ms instead of a scenario\n");
+    printf("  -x power     power limiter replay of the referee trace given with -r\n");
+    printf("  -x aim       aim tracker replay of the auto aim trace given with -r\n");
+    printf("  -r path      tools/telemetry_decode.py CSV, chassis_power and power_buffer for power,\n");
+    printf("               imu_yaw, imu_pitch, aim_yaw and aim_pitch for aim\n");
+    printf("scenarios:\n");
+    Sim_List_Scenarios();
+}
+
+int main(int argc, char **argv)
+{
+    const char *scenario_name = "drive";
+    const char *stress_name = NULL;
+    const char *trace_path = NULL;
+    uint32_t duration_ms = 60 * 1000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            scenario_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            duration_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc)
+        {
+            if (Sim_UART_Open_Output(argv[++i]) != 0)
+            {
+                perror(argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-p") == 0)
+        {
+            const char *pty_name = Sim_PTY_Open();
+            if (pty_name == NULL)
+            {
+                return 1;
+            }
+            printf("[sil] huart6 on %s\n", pty_name);
+            fflush(stdout);
+            g_sim_real_time = 1;
+        }
+        else if (strcmp(argv[i], "-R") == 0)
+        {
+            g_sim_real_time = 1;
+        }
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            if (Sim_SocketCAN_Open(argv[++i]) != 0)
+            {
+                return 1;
+            }
+            g_sim_real_time = 1;
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            if (Sim_CAN_Open_Trace(argv[++i]) != 0)
+            {
+                perror(argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc)
+        {
+            stress_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            trace_path = argv[++i];
+        }
+        else
+        {
+            Sim_Usage(argv[0]);
+            return strcmp(argv[i], "-l") == 0 ? 0 : 1;
+        }
+    }
+
+    if (stress_name != NULL)
+    {
+        if (strcmp(stress_name, "snapshot") == 0)
+        {
+            return Sim_Stress_Snapshot(duration_ms);
+        }
+        if (strcmp(stress_name, "power") == 0)
+        {
+            return Sim_Stress_Power_Replay(trace_path);
+        }
+        if (strcmp(stress_name, "aim") == 0)
+        {
+            return Sim_Stress_Aim_Replay(trace_path);
+        }
+        fprintf(stderr, "unknown stress check '%s'\n", stress_name);
+        return 1;
+    }
+
+    g_sim_scenario = Sim_Find_Scenario(scenario_name);
+    if (g_sim_scenario == NULL)
+    {
+        fprintf(stderr, "unknown scenario '%s'\n", scenario_name);
+        Sim_Usage(argv[0]);
+        return 1;
+    }
+
+    Sim_Plant_Init();
+    Sim_Referee_Init();
+    Sim_Supercap_Init();
+    Robot_Init();
+    if (g_sim_scenario->init != NULL)
+    {
+        g_sim_scenario->init();
+    }
+
+    double start = Sim_Wall_Time();
+    struct timespec next_tick;
+    clock_gettime(CLOCK_MONOTONIC, &next_tick);
+    uint32_t late_ticks = 0;
+    double max_lateness = 0.0;
+    while (g_sim_tick < duration_ms)
+    {
+        if (g_sim_real_time)
+        {
+            next_tick.tv_nsec += 1000000;
+            if (next_tick.tv_nsec >= 1000000000)
+            {
+                next_tick.tv_nsec -= 1000000000;
+                next_tick.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_tick, NULL);
+            double lateness = Sim_Wall_Time() - (next_tick.tv_sec + next_tick.tv_nsec * 1e-9);
+            if (lateness > SIM_DT)
+            {
+                late_ticks++;
+            }
+            if (lateness > max_lateness)
+            {
+                max_lateness = lateness;
+            }
+        }
+        Sim_Step();
+    }
+    double elapsed = Sim_Wall_Time() - start;
+
+    printf("[sil] scenario %s: %u ms simulated in %.3f s wall (%.1fx real time)\n",
+           g_sim_scenario->name, g_sim_tick, elapsed, g_sim_tick / 1000.0 / elapsed);
+    if (g_sim_scenario->report != NULL)
+    {
+        g_sim_scenario->report();
+    }
+    Sim_Odometry_Report();
+    const Sim_Plant_Stats_t *plant_stats = Sim_Plant_Get_Stats();
+    printf("[sil]   plant chassis  %8.1f J drawn  peak %.0f W  %.1f A  scrub %.2f J  slip %.2f J\n",
+           plant_stats->chassis_energy, (double)plant_stats->peak_chassis_power,
+           (double)plant_stats->peak_chassis_current, plant_stats->scrub_energy, plant_stats->slip_energy);
+    printf("[sil]   plant azimuth  %8.3f A average, sum of the azimuth motors\n",
+           g_sim_tick > 0 ? plant_stats->azimuth_charge / (g_sim_tick * 0.001) : 0.0);
+    printf("[sil]   referee        %8.0f W limit  buffer min %.1f of %.0f J  %lu ms empty\n",
+           (double)g_sim_referee.power_limit, (double)g_sim_referee.min_buffer, (double)g_sim_referee.buffer_max,
+           (unsigned long)g_sim_referee.empty_ms);
+    printf("[sil]   supercap       %8.1f J supplied  %.1f J charged  %.0f of %.0f J left  %lu ms output on\n",
+           (double)g_sim_supercap.supplied, (double)g_sim_supercap.charged, (double)g_sim_supercap.energy,
+           (double)g_sim_supercap.energy_max, (unsigned long)g_sim_supercap.output_ms);
+    if (g_sim_real_time)
+    {
+        printf("[sil]   pacing         %10lu ticks more than 1 ms late, worst %.3f ms\n",
+               (unsigned long)late_ticks, max_lateness * 1e3);
+    }
+    for (size_t i = 0; i < SIM_TASK_COUNT; i++)
+    {
+        printf("[sil]   %-14s %10llu runs  %8.1f ns/run\n", g_sim_tasks[i].name,
+               (unsigned long long)g_sim_tasks[i].runs,
+               g_sim_tasks[i].runs ? g_sim_tasks[i].wall_time * 1e9 / g_sim_tasks[i].runs : 0.0);
+    }
+    for (int group = 0; group < RATE_GROUP_COUNT; group++)
+    {
+        const Rate_Group_t *rate_group = &g_rate_groups[group];
+        printf("[sil]   group %-13s %5lu runs  %lu overruns  %lu release timeouts  max response %lu cycles\n",
+               rate_group->name, (unsigned long)rate_group->runs, (unsigned long)rate_group->overruns,
+               (unsigned long)rate_group->release_timeouts, (unsigned long)rate_group->max_response_cycles);
+    }
+    const Sim_CAN_Stats_t *can_stats = Sim_CAN_Get_Stats();
+    for (int bus = 0; bus < SIM_MAX_CAN_BUS; bus++)
+    {
+        const CAN_TX_Bus_Stats_t *tx_stats = &g_can_tx_stats.bus[bus];
+        printf("[sil]   can%d           %10llu tx  %10llu rx  %llu send errors  %lu skipped  %lu mailbox full  "
+               "%lu dropped  load %.1f%% (peak %.1f%%)\n", bus + 1,
+               (unsigned long long)can_stats->frames_tx[bus], (unsigned long long)can_stats->frames_rx[bus],
+               (unsigned long long)can_stats->send_errors[bus],
+               (unsigned long)tx_stats->frames_skipped, (unsigned long)tx_stats->mailbox_full,
+               (unsigned long)tx_stats->frames_dropped, (double)tx_stats->load_percent,
+               (double)tx_stats->peak_load_percent);
+        printf("[sil]   can%d wire      %9.1f%% with stuff bits (peak %.1f%%)  %.0f us longest backlog\n", bus + 1,
+               100.0 * can_stats->wire_bits[bus] / ((double)SIM_CAN_BITRATE * g_sim_tick / 1000.0),
+               can_stats->peak_load[bus], can_stats->max_backlog_us[bus]);
+    }
+    printf("[sil]   can priority   %10lu flushes  %lu cycles max to last gimbal frame\n",
+           (unsigned long)g_can_tx_stats.flushes, (unsigned long)g_can_tx_stats.max_priority_latency);
+    printf("[sil]   feedback->tx   %10lu sets  %8.1f us avg  %lu..%lu cycles\n",
+           (unsigned long)g_control_sync_stats.feedback_sets, Control_Sync_Get_Average_Latency_Us(),
+           (unsigned long)g_control_sync_stats.min_latency, (unsigned long)g_control_sync_stats.max_latency);
+    printf("[sil]   feedback sets  %10lu incomplete  %lu frames missed  missing mask 0x%04lx\n",
+           (unsigned long)g_control_sync_stats.incomplete_sets, (unsigned long)g_control_sync_stats.missed_frames,
+           (unsigned long)g_control_sync_stats.missing_mask);
+#ifdef PROFILER_ENABLED
+    for (int section = 0; section < PROFILE_SECTION_COUNT; section++)
+    {
+        const Profiler_Section_t *profile = &g_profiler_sections[section];
+        printf("[sil]   %-14s %10lu runs  p50 %lu us  p99 %lu us  max %lu us  %lu misses\n", profile->name,
+               (unsigned long)profile->count,
+               (unsigned long)Profiler_Cycles_To_Us(Profiler_Get_Percentile((Profile_Section_e)section, 50.0f)),
+               (unsigned long)Profiler_Cycles_To_Us(Profiler_Get_Percentile((Profile_Section_e)section, 99.0f)),
+               (unsigned long)Profiler_Cycles_To_Us(profile->max), (unsigned long)profile->deadline_misses);
+    }
+#endif
+    for (uint8_t i = 0; i < g_boot_report.stage_count; i++)
+    {
+        printf("[sil]   boot %-17s at %8lu us  took %6lu us\n", g_boot_report.stages[i].name,
+               (unsigned long)g_boot_report.stages[i].start_us, (unsigned long)g_boot_report.stages[i].duration_us);
+    }
+    printf("[sil]   boot ready             at %8lu us\n", (unsigned long)g_boot_report.ready_us);
+#ifdef TELEMETRY_ENABLED
+    printf("[sil]   telemetry      %10lu frames  %lu dropped  %u bytes/frame  %u Hz  %u bytes ring high water  "
+           "%lu sends dropped\n", (unsigned long)g_telemetry_stats.frames, (unsigned long)g_telemetry_stats.dropped_frames,
+           g_telemetry_stats.frame_size, g_telemetry_stats.sample_rate, g_telemetry_stats.ring_high_water,
+           (unsigned long)g_telemetry_stats.dropped_sends);
+#endif
+    const Sim_UART_Stats_t *uart = Sim_UART_Get_Stats();
+    double uart_rate = uart->tx_bytes / (g_sim_tick * (double)SIM_DT);
+    printf("[sil]   huart6         %10llu bytes  %.0f B/s  %.1f %% of %lu baud\n", (unsigned long long)uart->tx_bytes,
+           uart_rate, huart6.Init.BaudRate > 0 ? 100.0 * uart_rate / (huart6.Init.BaudRate / 10.0) : 0.0,
+           (unsigned long)huart6.Init.BaudRate);
+#ifdef ORIN_LINK_ENABLED
+    printf("[sil]   orin tx        %10lu frames  %lu bytes  %lu B/s  %lu dropped\n",
+           (unsigned long)g_orin_link_stats.tx.frames, (unsigned long)g_orin_link_stats.tx.bytes,
+           (unsigned long)g_orin_link_stats.tx.byte_rate, (unsigned long)g_orin_link_stats.tx.dropped);
+    printf("[sil]   orin rx        %10lu frames  %lu bytes  %lu B/s  %lu dropped  %lu lost  %lu unknown\n",
+           (unsigned long)g_orin_link_stats.rx.frames, (unsigned long)g_orin_link_stats.rx.bytes,
+           (unsigned long)g_orin_link_stats.rx.byte_rate, (unsigned long)g_orin_link_stats.rx.dropped,
+           (unsigned long)g_orin_link_stats.rx.lost, (unsigned long)g_orin_link_stats.rx_unknown);
+    Sim_Orin_Report();
+#endif
+    Sim_PTY_Close();
+    Sim_SocketCAN_Close();
+    return 0;
+}
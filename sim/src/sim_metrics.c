@@ -0,0 +1,203 @@
+/**
+ * @file sim_metrics.c
+ * @brief Step response and tracking metrics for the SIL scenarios.
+ *
+ * Step responses report, relative to the commanded change:
+ *  - rise time from 10% to 90%,
+ *  - overshoot past the target,
+ *  - settling time into a 2% band that it does not leave again,
+ *  - steady-state error, the mean of target - value over the last fifth of the window.
+ *
+ * The chassis odometry is checked against the plant in every scenario: its velocity and
+ * heading every tick, its pose at the end, and its slip flag against the wheels whose contact
+ * patch slides faster than SIM_ODOMETRY_SLIP_SPEED.
+ */
+#include <math.h>
+#include <stdio.h>
+
+#include "sim.h"
+#include "chassis_odometry.h"
+#include "fast_math.h"
+
+#define SIM_STEP_SETTLING_BAND (0.02f)
+#define SIM_STEP_STEADY_STATE_FRACTION (5) // last 1/5 of the window
+#define SIM_ODOMETRY_SLIP_SPEED (0.1f)      // m/s, a contact patch sliding faster slips
+
+void Sim_Step_Response_Begin(Sim_Step_Response_t *response, uint32_t tick, float initial, float target)
+{
+    response->start_tick = tick;
+    response->initial = initial;
+    response->target = target;
+    response->count = 0;
+    if (response->window_ms == 0 || response->window_ms > SIM_STEP_MAX_SAMPLES)
+    {
+        response->window_ms = SIM_STEP_MAX_SAMPLES;
+    }
+}
+
+/**
+ * @brief Record value for tick, ignored outside the window that starts at the step.
+ */
+void Sim_Step_Response_Sample(Sim_Step_Response_t *response, uint32_t tick, float value)
+{
+    if (response->window_ms == 0 || tick < response->start_tick || response->count >= response->window_ms)
+    {
+        return;
+    }
+    response->samples[response->count++] = value;
+}
+
+void Sim_Step_Response_Report(const Sim_Step_Response_t *response)
+{
+    if (response->count == 0)
+    {
+        printf("[sil]   step %-16s not reached\n", response->name);
+        return;
+    }
+    float delta = response->target - response->initial;
+    int32_t rise_start = -1, rise_end = -1, settled = 0;
+    float peak = 0.0f;
+    for (uint32_t i = 0; i < response->count; i++)
+    {
+        float progress = (response->samples[i] - response->initial) / delta;
+        if (rise_start < 0 && progress >= 0.1f)
+        {
+            rise_start = i;
+        }
+        if (rise_end < 0 && progress >= 0.9f)
+        {
+            rise_end = i;
+        }
+        peak = progress > peak ? progress : peak;
+        if (fabsf(progress - 1.0f) > SIM_STEP_SETTLING_BAND)
+        {
+            settled = i + 1;
+        }
+    }
+
+    uint32_t steady_count = response->count / SIM_STEP_STEADY_STATE_FRACTION + 1;
+    double steady_error = 0.0;
+    for (uint32_t i = response->count - steady_count; i < response->count; i++)
+    {
+        steady_error += response->target - response->samples[i];
+    }
+    steady_error /= steady_count;
+
+    printf("[sil]   step %-16s %+.3f -> %+.3f %-5s", response->name, (double)response->initial,
+           (double)response->target, response->unit);
+    if (rise_start >= 0 && rise_end >= 0)
+    {
+        printf("  rise %4ld ms", (long)(rise_end - rise_start));
+    }
+    else
+    {
+        printf("  rise    - ms");
+    }
+    printf("  overshoot %5.1f%%", peak > 1.0f ? 100.0 * (peak - 1.0f) : 0.0);
+    if ((uint32_t)settled < response->count)
+    {
+        printf("  settle %4ld ms", (long)settled);
+    }
+    else
+    {
+        printf("  settle    - ms");
+    }
+    printf("  ss error %+.4f %s", steady_error, response->unit);
+    if (response->count < response->window_ms)
+    {
+        printf("  (%lu of %lu ms)", (unsigned long)response->count, (unsigned long)response->window_ms);
+    }
+    printf("\n");
+}
+
+void Sim_Tracking_Sample(Sim_Tracking_t *tracking, float error)
+{
+    tracking->count++;
+    tracking->sum_squares += (double)error * error;
+    if (fabsf(error) > tracking->max_abs)
+    {
+        tracking->max_abs = fabsf(error);
+    }
+}
+
+void Sim_Tracking_Report(const Sim_Tracking_t *tracking)
+{
+    if (tracking->count == 0)
+    {
+        printf("[sil]   track %-15s no samples\n", tracking->name);
+        return;
+    }
+    printf("[sil]   track %-15s rms %.4f %-5s max %.4f %-5s over %llu ms\n", tracking->name,
+           sqrt(tracking->sum_squares / tracking->count), tracking->unit, (double)tracking->max_abs,
+           tracking->unit, (unsigned long long)tracking->count);
+}
+
+#ifdef CHASSIS_ODOMETRY_ENABLED
+static Sim_Tracking_t g_sim_odometry_velocity = {.name = "odom_velocity", .unit = "m/s"};
+static Sim_Tracking_t g_sim_odometry_heading = {.name = "odom_heading", .unit = "rad"};
+static uint32_t g_sim_odometry_slip_ticks = 0;     // plant slipping
+static uint32_t g_sim_odometry_detected_ticks = 0; // plant slipping and flagged
+static uint32_t g_sim_odometry_false_ticks = 0;    // flagged, the plant not slipping
+
+/**
+ * @brief Not with SocketCAN (-c), the plant runs in the other process then.
+ */
+void Sim_Odometry_Update(uint32_t tick)
+{
+    (void)tick;
+    Chassis_Odometry_State_t odometry;
+    Snapshot_Read(&g_chassis_odometry_snapshot, &odometry);
+    if (Sim_SocketCAN_Is_Open() || g_chassis_odometry.slip_cycles + g_chassis_odometry.distance == 0.0f)
+    {
+        return; // nothing published yet, or the robot has not moved
+    }
+    const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+    float sin_heading = sinf(state->heading);
+    float cos_heading = cosf(state->heading);
+    float error_x = odometry.v_x - (cos_heading * state->v_x + sin_heading * state->v_y);
+    float error_y = odometry.v_y - (-sin_heading * state->v_x + cos_heading * state->v_y);
+    Sim_Tracking_Sample(&g_sim_odometry_velocity, sqrtf(error_x * error_x + error_y * error_y));
+    Sim_Tracking_Sample(&g_sim_odometry_heading, Angle_Difference(odometry.heading, state->heading));
+
+    uint8_t slipping = 0;
+    for (int i = 0; i < SIM_PLANT_MODULES; i++)
+    {
+        slipping |= state->wheel_slip[i] > SIM_ODOMETRY_SLIP_SPEED;
+    }
+    g_sim_odometry_slip_ticks += slipping;
+    g_sim_odometry_detected_ticks += slipping && odometry.slip;
+    g_sim_odometry_false_ticks += !slipping && odometry.slip;
+}
+
+void Sim_Odometry_Report(void)
+{
+    if (Sim_SocketCAN_Is_Open())
+    {
+        return;
+    }
+    Sim_Tracking_Report(&g_sim_odometry_velocity);
+    Sim_Tracking_Report(&g_sim_odometry_heading);
+    const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+    float error_x = g_chassis_odometry.state.x - state->x;
+    float error_y = g_chassis_odometry.state.y - state->y;
+    float error = sqrtf(error_x * error_x + error_y * error_y);
+    printf("[sil]   odometry       %10.3f m pose error after %.2f m  (%.2f %%)\n", (double)error,
+           (double)g_chassis_odometry.distance,
+           g_chassis_odometry.distance > 0.0f ? 100.0 * error / g_chassis_odometry.distance : 0.0);
+    printf("[sil]   odometry slip  %10lu ms plant slipping  %lu flagged  %lu flagged not slipping  "
+           "%lu cycles  modules %lu %lu %lu %lu\n",
+           (unsigned long)g_sim_odometry_slip_ticks, (unsigned long)g_sim_odometry_detected_ticks,
+           (unsigned long)g_sim_odometry_false_ticks, (unsigned long)g_chassis_odometry.slip_cycles,
+           (unsigned long)g_chassis_odometry.module_slips[0], (unsigned long)g_chassis_odometry.module_slips[1],
+           (unsigned long)g_chassis_odometry.module_slips[2], (unsigned long)g_chassis_odometry.module_slips[3]);
+}
+#else
+void Sim_Odometry_Update(uint32_t tick)
+{
+    (void)tick;
+}
+
+void Sim_Odometry_Report(void)
+{
+}
+#endif
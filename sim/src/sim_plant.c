@@ -0,0 +1,556 @@
+/**
+ * @file sim_plant.c
+ * @brief Physical plant for the SIL build: DJI motors on a swerve chassis and a 2-axis gimbal.
+ *
+ * Current commands are decoded from the DJI group frames (0x200/0x1FF/0x2FF/0x1FE/0x2FE). Every
+ * motor in the layout table is a first-order electrical model driving its load:
+ *  - GM6020 in voltage mode, current set by the winding resistance and back-EMF,
+ *  - M3508 (C620) and M2006 (C610) in current mode, limited by the back-EMF headroom of the
+ *    24 V supply so torque falls off towards no-load speed,
+ *  - the drive and azimuth motors move a rigid-body chassis on four swerve modules at
+ *    (+-WHEEL_BASE/2, +-TRACK_WIDTH/2), each wheel with longitudinal slip and lateral scrub
+ *    forces inside a friction circle,
+ *  - the yaw motor turns the gimbal in the world frame (bearing friction and reaction torque
+ *    against the chassis), the pitch motor works against gravity between two hard stops,
+ *  - the flywheels are free inertias, so is the feeder unless a scenario jams it: a projectile
+ *    wedged ahead of it stops it dead until it backs off SIM_FEEDER_JAM_CLEARANCE.
+ * Motors missing from the table still answer as a free M3508. The rigid-body state integrates
+ * at SIM_PLANT_SUBSTEPS per call. Feedback frames use the DJI layout: angle[0:1] (0-8191),
+ * rpm[2:3], current[4:5], temperature[6], all big-endian.
+ *
+ * Frames: chassis x/y as in swerve_locomotion, z up, angles counter-clockwise. The world frame
+ * matches the chassis frame at start up.
+ */
+#include <math.h>
+#include <string.h>
+
+#include "sim.h"
+#include "chassis_task.h"
+
+#define SIM_PLANT_MAX_MOTORS (16)
+#define SIM_PLANT_SUBSTEPS (10)
+#define SIM_PLANT_TICKS_PER_REV (8192.0f)
+#define SIM_PLANT_TWO_PI (6.28318531f)
+#define SIM_PLANT_SUPPLY_VOLTAGE (24.0f)
+#define SIM_PLANT_GRAVITY (9.81f)
+
+// chassis, 4 modules
+#define SIM_CHASSIS_MASS (20.0f)            // kg
+#define SIM_CHASSIS_INERTIA (0.8f)          // kg m^2 about z
+#define SIM_WHEEL_INERTIA (0.008f)          // kg m^2, wheel plus reflected M3508 rotor
+#define SIM_WHEEL_FRICTION (0.8f)           // tire to floor
+#define SIM_WHEEL_SLIP_STIFFNESS (2000.0f)  // N per m/s of longitudinal slip
+#define SIM_WHEEL_SCRUB_DAMPING (2000.0f)   // N per m/s of lateral slip
+#define SIM_WHEEL_ROLLING_DRAG (0.5f)       // N per m/s, bearings and tire
+#define SIM_AZIMUTH_INERTIA (0.004f)        // kg m^2, module about its steering axis
+#define SIM_AZIMUTH_DAMPING (0.02f)         // N m per rad/s
+#define SIM_AZIMUTH_TWIST_TORQUE (0.25f)    // N m, tire patch twisting on the floor
+#define SIM_AZIMUTH_TWIST_RATE (0.2f)       // rad/s below which the twist torque fades out
+
+// gimbal
+#define SIM_YAW_INERTIA (0.03f)             // kg m^2
+#define SIM_YAW_FRICTION (0.02f)            // N m per rad/s relative to the chassis
+#define SIM_PITCH_INERTIA (0.01f)           // kg m^2
+#define SIM_PITCH_DAMPING (0.005f)          // N m per rad/s
+#define SIM_PITCH_GRAVITY_TORQUE (0.3f)     // N m at level, the barrel end is heavier
+#define SIM_PITCH_LIMIT (0.6f)              // rad, hard stops either way
+
+// feeder
+#define SIM_FEEDER_JAM_CLEARANCE (0.2f)     // rad at the output the feeder backs off a jam to free it
+
+typedef enum
+{
+    SIM_MOTOR_GM6020,
+    SIM_MOTOR_M3508,
+    SIM_MOTOR_M2006,
+} Sim_Motor_Type_e;
+
+typedef enum
+{
+    SIM_LOAD_FREE,    // rotor plus a fixed inertia
+    SIM_LOAD_DRIVE,   // wheel of module index
+    SIM_LOAD_AZIMUTH, // steering of module index
+    SIM_LOAD_YAW,
+    SIM_LOAD_PITCH,
+    SIM_LOAD_FEEDER,  // free, up to the jam while jammed
+} Sim_Load_e;
+
+typedef struct
+{
+    float command_max;     // command that maps to full_scale
+    float full_scale;      // V for voltage mode, A for current mode
+    uint8_t voltage_mode;
+    float torque_constant; // N m/A at the rotor
+    float back_emf;        // V per rad/s at the rotor
+    float resistance;      // ohm
+    float current_limit;   // A
+    float gear_ratio;      // rotor turns per output turn
+    float free_inertia;    // kg m^2 at the rotor for SIM_LOAD_FREE
+    float free_damping;    // N m per rad/s at the rotor for SIM_LOAD_FREE
+} Sim_Motor_Params_t;
+
+static const Sim_Motor_Params_t g_sim_motor_params[] = {
+    [SIM_MOTOR_GM6020] = {30000.0f, 24.0f, 1, 0.741f, 0.716f, 1.8f, 3.9f, 1.0f, 0.002f, 0.001f},
+    [SIM_MOTOR_M3508] = {16384.0f, 20.0f, 0, 0.0156f, 0.0248f, 0.194f, 20.0f, 3591.0f / 187.0f, 3.0e-5f, 1.0e-5f},
+    [SIM_MOTOR_M2006] = {10000.0f, 10.0f, 0, 0.005f, 0.0127f, 0.3f, 10.0f, 36.0f, 1.0e-5f, 2.0e-6f},
+};
+
+typedef struct
+{
+    uint8_t can_bus;
+    uint16_t rx_id;
+    Sim_Motor_Type_e type;
+    Sim_Load_e load;
+    uint8_t index;    // module for SIM_LOAD_DRIVE/SIM_LOAD_AZIMUTH
+    int8_t direction; // -1 where the firmware config has MOTOR_REVERSAL_REVERSED
+    uint16_t offset;  // encoder tick at zero load angle
+} Sim_Motor_Layout_t;
+
+// Mirrors the Motor_Config_t of chassis_task.c, gimbal_task.c and launch_task.c
+static const Sim_Motor_Layout_t g_sim_motor_layout[] = {
+    {1, 0x201, SIM_MOTOR_M3508, SIM_LOAD_DRIVE, 0, 1, 0},
+    {1, 0x202, SIM_MOTOR_M2006, SIM_LOAD_FEEDER, 0, 1, 0},
+    {1, 0x204, SIM_MOTOR_M3508, SIM_LOAD_FREE, 0, -1, 0},     // left flywheel
+    {1, 0x205, SIM_MOTOR_M3508, SIM_LOAD_FREE, 0, 1, 0},      // right flywheel
+    {1, 0x206, SIM_MOTOR_GM6020, SIM_LOAD_PITCH, 0, 1, 4460},
+    {1, 0x207, SIM_MOTOR_GM6020, SIM_LOAD_YAW, 0, 1, 2400},
+    {2, 0x202, SIM_MOTOR_M3508, SIM_LOAD_DRIVE, 1, 1, 0},
+    {2, 0x203, SIM_MOTOR_M3508, SIM_LOAD_DRIVE, 2, -1, 0},
+    {2, 0x204, SIM_MOTOR_M3508, SIM_LOAD_DRIVE, 3, -1, 0},
+    {2, 0x205, SIM_MOTOR_GM6020, SIM_LOAD_AZIMUTH, 0, -1, 2050},
+    {2, 0x206, SIM_MOTOR_GM6020, SIM_LOAD_AZIMUTH, 1, -1, 1940},
+    {2, 0x207, SIM_MOTOR_GM6020, SIM_LOAD_AZIMUTH, 2, -1, 1430},
+    {2, 0x208, SIM_MOTOR_GM6020, SIM_LOAD_AZIMUTH, 3, -1, 8150},
+};
+
+#define SIM_MOTOR_LAYOUT_COUNT (sizeof(g_sim_motor_layout) / sizeof(g_sim_motor_layout[0]))
+
+// same module order as swerve_calculate_kinematics
+static const float g_sim_module_x[SIM_PLANT_MODULES] = {WHEEL_BASE / 2, -WHEEL_BASE / 2, -WHEEL_BASE / 2, WHEEL_BASE / 2};
+static const float g_sim_module_y[SIM_PLANT_MODULES] = {TRACK_WIDTH / 2, TRACK_WIDTH / 2, -TRACK_WIDTH / 2, -TRACK_WIDTH / 2};
+
+typedef struct
+{
+    Sim_Motor_Layout_t layout;
+    int16_t command;
+    float current;  // A
+    float torque;   // N m at the rotor
+    float position; // rad at the rotor, relative to the encoder offset
+    float velocity; // rad/s at the rotor
+    uint8_t offline; // unplugged: no current, no feedback
+} Sim_Motor_t;
+
+static float g_sim_wheel_friction[SIM_PLANT_MODULES]; // tire to floor under each module
+
+static Sim_Motor_t g_sim_motors[SIM_PLANT_MAX_MOTORS];
+static uint8_t g_sim_motor_count = 0;
+static Sim_Plant_State_t g_sim_plant_state;
+static Sim_Plant_Stats_t g_sim_plant_stats;
+static double g_sim_plant_update_energy; // J drawn by the chassis motors since the last update
+
+static Sim_Motor_t *Sim_Plant_Add_Motor(const Sim_Motor_Layout_t *layout)
+{
+    if (g_sim_motor_count >= SIM_PLANT_MAX_MOTORS)
+    {
+        return NULL;
+    }
+    Sim_Motor_t *motor = &g_sim_motors[g_sim_motor_count++];
+    memset(motor, 0, sizeof(Sim_Motor_t));
+    motor->layout = *layout;
+    return motor;
+}
+
+static Sim_Motor_t *Sim_Plant_Find_Motor(uint8_t can_bus, uint16_t rx_id)
+{
+    for (int i = 0; i < g_sim_motor_count; i++)
+    {
+        if (g_sim_motors[i].layout.can_bus == can_bus && g_sim_motors[i].layout.rx_id == rx_id)
+        {
+            return &g_sim_motors[i];
+        }
+    }
+    return NULL;
+}
+
+void Sim_Plant_Init(void)
+{
+    g_sim_motor_count = 0;
+    memset(&g_sim_plant_state, 0, sizeof(g_sim_plant_state));
+    memset(&g_sim_plant_stats, 0, sizeof(g_sim_plant_stats));
+    g_sim_plant_update_energy = 0.0;
+    for (int i = 0; i < SIM_PLANT_MODULES; i++)
+    {
+        g_sim_wheel_friction[i] = SIM_WHEEL_FRICTION;
+    }
+    for (size_t i = 0; i < SIM_MOTOR_LAYOUT_COUNT; i++)
+    {
+        Sim_Plant_Add_Motor(&g_sim_motor_layout[i]);
+    }
+}
+
+/**
+ * @brief Wedge a projectile distance (rad at the output) ahead of the feeder, it stops there
+ * until it backs off SIM_FEEDER_JAM_CLEARANCE.
+ */
+void Sim_Plant_Jam_Feeder(float distance)
+{
+    g_sim_plant_state.feeder_jam = g_sim_plant_state.feeder_angle + distance;
+    g_sim_plant_state.feeder_jammed = 1;
+    g_sim_plant_state.feeder_jam_reached = 0;
+    g_sim_plant_stats.feeder_jams++;
+}
+
+/**
+ * @brief Unplug a motor or plug it back in. Unplugged it neither drives its load nor reports.
+ */
+void Sim_Plant_Set_Motor_Online(uint8_t can_bus, uint16_t rx_id, uint8_t online)
+{
+    Sim_Motor_t *motor = Sim_Plant_Find_Motor(can_bus, rx_id);
+    if (motor != NULL)
+    {
+        motor->offline = !online;
+    }
+}
+
+/**
+ * @brief Friction of the floor under one module, e.g. a wheel on a slippery patch.
+ */
+void Sim_Plant_Set_Wheel_Friction(int module, float friction)
+{
+    g_sim_wheel_friction[module] = friction;
+}
+
+const Sim_Plant_State_t *Sim_Plant_Get_State(void)
+{
+    return &g_sim_plant_state;
+}
+
+const Sim_Plant_Stats_t *Sim_Plant_Get_Stats(void)
+{
+    return &g_sim_plant_stats;
+}
+
+void Sim_Plant_On_Transmit(uint8_t can_bus, uint16_t tx_id, const uint8_t data[8])
+{
+    uint16_t first_rx_id;
+    switch (tx_id)
+    {
+    case 0x200:
+        first_rx_id = 0x201;
+        break;
+    case 0x1FF:
+    case 0x1FE:
+        first_rx_id = 0x205;
+        break;
+    case 0x2FF:
+    case 0x2FE:
+        first_rx_id = 0x209;
+        break;
+    default:
+        return; // not a DJI group frame
+    }
+
+    for (int slot = 0; slot < 4; slot++)
+    {
+        int16_t command = (int16_t)((data[2 * slot] << 8) | data[2 * slot + 1]);
+        Sim_Motor_t *motor = Sim_Plant_Find_Motor(can_bus, first_rx_id + slot);
+        if (motor == NULL && command != 0)
+        {
+            // commanded but not in the layout, an unloaded M3508 answers. Slots never commanded
+            // have no ESC behind them and put no feedback on the bus
+            const Sim_Motor_Layout_t unknown = {can_bus, (uint16_t)(first_rx_id + slot), SIM_MOTOR_M3508, SIM_LOAD_FREE, 0, 1, 0};
+            motor = Sim_Plant_Add_Motor(&unknown);
+        }
+        if (motor != NULL)
+        {
+            motor->command = command;
+        }
+    }
+}
+
+static float Sim_Plant_Clamp(float value, float limit)
+{
+    return value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+static float Sim_Plant_Wrap(float angle)
+{
+    return angle - SIM_PLANT_TWO_PI * floorf((angle + SIM_PLANT_TWO_PI / 2) / SIM_PLANT_TWO_PI);
+}
+
+/**
+ * @brief Winding current for the latest command at the present rotor speed, sets torque.
+ */
+static void Sim_Plant_Update_Current(Sim_Motor_t *motor)
+{
+    const Sim_Motor_Params_t *params = &g_sim_motor_params[motor->layout.type];
+    float setpoint = motor->command / params->command_max * params->full_scale;
+    float back_emf = params->back_emf * motor->velocity;
+    float current;
+    if (params->voltage_mode)
+    {
+        current = (setpoint - back_emf) / params->resistance;
+    }
+    else
+    {
+        // the ESC current loop holds the setpoint until the supply runs out of headroom
+        float headroom_positive = fmaxf((SIM_PLANT_SUPPLY_VOLTAGE - back_emf) / params->resistance, 0.0f);
+        float headroom_negative = fmaxf((SIM_PLANT_SUPPLY_VOLTAGE + back_emf) / params->resistance, 0.0f);
+        current = setpoint > 0.0f ? fminf(setpoint, headroom_positive) : fmaxf(setpoint, -headroom_negative);
+    }
+    motor->current = motor->offline ? 0.0f : Sim_Plant_Clamp(current, params->current_limit);
+    motor->torque = params->torque_constant * motor->current;
+}
+
+/**
+ * @brief Torque a motor delivers at its load, after the gearbox and the mounting direction.
+ */
+static float Sim_Plant_Load_Torque(const Sim_Motor_t *motor)
+{
+    return motor->layout.direction * motor->torque * g_sim_motor_params[motor->layout.type].gear_ratio;
+}
+
+/**
+ * @brief Hold the feeder at the jam while it pushes into it, free it once it has backed off
+ * from it.
+ */
+static void Sim_Plant_Feeder_Jam(Sim_Motor_t *motor, float gear_ratio)
+{
+    Sim_Plant_State_t *state = &g_sim_plant_state;
+    float angle = motor->layout.direction * motor->position / gear_ratio;
+    if (state->feeder_jammed)
+    {
+        if (angle >= state->feeder_jam)
+        {
+            angle = state->feeder_jam;
+            state->feeder_jam_reached = 1;
+            motor->position = motor->layout.direction * angle * gear_ratio;
+            if (motor->layout.direction * motor->velocity > 0.0f)
+            {
+                motor->velocity = 0.0f;
+            }
+        }
+        else if (state->feeder_jam_reached && angle < state->feeder_jam - SIM_FEEDER_JAM_CLEARANCE)
+        {
+            state->feeder_jammed = 0;
+            g_sim_plant_stats.feeder_jams_cleared++;
+        }
+    }
+    state->feeder_angle = angle;
+}
+
+static void Sim_Plant_Step(float dt)
+{
+    Sim_Plant_State_t *state = &g_sim_plant_state;
+    float drive_torque[SIM_PLANT_MODULES] = {0};
+    float azimuth_torque[SIM_PLANT_MODULES] = {0};
+    float yaw_torque = 0.0f;
+    float pitch_torque = 0.0f;
+    float chassis_power = 0.0f;
+    float chassis_current = 0.0f;
+
+    for (int i = 0; i < g_sim_motor_count; i++)
+    {
+        Sim_Motor_t *motor = &g_sim_motors[i];
+        const Sim_Motor_Params_t *params = &g_sim_motor_params[motor->layout.type];
+        Sim_Plant_Update_Current(motor);
+        if (motor->layout.load == SIM_LOAD_DRIVE || motor->layout.load == SIM_LOAD_AZIMUTH)
+        {
+            // copper loss plus mechanical power, negative while braking
+            chassis_power += motor->current * (motor->current * params->resistance + params->back_emf * motor->velocity);
+            chassis_current += fabsf(motor->current);
+        }
+        switch (motor->layout.load)
+        {
+        case SIM_LOAD_DRIVE:
+            drive_torque[motor->layout.index] = Sim_Plant_Load_Torque(motor);
+            break;
+        case SIM_LOAD_AZIMUTH:
+            azimuth_torque[motor->layout.index] = Sim_Plant_Load_Torque(motor);
+            g_sim_plant_stats.azimuth_charge += fabsf(motor->current) * dt;
+            break;
+        case SIM_LOAD_YAW:
+            yaw_torque = Sim_Plant_Load_Torque(motor);
+            break;
+        case SIM_LOAD_PITCH:
+            pitch_torque = Sim_Plant_Load_Torque(motor);
+            break;
+        case SIM_LOAD_FEEDER:
+        default:
+            motor->velocity += (motor->torque - params->free_damping * motor->velocity) / params->free_inertia * dt;
+            break;
+        }
+    }
+
+    // chassis velocity in the chassis frame
+    float sin_heading = sinf(state->heading);
+    float cos_heading = cosf(state->heading);
+    float body_v_x = cos_heading * state->v_x + sin_heading * state->v_y;
+    float body_v_y = -sin_heading * state->v_x + cos_heading * state->v_y;
+
+    float wheel_radius = WHEEL_DIAMETER / 2;
+    float wheel_mass = SIM_WHEEL_INERTIA / (wheel_radius * wheel_radius); // at the contact patch
+    float wheel_load = SIM_CHASSIS_MASS * SIM_PLANT_GRAVITY / SIM_PLANT_MODULES;
+    float force_x = 0.0f, force_y = 0.0f, torque_z = 0.0f;
+    for (int i = 0; i < SIM_PLANT_MODULES; i++)
+    {
+        float contact_v_x = body_v_x - state->omega * g_sim_module_y[i];
+        float contact_v_y = body_v_y + state->omega * g_sim_module_x[i];
+        float cos_angle = cosf(state->module_angle[i]);
+        float sin_angle = sinf(state->module_angle[i]);
+        float rolling = contact_v_x * cos_angle + contact_v_y * sin_angle;
+        float lateral = -contact_v_x * sin_angle + contact_v_y * cos_angle;
+
+        float longitudinal_force = SIM_WHEEL_SLIP_STIFFNESS * (state->wheel_speed[i] - rolling);
+        float lateral_force = -SIM_WHEEL_SCRUB_DAMPING * lateral;
+        float magnitude = sqrtf(longitudinal_force * longitudinal_force + lateral_force * lateral_force);
+        float traction_limit = g_sim_wheel_friction[i] * wheel_load;
+        if (magnitude > traction_limit)
+        {
+            longitudinal_force *= traction_limit / magnitude;
+            lateral_force *= traction_limit / magnitude;
+        }
+
+        float slip = state->wheel_speed[i] - rolling;
+        state->wheel_slip[i] = sqrtf(slip * slip + lateral * lateral);
+        g_sim_plant_stats.scrub_energy += fabsf(lateral_force * lateral) * dt;
+        g_sim_plant_stats.slip_energy += fabsf(longitudinal_force * (state->wheel_speed[i] - rolling)) * dt;
+
+        float module_force_x = longitudinal_force * cos_angle - lateral_force * sin_angle;
+        float module_force_y = longitudinal_force * sin_angle + lateral_force * cos_angle;
+        force_x += module_force_x;
+        force_y += module_force_y;
+        torque_z += g_sim_module_x[i] * module_force_y - g_sim_module_y[i] * module_force_x;
+
+        float wheel_force = drive_torque[i] / wheel_radius - longitudinal_force - SIM_WHEEL_ROLLING_DRAG * state->wheel_speed[i];
+        state->wheel_speed[i] += wheel_force / wheel_mass * dt;
+        // dry friction of the contact patch, linear through zero so the integration does not chatter
+        float twist = Sim_Plant_Clamp(SIM_AZIMUTH_TWIST_TORQUE * state->module_rate[i] / SIM_AZIMUTH_TWIST_RATE,
+                                      SIM_AZIMUTH_TWIST_TORQUE);
+        state->module_rate[i] +=
+            (azimuth_torque[i] - twist - SIM_AZIMUTH_DAMPING * state->module_rate[i]) / SIM_AZIMUTH_INERTIA * dt;
+        state->module_angle[i] = Sim_Plant_Wrap(state->module_angle[i] + state->module_rate[i] * dt);
+    }
+
+    // gimbal yaw turns in the world frame, its motor and bearing push back on the chassis
+    float yaw_bearing = SIM_YAW_FRICTION * (state->gimbal_yaw_rate - state->omega);
+    state->gimbal_yaw_rate += (yaw_torque - yaw_bearing) / SIM_YAW_INERTIA * dt;
+    state->gimbal_yaw = Sim_Plant_Wrap(state->gimbal_yaw + state->gimbal_yaw_rate * dt);
+    torque_z += yaw_bearing - yaw_torque;
+
+    float gravity = SIM_PITCH_GRAVITY_TORQUE * cosf(state->gimbal_pitch);
+    state->gimbal_pitch_rate += (pitch_torque - gravity - SIM_PITCH_DAMPING * state->gimbal_pitch_rate) / SIM_PITCH_INERTIA * dt;
+    state->gimbal_pitch += state->gimbal_pitch_rate * dt;
+    if (fabsf(state->gimbal_pitch) > SIM_PITCH_LIMIT)
+    {
+        state->gimbal_pitch = Sim_Plant_Clamp(state->gimbal_pitch, SIM_PITCH_LIMIT);
+        state->gimbal_pitch_rate = 0.0f;
+    }
+
+    state->v_x += (cos_heading * force_x - sin_heading * force_y) / SIM_CHASSIS_MASS * dt;
+    state->v_y += (sin_heading * force_x + cos_heading * force_y) / SIM_CHASSIS_MASS * dt;
+    state->omega += torque_z / SIM_CHASSIS_INERTIA * dt;
+    state->x += state->v_x * dt;
+    state->y += state->v_y * dt;
+    state->heading = Sim_Plant_Wrap(state->heading + state->omega * dt);
+
+    g_sim_plant_update_energy += chassis_power * dt;
+    g_sim_plant_stats.chassis_energy += chassis_power * dt;
+    if (chassis_current > g_sim_plant_stats.peak_chassis_current)
+    {
+        g_sim_plant_stats.peak_chassis_current = chassis_current;
+    }
+
+    // rotors follow their loads
+    for (int i = 0; i < g_sim_motor_count; i++)
+    {
+        Sim_Motor_t *motor = &g_sim_motors[i];
+        float gear_ratio = g_sim_motor_params[motor->layout.type].gear_ratio;
+        uint8_t index = motor->layout.index;
+        switch (motor->layout.load)
+        {
+        case SIM_LOAD_DRIVE:
+            motor->velocity = motor->layout.direction * state->wheel_speed[index] / wheel_radius * gear_ratio;
+            break;
+        case SIM_LOAD_AZIMUTH:
+            motor->velocity = motor->layout.direction * state->module_rate[index];
+            break;
+        case SIM_LOAD_YAW:
+            motor->velocity = motor->layout.direction * (state->gimbal_yaw_rate - state->omega);
+            break;
+        case SIM_LOAD_PITCH:
+            motor->velocity = motor->layout.direction * state->gimbal_pitch_rate;
+            break;
+        default:
+            break;
+        }
+        motor->position += motor->velocity * dt;
+        if (motor->layout.load == SIM_LOAD_FEEDER)
+        {
+            Sim_Plant_Feeder_Jam(motor, gear_ratio);
+        }
+    }
+}
+
+/**
+ * @brief Encoder angle of a direct drive motor is its load angle, no need to integrate.
+ */
+static void Sim_Plant_Sync_Direct_Drive(Sim_Motor_t *motor)
+{
+    const Sim_Plant_State_t *state = &g_sim_plant_state;
+    switch (motor->layout.load)
+    {
+    case SIM_LOAD_AZIMUTH:
+        motor->position = motor->layout.direction * state->module_angle[motor->layout.index];
+        break;
+    case SIM_LOAD_YAW:
+        motor->position = motor->layout.direction * Sim_Plant_Wrap(state->gimbal_yaw - state->heading);
+        break;
+    case SIM_LOAD_PITCH:
+        motor->position = motor->layout.direction * state->gimbal_pitch;
+        break;
+    default:
+        break;
+    }
+}
+
+void Sim_Plant_Update(float dt)
+{
+    for (int substep = 0; substep < SIM_PLANT_SUBSTEPS; substep++)
+    {
+        Sim_Plant_Step(dt / SIM_PLANT_SUBSTEPS);
+    }
+    g_sim_plant_stats.chassis_power = (float)(g_sim_plant_update_energy / dt);
+    g_sim_plant_update_energy = 0.0;
+    if (g_sim_plant_stats.chassis_power > g_sim_plant_stats.peak_chassis_power)
+    {
+        g_sim_plant_stats.peak_chassis_power = g_sim_plant_stats.chassis_power;
+    }
+
+    for (int i = 0; i < g_sim_motor_count; i++)
+    {
+        Sim_Motor_t *motor = &g_sim_motors[i];
+        const Sim_Motor_Params_t *params = &g_sim_motor_params[motor->layout.type];
+        Sim_Plant_Sync_Direct_Drive(motor);
+        if (motor->offline)
+        {
+            continue;
+        }
+
+        float ticks = fmodf(motor->layout.offset + motor->position / SIM_PLANT_TWO_PI * SIM_PLANT_TICKS_PER_REV,
+                            SIM_PLANT_TICKS_PER_REV);
+        if (ticks < 0.0f)
+        {
+            ticks += SIM_PLANT_TICKS_PER_REV;
+        }
+        uint16_t angle = (uint16_t)ticks % (uint16_t)SIM_PLANT_TICKS_PER_REV;
+        int16_t rpm = (int16_t)(motor->velocity * 60.0f / SIM_PLANT_TWO_PI);
+        int16_t current = (int16_t)(motor->current / params->current_limit * params->command_max);
+        uint8_t feedback[8] = {
+            angle >> 8, angle & 0xFF,
+            (uint16_t)rpm >> 8, rpm & 0xFF,
+            (uint16_t)current >> 8, current & 0xFF,
+            25, 0};
+        Sim_CAN_Receive(motor->layout.can_bus, motor->layout.rx_id, feedback);
+    }
+}
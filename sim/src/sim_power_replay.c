@@ -0,0 +1,136 @@
+/**
+ * @file sim_power_replay.c
+ * @brief Host check for app/src/power_limiter.c driven by a recorded referee trace.
+ *
+ * The trace is tools/telemetry_decode.py CSV with the tick_ms, chassis_power and power_buffer
+ * columns, chassis_power_max is used when present. Every millisecond between rows the referee
+ * state is set from the trace and the limiter runs as it would in the motor task, with no
+ * motors registered. The check fails when the running average drifts from a brute force mean
+ * over the same samples, or the budget goes negative, or is above the limit while the recorded
+ * buffer is at or below the reserve.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "power_limiter.h"
+#include "referee_system.h"
+#include "robot.h"
+
+#define REPLAY_LINE_LENGTH (4096)
+#define REPLAY_AVERAGE_TOLERANCE (1e-3f) // W
+
+// column index of name in a CSV header, -1 when missing
+static int Replay_Column(const char *line, const char *name)
+{
+    char header[REPLAY_LINE_LENGTH];
+    strcpy(header, line);
+    int column = 0;
+    for (char *field = strtok(header, ",\r\n"); field != NULL; field = strtok(NULL, ",\r\n"), column++)
+    {
+        if (strcmp(field, name) == 0)
+        {
+            return column;
+        }
+    }
+    return -1;
+}
+
+static int Replay_Fields(char *line, double *fields, int max_fields)
+{
+    int count = 0;
+    for (char *field = strtok(line, ",\r\n"); field != NULL && count < max_fields; field = strtok(NULL, ",\r\n"))
+    {
+        fields[count++] = strtod(field, NULL);
+    }
+    return count;
+}
+
+int Sim_Stress_Power_Replay(const char *trace_path)
+{
+    FILE *trace = trace_path != NULL ? fopen(trace_path, "r") : NULL;
+    if (trace == NULL)
+    {
+        fprintf(stderr, "power replay needs a trace, -r capture.csv from tools/telemetry_decode.py\n");
+        return 1;
+    }
+
+    static char line[REPLAY_LINE_LENGTH];
+    int tick_column = -1, power_column = -1, buffer_column = -1, limit_column = -1;
+    if (fgets(line, sizeof(line), trace) != NULL)
+    {
+        tick_column = Replay_Column(line, "tick_ms");
+        power_column = Replay_Column(line, "chassis_power");
+        buffer_column = Replay_Column(line, "power_buffer");
+        limit_column = Replay_Column(line, "chassis_power_max");
+    }
+    if (tick_column < 0 || power_column < 0 || buffer_column < 0)
+    {
+        fprintf(stderr, "%s: needs tick_ms, chassis_power and power_buffer columns\n", trace_path);
+        fclose(trace);
+        return 1;
+    }
+
+    float window[BUFFER_SIZE];
+    uint32_t window_count = 0, window_index = 0;
+    uint32_t rows = 0, cycles = 0, negative_budget = 0, over_limit = 0, limited_cycles = 0;
+    float max_average_error = 0.0f, min_buffer = INFINITY;
+    double last_tick = -1.0;
+    static double fields[REPLAY_LINE_LENGTH / 2];
+    while (fgets(line, sizeof(line), trace) != NULL)
+    {
+        int count = Replay_Fields(line, fields, sizeof(fields) / sizeof(fields[0]));
+        if (count <= tick_column || count <= power_column || count <= buffer_column)
+        {
+            continue;
+        }
+        rows++;
+        double tick = fields[tick_column];
+        Referee_Robot_State.Chassis_Power = (float)fields[power_column];
+        Referee_Robot_State.Power_Buffer = (uint16_t)fields[buffer_column];
+        Referee_Robot_State.Chassis_Power_Max = limit_column >= 0 && count > limit_column ? (uint16_t)fields[limit_column] : 0;
+        float recorded_buffer = Referee_Robot_State.Power_Buffer;
+        min_buffer = recorded_buffer < min_buffer ? recorded_buffer : min_buffer;
+
+        // the limiter runs every ms, the first row only starts the clock
+        uint32_t steps = last_tick < 0.0 || tick <= last_tick ? 1 : (uint32_t)(tick - last_tick);
+        last_tick = tick;
+        for (uint32_t step = 0; step < steps; step++)
+        {
+            uint32_t samples = g_power_limiter.referee_samples;
+            Power_Limiter_Apply();
+            cycles++;
+            if (g_power_limiter.referee_samples != samples)
+            {
+                window[window_index] = Referee_Robot_State.Chassis_Power;
+                window_index = (window_index + 1) % BUFFER_SIZE;
+                window_count = window_count < BUFFER_SIZE ? window_count + 1 : BUFFER_SIZE;
+                float sum = 0.0f;
+                for (uint32_t i = 0; i < window_count; i++)
+                {
+                    sum += window[i];
+                }
+                float error = fabsf(g_robot_state.chassis.avg_power - sum / window_count);
+                max_average_error = error > max_average_error ? error : max_average_error;
+                // between samples the predicted buffer may refill above the reserve
+                over_limit += recorded_buffer <= POWER_LIMITER_BUFFER_RESERVE && g_power_limiter.budget > g_power_limiter.limit;
+            }
+            negative_budget += g_power_limiter.budget < 0.0f;
+            limited_cycles += g_power_limiter.budget < g_power_limiter.limit;
+        }
+    }
+    fclose(trace);
+
+    printf("[sil] power replay: %s, %u rows, %u referee samples, %u ms\n", trace_path, rows,
+           g_power_limiter.referee_samples, cycles);
+    printf("[sil]   average error  %.6f W (tolerance %.3f)\n", max_average_error, REPLAY_AVERAGE_TOLERANCE);
+    printf("[sil]   budget         %u ms negative  %u samples above the limit at or below the reserve\n",
+           negative_budget, over_limit);
+    printf("[sil]   trace buffer   min %.0f J, budget below the limit for %u ms\n", min_buffer, limited_cycles);
+    return g_power_limiter.referee_samples > 0 && max_average_error <= REPLAY_AVERAGE_TOLERANCE &&
+                   negative_budget == 0 && over_limit == 0
+               ? 0
+               : 1;
+}
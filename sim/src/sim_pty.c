@@ -0,0 +1,123 @@
+/**
+ * @file sim_pty.c
+ * @brief huart6 over a pseudo-terminal, so a host program talks to the SIL firmware the way the
+ * Orin does over the board's UART.
+ *
+ * Everything the firmware transmits on huart6 (the telemetry stream with the Orin link's frames)
+ * is written to the master side, and bytes written to the slave side are delivered to huart6's
+ * receive DMA every tick. The slave is raw and stays open on this side too, so a stand-in can
+ * attach and detach while the firmware runs, e.g.
+ *   control-template-sil -s strafe -p &
+ *   python tools/orin_standin.py /dev/pts/N
+ */
+#define _GNU_SOURCE // posix_openpt, ptsname and cfmakeraw, before any system header
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+static int g_sim_pty_master = -1;
+static int g_sim_pty_slave = -1; // held so the master does not see a hangup without a stand-in
+
+/**
+ * @return the slave's path, NULL if no pseudo-terminal could be opened
+ */
+const char *Sim_PTY_Open(void)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        perror("[sil] posix_openpt");
+        if (master >= 0)
+        {
+            close(master);
+        }
+        return NULL;
+    }
+    const char *name = ptsname(master);
+    int slave = name != NULL ? open(name, O_RDWR | O_NOCTTY) : -1;
+    if (slave < 0)
+    {
+        perror("[sil] pty slave");
+        close(master);
+        return NULL;
+    }
+    struct termios settings;
+    tcgetattr(slave, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(slave, TCSANOW, &settings);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    g_sim_pty_master = master;
+    g_sim_pty_slave = slave;
+    return name;
+}
+
+void Sim_PTY_Close(void)
+{
+    if (g_sim_pty_master >= 0)
+    {
+        close(g_sim_pty_slave);
+        close(g_sim_pty_master);
+        g_sim_pty_master = -1;
+        g_sim_pty_slave = -1;
+    }
+}
+
+uint8_t Sim_PTY_Is_Open(void)
+{
+    return g_sim_pty_master >= 0;
+}
+
+/**
+ * @brief huart6 transmit, dropped while the stand-in does not read (the pty buffer is full)
+ */
+void Sim_PTY_Write(const uint8_t *data, uint16_t length)
+{
+    if (g_sim_pty_master >= 0 && write(g_sim_pty_master, data, length) < 0 && errno != EAGAIN)
+    {
+        perror("[sil] pty write");
+    }
+}
+
+void Sim_PTY_Poll(void)
+{
+    uint8_t buffer[256];
+    ssize_t length;
+    while (g_sim_pty_master >= 0 && (length = read(g_sim_pty_master, buffer, sizeof(buffer))) > 0)
+    {
+        Sim_UART_Receive(&huart6, buffer, (uint16_t)length);
+    }
+}
+#else
+const char *Sim_PTY_Open(void)
+{
+    fprintf(stderr, "[sil] pseudo-terminals are only supported on Linux\n");
+    return NULL;
+}
+
+void Sim_PTY_Close(void)
+{
+}
+
+uint8_t Sim_PTY_Is_Open(void)
+{
+    return 0;
+}
+
+void Sim_PTY_Write(const uint8_t *data, uint16_t length)
+{
+    (void)data;
+    (void)length;
+}
+
+void Sim_PTY_Poll(void)
+{
+}
+#endif
@@ -0,0 +1,169 @@
+/**
+ * @file sim_rtos.c
+ * @brief FreeRTOS / CMSIS-RTOS stand-ins backed by the simulator's virtual clock.
+ */
+#include <stdio.h>
+
+#include "cmsis_os.h"
+#include "sim.h"
+
+typedef struct
+{
+    const osThreadDef_t *def;
+    uint32_t notification_count;
+} Sim_Thread_t;
+
+static Sim_Thread_t g_sim_threads[SIM_MAX_TASKS];
+static uint8_t g_sim_thread_count = 0;
+
+struct os_timer_cb
+{
+    os_ptimer callback;
+    void *argument;
+    os_timer_type type;
+    uint32_t period_ms;
+    uint32_t expiry_tick;
+    uint8_t active;
+};
+
+static struct os_timer_cb g_sim_timers[SIM_MAX_TIMERS];
+static uint8_t g_sim_timer_count = 0;
+
+TickType_t xTaskGetTickCount(void)
+{
+    return Sim_Get_Tick();
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return Sim_Get_Tick();
+}
+
+void vTaskDelayUntil(TickType_t *const pxPreviousWakeTime, const TickType_t xTimeIncrement)
+{
+    // Task loops are stepped by the harness, so a delay only has to keep the wake time consistent
+    *pxPreviousWakeTime += xTimeIncrement;
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    (void)xTicksToDelay;
+}
+
+osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument)
+{
+    (void)argument;
+    if (g_sim_thread_count >= SIM_MAX_TASKS)
+    {
+        fprintf(stderr, "[sil] too many threads, dropping %s\n", thread_def->name);
+        return NULL;
+    }
+    g_sim_threads[g_sim_thread_count].def = thread_def;
+    return (osThreadId)&g_sim_threads[g_sim_thread_count++];
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    xTaskNotifyGive(xTaskToNotify);
+    if (pxHigherPriorityTaskWoken != NULL)
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    if (xTaskToNotify != NULL)
+    {
+        ((Sim_Thread_t *)xTaskToNotify)->notification_count++;
+    }
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    // only reachable from the firmware thread bodies, which the harness never runs
+    (void)xClearCountOnExit;
+    (void)xTicksToWait;
+    return 0;
+}
+
+uint32_t Sim_Take_Notification(void *task_handle)
+{
+    if (task_handle == NULL)
+    {
+        return 0;
+    }
+    Sim_Thread_t *thread = (Sim_Thread_t *)task_handle;
+    uint32_t count = thread->notification_count;
+    thread->notification_count = 0;
+    return count;
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+    return 0;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+    return 0;
+}
+
+osTimerId osTimerCreate(const osTimerDef_t *timer_def, os_timer_type type, void *argument)
+{
+    if (g_sim_timer_count >= SIM_MAX_TIMERS)
+    {
+        fprintf(stderr, "[sil] too many software timers\n");
+        return NULL;
+    }
+    struct os_timer_cb *timer = &g_sim_timers[g_sim_timer_count++];
+    timer->callback = timer_def->ptimer;
+    timer->argument = argument;
+    timer->type = type;
+    timer->active = 0;
+    return timer;
+}
+
+osStatus osTimerStart(osTimerId timer_id, uint32_t millisec)
+{
+    if (timer_id == NULL || millisec == 0)
+    {
+        return osErrorParameter;
+    }
+    timer_id->period_ms = millisec;
+    timer_id->expiry_tick = Sim_Get_Tick() + millisec;
+    timer_id->active = 1;
+    return osOK;
+}
+
+osStatus osTimerStop(osTimerId timer_id)
+{
+    if (timer_id == NULL || !timer_id->active)
+    {
+        return osErrorResource;
+    }
+    timer_id->active = 0;
+    return osOK;
+}
+
+void Sim_Timers_Update(uint32_t tick)
+{
+    for (uint8_t i = 0; i < g_sim_timer_count; i++)
+    {
+        struct os_timer_cb *timer = &g_sim_timers[i];
+        if (!timer->active || (int32_t)(tick - timer->expiry_tick) < 0)
+        {
+            continue;
+        }
+        if (timer->type == osTimerPeriodic)
+        {
+            timer->expiry_tick += timer->period_ms;
+        }
+        else
+        {
+            timer->active = 0;
+        }
+        timer->callback(timer->argument);
+    }
+}
@@ -0,0 +1,576 @@
+/**
+ * @file sim_scenarios.c
+ * @brief Scripted operator inputs for the SIL build.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "remote.h"
+#include "robot.h"
+#include "chassis_task.h"
+#include "jetson_orin.h"
+#include "orin_link.h"
+#include "fast_math.h"
+#include "boost_scheduler.h"
+#include "launch_task.h"
+
+extern Remote_t g_remote;
+extern Jetson_Orin_Data_t g_orin_data;
+
+#define SIM_SETTLE_TICKS (1000) // ms after start up before tracking metrics are sampled
+
+static void Sim_Remote_Enable(void)
+{
+    g_remote.online_flag = REMOTE_ONLINE;
+    g_remote.controller.right_switch = MID;
+    g_remote.controller.left_switch = DOWN;
+}
+
+static void Idle_Update(uint32_t tick)
+{
+    (void)tick;
+}
+
+static void Drive_Update(uint32_t tick)
+{
+    // left stick traces a circle every 4 s
+    float phase = 2.0f * 3.14159265f * (tick % 4000) / 4000.0f;
+    g_remote.controller.left_stick.x = (int16_t)(REMOTE_STICK_MAX * cosf(phase));
+    g_remote.controller.left_stick.y = (int16_t)(REMOTE_STICK_MAX * sinf(phase));
+}
+
+#define SIM_UNPLUG_START (5000) // ms
+#define SIM_UNPLUG_END (10000)  // ms
+
+// the drive sweep with one drive motor unplugged for a while, feedback sets must keep completing
+static void Unplug_Update(uint32_t tick)
+{
+    Drive_Update(tick);
+    if (tick == SIM_UNPLUG_START || tick == SIM_UNPLUG_END)
+    {
+        Sim_Plant_Set_Motor_Online(2, 0x204, tick == SIM_UNPLUG_END); // module 3 drive
+    }
+}
+
+/**
+ * @brief Angle error in [-pi, pi], Wrap_Angle only folds to (-2pi, 2pi).
+ */
+static float Sim_Angle_Error(float angle)
+{
+    return atan2f(sinf(angle), cosf(angle));
+}
+
+/**
+ * @brief Speed of the chassis along an axis of the gimbal frame, the frame the sticks command.
+ */
+static float Sim_Gimbal_Frame_Speed(const Sim_Plant_State_t *state, float axis_angle)
+{
+    float angle = state->gimbal_yaw + axis_angle;
+    return state->v_x * cosf(angle) + state->v_y * sinf(angle);
+}
+
+#define SIM_STEP_YAW_TICK (2000)
+#define SIM_STEP_PITCH_TICK (4000)
+#define SIM_STEP_DRIVE_TICK (6000)
+#define SIM_STEP_DRIVE_END_TICK (8000)
+#define SIM_STEP_WINDOW (1500) // ms recorded per step
+#define SIM_STEP_YAW (0.5f)    // rad
+#define SIM_STEP_PITCH (0.2f)  // rad
+
+static Sim_Step_Response_t g_step_yaw = {.name = "gimbal_yaw", .unit = "rad", .window_ms = SIM_STEP_WINDOW};
+static Sim_Step_Response_t g_step_pitch = {.name = "gimbal_pitch", .unit = "rad", .window_ms = SIM_STEP_WINDOW};
+static Sim_Step_Response_t g_step_drive = {.name = "chassis_forward", .unit = "m/s", .window_ms = SIM_STEP_WINDOW};
+
+static void Step_Update(uint32_t tick)
+{
+    const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+    float forward_speed = Sim_Gimbal_Frame_Speed(state, HALF_PI_F);
+    if (tick == SIM_STEP_YAW_TICK)
+    {
+        g_robot_state.gimbal.yaw_angle += SIM_STEP_YAW;
+        Sim_Step_Response_Begin(&g_step_yaw, tick, state->gimbal_yaw, g_robot_state.gimbal.yaw_angle);
+    }
+    else if (tick == SIM_STEP_PITCH_TICK)
+    {
+        g_robot_state.gimbal.pitch_angle += SIM_STEP_PITCH;
+        Sim_Step_Response_Begin(&g_step_pitch, tick, state->gimbal_pitch, g_robot_state.gimbal.pitch_angle);
+    }
+    else if (tick == SIM_STEP_DRIVE_TICK)
+    {
+        g_remote.controller.left_stick.y = (int16_t)REMOTE_STICK_MAX;
+        Sim_Step_Response_Begin(&g_step_drive, tick, forward_speed, SWERVE_MAX_SPEED);
+    }
+    else if (tick == SIM_STEP_DRIVE_END_TICK)
+    {
+        g_remote.controller.left_stick.y = 0;
+    }
+    Sim_Step_Response_Sample(&g_step_yaw, tick, state->gimbal_yaw);
+    Sim_Step_Response_Sample(&g_step_pitch, tick, state->gimbal_pitch);
+    Sim_Step_Response_Sample(&g_step_drive, tick, forward_speed);
+}
+
+static void Step_Report(void)
+{
+    Sim_Step_Response_Report(&g_step_yaw);
+    Sim_Step_Response_Report(&g_step_pitch);
+    Sim_Step_Response_Report(&g_step_drive);
+}
+
+static Sim_Tracking_t g_spintop_yaw_hold = {.name = "gimbal_yaw_hold", .unit = "rad"};
+static Sim_Tracking_t g_spintop_omega = {.name = "spintop_omega", .unit = "rad/s"};
+static Sim_Tracking_t g_spintop_translation = {.name = "spintop_forward", .unit = "m/s"};
+
+static void Spintop_Update(uint32_t tick)
+{
+    g_remote.controller.left_switch = MID;
+    g_remote.controller.left_stick.y = (tick / 2000) % 2 ? (int16_t)(REMOTE_STICK_MAX / 2) : 0;
+
+    if (tick < SIM_SETTLE_TICKS)
+    {
+        return;
+    }
+    // the gimbal holds its world yaw while the chassis spins underneath
+    const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+    Sim_Tracking_Sample(&g_spintop_yaw_hold, Sim_Angle_Error(g_robot_state.gimbal.yaw_angle - state->gimbal_yaw));
+    if (g_robot_state.chassis.IS_SPINTOP_ENABLED)
+    {
+        Sim_Tracking_Sample(&g_spintop_omega, SPIN_TOP_OMEGA - state->omega);
+    }
+    // translation is commanded in the gimbal frame, forward is its y axis
+    float forward = g_remote.controller.left_stick.y / REMOTE_STICK_MAX * SWERVE_MAX_SPEED;
+    Sim_Tracking_Sample(&g_spintop_translation, forward - Sim_Gimbal_Frame_Speed(state, HALF_PI_F));
+}
+
+static void Spintop_Report(void)
+{
+    Sim_Tracking_Report(&g_spintop_yaw_hold);
+    Sim_Tracking_Report(&g_spintop_omega);
+    Sim_Tracking_Report(&g_spintop_translation);
+}
+
+#define SIM_LEG_PERIOD (1000) // ms per stick position
+
+typedef struct
+{
+    float stick_x; // full stick in the gimbal frame
+    float stick_y;
+} Sim_Leg_t;
+
+/**
+ * @brief Hold each stick position of legs for SIM_LEG_PERIOD after settling, in a loop, and
+ * sample how far the chassis velocity is from the command.
+ */
+static void Sim_Legs_Update(uint32_t tick, const Sim_Leg_t *legs, uint32_t leg_count, Sim_Tracking_t *tracking)
+{
+    float stick_x = 0.0f, stick_y = 0.0f;
+    if (tick >= SIM_SETTLE_TICKS)
+    {
+        const Sim_Leg_t *leg = &legs[(tick - SIM_SETTLE_TICKS) / SIM_LEG_PERIOD % leg_count];
+        stick_x = leg->stick_x;
+        stick_y = leg->stick_y;
+    }
+    g_remote.controller.left_stick.x = (int16_t)(REMOTE_STICK_MAX * stick_x);
+    g_remote.controller.left_stick.y = (int16_t)(REMOTE_STICK_MAX * stick_y);
+
+    if (tick >= SIM_SETTLE_TICKS)
+    {
+        const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+        float error_x = stick_x * SWERVE_MAX_SPEED - Sim_Gimbal_Frame_Speed(state, 0.0f);
+        float error_y = stick_y * SWERVE_MAX_SPEED - Sim_Gimbal_Frame_Speed(state, HALF_PI_F);
+        Sim_Tracking_Sample(tracking, sqrtf(error_x * error_x + error_y * error_y));
+    }
+}
+
+// forward, right, back, forward, left, right, i.e. quarter turns and reversals
+static const Sim_Leg_t g_sim_turns[] = {{0.0f, 1.0f}, {1.0f, 0.0f}, {0.0f, -1.0f},
+                                        {0.0f, 1.0f}, {-1.0f, 0.0f}, {1.0f, 0.0f}};
+static Sim_Tracking_t g_turns_velocity = {.name = "turns_velocity", .unit = "m/s"};
+
+static void Turns_Update(uint32_t tick)
+{
+    Sim_Legs_Update(tick, g_sim_turns, sizeof(g_sim_turns) / sizeof(g_sim_turns[0]), &g_turns_velocity);
+}
+
+static void Turns_Report(void)
+{
+    Sim_Tracking_Report(&g_turns_velocity);
+}
+
+// stop and go, every direction twice with the stick released in between
+static const Sim_Leg_t g_sim_stops[] = {{0.7f, 0.7f}, {0.0f, 0.0f}, {0.7f, 0.7f}, {0.0f, 0.0f},
+                                        {-1.0f, 0.0f}, {0.0f, 0.0f}, {-1.0f, 0.0f}, {0.0f, 0.0f}};
+static Sim_Tracking_t g_stops_velocity = {.name = "stops_velocity", .unit = "m/s"};
+
+static void Stops_Update(uint32_t tick)
+{
+    Sim_Legs_Update(tick, g_sim_stops, sizeof(g_sim_stops) / sizeof(g_sim_stops[0]), &g_stops_velocity);
+}
+
+static void Stops_Report(void)
+{
+    Sim_Tracking_Report(&g_stops_velocity);
+}
+
+#define SIM_SLIP_FRICTION (0.2f) // left side tires (modules 0 and 1) on the slippery floor
+
+static Sim_Tracking_t g_slip_velocity = {.name = "slip_velocity", .unit = "m/s"};
+
+static void Slip_Init(void)
+{
+    Sim_Remote_Enable();
+    Sim_Plant_Set_Wheel_Friction(0, SIM_SLIP_FRICTION);
+    Sim_Plant_Set_Wheel_Friction(1, SIM_SLIP_FRICTION);
+}
+
+// the turns legs with the left wheels on a slippery floor, they slip and yaw the chassis on every change
+static void Slip_Update(uint32_t tick)
+{
+    Sim_Legs_Update(tick, g_sim_turns, sizeof(g_sim_turns) / sizeof(g_sim_turns[0]), &g_slip_velocity);
+}
+
+static void Slip_Report(void)
+{
+    Sim_Tracking_Report(&g_slip_velocity);
+}
+
+#define SIM_POWER_LIMIT (15.0f) // W, low enough for the plant's draw to run the buffer down
+
+static Sim_Tracking_t g_power_velocity = {.name = "power_velocity", .unit = "m/s"};
+
+static void Power_Init(void)
+{
+    Sim_Remote_Enable();
+    g_sim_referee.power_limit = SIM_POWER_LIMIT;
+}
+
+// the turns legs on a limit they exceed, the buffer must not run empty
+static void Power_Update(uint32_t tick)
+{
+    Sim_Legs_Update(tick, g_sim_turns, sizeof(g_sim_turns) / sizeof(g_sim_turns[0]), &g_power_velocity);
+}
+
+static void Power_Report(void)
+{
+    Sim_Tracking_Report(&g_power_velocity);
+}
+
+#define SIM_BOOST_START_PERCENT (30.0f) // of the cap, drains within the match
+#define SIM_BOOST_MATCH_END (20000)      // ms, the robot is disabled from then on
+
+static float g_boost_distance = 0.0f; // m the chassis covered
+static uint32_t g_boost_samples = 0;
+
+static void Boost_Init(void)
+{
+    Sim_Remote_Enable();
+    g_sim_referee.power_limit = SIM_POWER_LIMIT;
+    g_sim_supercap.energy = g_sim_supercap.energy_max * (SIM_BOOST_START_PERCENT / 100.0f);
+}
+
+// the turns legs with the dial wheel held back for the supercap, the robot is disabled at the
+// end of the match so the debug task logs it
+static void Boost_Update(uint32_t tick)
+{
+    Sim_Legs_Update(tick, g_sim_turns, sizeof(g_sim_turns) / sizeof(g_sim_turns[0]), &g_power_velocity);
+    g_remote.controller.wheel = REMOTE_STICK_MAX;
+    g_remote.controller.right_switch = tick < SIM_BOOST_MATCH_END ? MID : DOWN;
+    if (tick >= SIM_SETTLE_TICKS && tick < SIM_BOOST_MATCH_END)
+    {
+        const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+        g_boost_distance += sqrtf(state->v_x * state->v_x + state->v_y * state->v_y) * SIM_DT;
+        g_boost_samples++;
+    }
+}
+
+static void Boost_Report(void)
+{
+    const Boost_Match_t *match = &g_boost_scheduler.match;
+    printf("[sil]   boost          %8.3f m/s mean speed  boosted %lu ms  tapering %lu ms  cap empty %lu ms\n",
+           g_boost_samples ? g_boost_distance / (g_boost_samples * SIM_DT) : 0.0, (unsigned long)match->boost_ms,
+           (unsigned long)match->taper_ms, (unsigned long)match->empty_ms);
+    printf("[sil]   boost energy   %8.1f J translating  %.1f J spinning  %.1f J recharged  min %.0f %%\n",
+           (double)match->spent_translation, (double)match->spent_spintop, (double)match->recharged,
+           (double)match->min_percent);
+}
+
+#define SIM_STRAFE_TARGET_DISTANCE (5.0f) // m, straight ahead of the start position
+#define SIM_STRAFE_TARGET_HEIGHT (0.25f)  // m above the pitch axis
+#define SIM_STRAFE_PERIOD (3000)          // ms per side to side sweep
+#define SIM_STRAFE_STICK (0.8f)           // of full stick
+#define SIM_CAMERA_PERIOD (10)            // ms between detections
+#define SIM_CAMERA_LATENCY (30)           // ms from exposure to the offset on the link, AIM_CAPTURE_LATENCY
+#define SIM_CAMERA_IN_FLIGHT (8)          // detections on their way, more than LATENCY / PERIOD
+
+typedef struct
+{
+    uint32_t arrival_tick;
+    float yaw; // deg, relative to the gimbal at exposure
+    float pitch;
+} Sim_Detection_t;
+
+static Sim_Detection_t g_sim_detections[SIM_CAMERA_IN_FLIGHT];
+static uint32_t g_sim_detections_sent = 0;
+static uint32_t g_sim_detections_arrived = 0;
+
+/**
+ * @brief Angles from the gimbal to a target target_x to the side of the strafe target, the
+ * errors the aim is scored on.
+ */
+static void Sim_Target_Errors(const Sim_Plant_State_t *state, float target_x, float *yaw_error, float *pitch_error)
+{
+    float to_target_x = target_x - state->x;
+    float to_target_y = SIM_STRAFE_TARGET_DISTANCE - state->y;
+    float distance = sqrtf(to_target_x * to_target_x + to_target_y * to_target_y);
+    *yaw_error = Sim_Angle_Error(atan2f(to_target_y, to_target_x) - HALF_PI_F - state->gimbal_yaw);
+    *pitch_error = atan2f(SIM_STRAFE_TARGET_HEIGHT, distance) - state->gimbal_pitch;
+}
+
+/**
+ * @brief Vision pipeline: a detection of the target relative to the gimbal every
+ * SIM_CAMERA_PERIOD, reaching the MCU SIM_CAMERA_LATENCY after the exposure. With the Orin link
+ * it is an aim frame on huart6, none while a stand-in on the pseudo-terminal is the Orin.
+ */
+static void Sim_Camera_Update(uint32_t tick, float yaw_error, float pitch_error)
+{
+    if (tick % SIM_CAMERA_PERIOD == 0)
+    {
+        Sim_Detection_t *detection = &g_sim_detections[g_sim_detections_sent++ % SIM_CAMERA_IN_FLIGHT];
+        detection->arrival_tick = tick + SIM_CAMERA_LATENCY;
+        detection->yaw = yaw_error / DEG_TO_RAD_F;
+        detection->pitch = pitch_error / DEG_TO_RAD_F;
+    }
+    while (g_sim_detections_arrived < g_sim_detections_sent &&
+           g_sim_detections[g_sim_detections_arrived % SIM_CAMERA_IN_FLIGHT].arrival_tick <= tick)
+    {
+        const Sim_Detection_t *detection = &g_sim_detections[g_sim_detections_arrived++ % SIM_CAMERA_IN_FLIGHT];
+#ifdef ORIN_LINK_ENABLED
+        if (!Sim_PTY_Is_Open())
+        {
+            Sim_Orin_Send_Aim(detection->yaw, detection->pitch, 1, SIM_CAMERA_LATENCY);
+        }
+#else
+        g_orin_data.receiving.auto_aiming.yaw = detection->yaw;
+        g_orin_data.receiving.auto_aiming.pitch = detection->pitch;
+#endif
+    }
+}
+
+static Sim_Tracking_t g_strafe_aim_yaw = {.name = "aim_yaw", .unit = "rad"};
+static Sim_Tracking_t g_strafe_aim_pitch = {.name = "aim_pitch", .unit = "rad"};
+static Sim_Tracking_t g_strafe_speed = {.name = "strafe_speed", .unit = "m/s"};
+
+static void Strafe_Init(void)
+{
+    Sim_Remote_Enable();
+    g_remote.controller.right_switch = UP; // auto aim
+}
+
+static void Strafe_Update(uint32_t tick)
+{
+    const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+    float yaw_error, pitch_error;
+    Sim_Target_Errors(state, 0.0f, &yaw_error, &pitch_error);
+    Sim_Camera_Update(tick, yaw_error, pitch_error);
+
+    float stick = 0.0f;
+    if (tick >= SIM_SETTLE_TICKS)
+    {
+        stick = SIM_STRAFE_STICK * sinf(2.0f * PI_F * (tick - SIM_SETTLE_TICKS) / SIM_STRAFE_PERIOD);
+    }
+    g_remote.controller.left_stick.x = (int16_t)(REMOTE_STICK_MAX * stick);
+
+    if (tick >= 2 * SIM_SETTLE_TICKS)
+    {
+        Sim_Tracking_Sample(&g_strafe_aim_yaw, yaw_error);
+        Sim_Tracking_Sample(&g_strafe_aim_pitch, pitch_error);
+        Sim_Tracking_Sample(&g_strafe_speed, stick * SWERVE_MAX_SPEED - Sim_Gimbal_Frame_Speed(state, 0.0f));
+    }
+}
+
+static void Strafe_Report(void)
+{
+    Sim_Tracking_Report(&g_strafe_aim_yaw);
+    Sim_Tracking_Report(&g_strafe_aim_pitch);
+    Sim_Tracking_Report(&g_strafe_speed);
+}
+
+#define SIM_SPINAIM_TARGET_X (1.5f) // m, the target alternates to either side of the strafe target
+#define SIM_SPINAIM_PERIOD (1000)    // ms on each
+
+static Sim_Tracking_t g_spinaim_yaw = {.name = "spinaim_yaw", .unit = "rad"};
+static Sim_Tracking_t g_spinaim_pitch = {.name = "spinaim_pitch", .unit = "rad"};
+static float g_spinaim_overshoot = 0.0f; // rad past the target after a switch, worst
+
+static void Spinaim_Init(void)
+{
+    Sim_Remote_Enable();
+    g_remote.controller.right_switch = UP; // auto aim
+}
+
+// auto aim during spintop, the target switching sides so the gimbal slews onto it while spinning
+static void Spinaim_Update(uint32_t tick)
+{
+    g_remote.controller.left_switch = tick >= SIM_SETTLE_TICKS ? MID : DOWN;
+    const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+    uint32_t target = tick / SIM_SPINAIM_PERIOD;
+    float side = (target % 2) ? 1.0f : -1.0f;
+    float yaw_error, pitch_error;
+    Sim_Target_Errors(state, side * SIM_SPINAIM_TARGET_X, &yaw_error, &pitch_error);
+    Sim_Camera_Update(tick, yaw_error, pitch_error);
+    if (tick >= 2 * SIM_SETTLE_TICKS)
+    {
+        Sim_Tracking_Sample(&g_spinaim_yaw, yaw_error);
+        Sim_Tracking_Sample(&g_spinaim_pitch, pitch_error);
+        // a target at +x is to the right (negative yaw), the gimbal is past it once the error turns positive
+        float overshoot = side * yaw_error;
+        if (overshoot > g_spinaim_overshoot)
+        {
+            g_spinaim_overshoot = overshoot;
+        }
+    }
+}
+
+static void Spinaim_Report(void)
+{
+    Sim_Tracking_Report(&g_spinaim_yaw);
+    Sim_Tracking_Report(&g_spinaim_pitch);
+    printf("[sil]   spinaim overshoot %.4f rad\n", (double)g_spinaim_overshoot);
+}
+
+static void Fire_Update(uint32_t tick)
+{
+    g_remote.controller.left_switch = UP;
+    // pulse the dial for single fire every 500 ms
+    g_remote.controller.wheel = (tick % 500) < 20 ? -660 : 0;
+}
+
+static void Fire_Report(void)
+{
+    printf("[sil]   feed %lu shots, %.1f ms average cycle, %lu jams\n", (unsigned long)g_feed_stats.shots,
+           (double)g_feed_stats.average_cycle_ms, (unsigned long)g_feed_stats.jams);
+}
+
+#define SIM_JAM_FULL_AUTO (10000) // ms, single fire held before, full auto held after
+#define SIM_JAM_PERIOD (1000)     // ms between jams
+#define SIM_JAM_DISTANCE (0.3f)   // rad ahead of the feeder, within the next pocket
+
+typedef struct
+{
+    const char *name;
+    uint32_t start_tick;
+    uint32_t end_tick;
+    float start_angle; // rad, plant feeder
+    float end_angle;
+    uint32_t shots; // g_feed_stats at the end less at the start
+} Sim_Jam_Phase_t;
+
+static Sim_Jam_Phase_t g_jam_phases[] = {
+    {.name = "single fire", .start_tick = SIM_SETTLE_TICKS},
+    {.name = "full auto", .start_tick = SIM_JAM_FULL_AUTO},
+};
+static uint32_t g_jam_phase_shots = 0;
+static uint32_t g_jammed_ms = 0; // with the plant's feeder wedged
+
+// trigger held, single fire then full auto, a projectile wedged ahead of the feeder every second
+static void Jam_Update(uint32_t tick)
+{
+    const Sim_Plant_State_t *state = Sim_Plant_Get_State();
+    g_remote.controller.left_switch = UP;
+    g_remote.controller.wheel = tick < SIM_SETTLE_TICKS ? 0 : (tick < SIM_JAM_FULL_AUTO ? -660 : 660);
+    for (size_t i = 0; i < sizeof(g_jam_phases) / sizeof(g_jam_phases[0]); i++)
+    {
+        Sim_Jam_Phase_t *phase = &g_jam_phases[i];
+        if (tick == phase->start_tick)
+        {
+            phase->start_angle = state->feeder_angle;
+            g_jam_phase_shots = g_feed_stats.shots;
+        }
+        if (tick > phase->start_tick && (i + 1 == sizeof(g_jam_phases) / sizeof(g_jam_phases[0]) ||
+                                         tick <= g_jam_phases[i + 1].start_tick))
+        {
+            phase->end_tick = tick;
+            phase->end_angle = state->feeder_angle;
+            phase->shots = g_feed_stats.shots - g_jam_phase_shots;
+        }
+    }
+    if (tick >= SIM_SETTLE_TICKS && tick % SIM_JAM_PERIOD == SIM_JAM_PERIOD / 2 && !state->feeder_jammed)
+    {
+        Sim_Plant_Jam_Feeder(SIM_JAM_DISTANCE);
+    }
+    g_jammed_ms += state->feeder_jammed;
+}
+
+static void Jam_Report(void)
+{
+    const Sim_Plant_Stats_t *stats = Sim_Plant_Get_Stats();
+    for (size_t i = 0; i < sizeof(g_jam_phases) / sizeof(g_jam_phases[0]); i++)
+    {
+        const Sim_Jam_Phase_t *phase = &g_jam_phases[i];
+        float seconds = (phase->end_tick - phase->start_tick) / 1000.0f;
+        if (seconds <= 0.0f)
+        {
+            continue;
+        }
+        float pockets = (phase->end_angle - phase->start_angle) / SHOT_ANGLE_OFFSET_RAD;
+        printf("[sil]   jam %-11s %5.1f pockets fed %5.2f/s, %lu shots counted %5.2f/s\n", phase->name,
+               (double)pockets, (double)(pockets / seconds), (unsigned long)phase->shots,
+               (double)(phase->shots / seconds));
+    }
+    printf("[sil]   jam %lu wedged, %lu freed, %lu ms jammed | feed %lu jams, %lu retries, %lu abandoned, "
+           "%.1f ms average cycle\n",
+           (unsigned long)stats->feeder_jams, (unsigned long)stats->feeder_jams_cleared, (unsigned long)g_jammed_ms,
+           (unsigned long)g_feed_stats.jams, (unsigned long)g_feed_stats.retries,
+           (unsigned long)g_feed_stats.abandoned, (double)g_feed_stats.average_cycle_ms);
+}
+
+static const Sim_Scenario_t g_sim_scenarios[] = {
+    {"idle", "remote offline, robot stays disabled", NULL, Idle_Update},
+    {"drive", "enabled, translation stick sweeps a full circle", Sim_Remote_Enable, Drive_Update},
+    {"unplug", "enabled, the drive sweep with a drive motor unplugged from 5 s to 10 s, feedback sets",
+     Sim_Remote_Enable, Unplug_Update},
+    {"spintop", "enabled, spintop with intermittent forward translation, gimbal yaw hold error",
+     Sim_Remote_Enable, Spintop_Update, Spintop_Report},
+    {"fire", "enabled, flywheels on and single fire twice a second", Sim_Remote_Enable, Fire_Update, Fire_Report},
+    {"jam", "enabled, single fire then full auto held with the feeder jammed every second, jams cleared",
+     Sim_Remote_Enable, Jam_Update, Jam_Report},
+    {"step", "enabled, gimbal yaw, gimbal pitch and chassis speed steps 2 s apart", Sim_Remote_Enable,
+     Step_Update, Step_Report},
+    {"turns", "enabled, full stick changing direction every second, quarter turns and reversals",
+     Sim_Remote_Enable, Turns_Update, Turns_Report},
+    {"stops", "enabled, stop and go, every direction twice with a second of released stick in between",
+     Sim_Remote_Enable, Stops_Update, Stops_Report},
+    {"slip", "enabled, the turns legs with the left wheels on a slippery floor, odometry slip detection",
+     Slip_Init, Slip_Update, Slip_Report},
+    {"power", "enabled, the turns legs on a 15 W referee limit, buffer energy and velocity tracking",
+     Power_Init, Power_Update, Power_Report},
+    {"boost", "enabled, the turns legs on 15 W holding the supercap from 30 %, mean speed and energy spent",
+     Boost_Init, Boost_Update, Boost_Report},
+    {"strafe", "enabled, auto aim at a fixed target while strafing side to side", Strafe_Init, Strafe_Update,
+     Strafe_Report},
+    {"spinaim", "enabled, auto aim during spintop at a target switching sides every second", Spinaim_Init, Spinaim_Update,
+     Spinaim_Report},
+};
+
+#define SIM_SCENARIO_COUNT (sizeof(g_sim_scenarios) / sizeof(g_sim_scenarios[0]))
+
+const Sim_Scenario_t *Sim_Find_Scenario(const char *name)
+{
+    for (size_t i = 0; i < SIM_SCENARIO_COUNT; i++)
+    {
+        if (strcmp(g_sim_scenarios[i].name, name) == 0)
+        {
+            return &g_sim_scenarios[i];
+        }
+    }
+    return NULL;
+}
+
+void Sim_List_Scenarios(void)
+{
+    for (size_t i = 0; i < SIM_SCENARIO_COUNT; i++)
+    {
+        printf("  %-10s %s\n", g_sim_scenarios[i].name, g_sim_scenarios[i].description);
+    }
+}
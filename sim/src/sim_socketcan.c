@@ -0,0 +1,194 @@
+/**
+ * @file sim_socketcan.c
+ * @brief Linux SocketCAN transport shared by the SIL firmware and the plant process.
+ *
+ * Bus n (1-based) is the interface <prefix><n-1>, e.g. vcan0 and vcan1. Set them up with
+ *   sudo modprobe vcan
+ *   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0   (same for vcan1)
+ * Sockets are non-blocking and do not receive their own frames, so the firmware only sees
+ * the plant's feedback and the plant only sees the firmware's commands.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+
+/**
+ * @brief One candump -l line, "(seconds.micros) interface ID#DATA", replayable with canplayer.
+ */
+void Sim_CAN_Log_Frame(FILE *log, double time_s, const char *interface, uint16_t can_id, const uint8_t data[8])
+{
+    uint64_t micros = (uint64_t)(time_s * 1e6 + 0.5);
+    fprintf(log, "(%010llu.%06llu) %s %03X#%02X%02X%02X%02X%02X%02X%02X%02X\n",
+            (unsigned long long)(micros / 1000000), (unsigned long long)(micros % 1000000), interface, can_id,
+            data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7]);
+}
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+static int g_sim_socketcan_fd[SIM_MAX_CAN_BUS] = {-1, -1};
+static char g_sim_socketcan_names[SIM_MAX_CAN_BUS][IFNAMSIZ];
+
+static int Sim_SocketCAN_Open_Bus(int bus_index, const char *name)
+{
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0)
+    {
+        perror("[sil] socket(PF_CAN)");
+        return -1;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", name);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+    {
+        fprintf(stderr, "[sil] %s: %s\n", name, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        fprintf(stderr, "[sil] bind %s: %s\n", name, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    g_sim_socketcan_fd[bus_index] = fd;
+    snprintf(g_sim_socketcan_names[bus_index], IFNAMSIZ, "%s", name);
+    return 0;
+}
+
+int Sim_SocketCAN_Open(const char *prefix)
+{
+    for (int bus_index = 0; bus_index < SIM_MAX_CAN_BUS; bus_index++)
+    {
+        char name[IFNAMSIZ];
+        snprintf(name, sizeof(name), "%s%d", prefix, bus_index);
+        if (Sim_SocketCAN_Open_Bus(bus_index, name) != 0)
+        {
+            Sim_SocketCAN_Close();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void Sim_SocketCAN_Close(void)
+{
+    for (int bus_index = 0; bus_index < SIM_MAX_CAN_BUS; bus_index++)
+    {
+        if (g_sim_socketcan_fd[bus_index] >= 0)
+        {
+            close(g_sim_socketcan_fd[bus_index]);
+            g_sim_socketcan_fd[bus_index] = -1;
+        }
+    }
+}
+
+uint8_t Sim_SocketCAN_Is_Open(void)
+{
+    return g_sim_socketcan_fd[0] >= 0;
+}
+
+const char *Sim_SocketCAN_Interface(uint8_t can_bus)
+{
+    return g_sim_socketcan_names[can_bus - 1];
+}
+
+/**
+ * @return 0 if the frame was queued, -1 if the interface queue is full (ENOBUFS) or closed
+ */
+int Sim_SocketCAN_Send(uint8_t can_bus, uint16_t can_id, const uint8_t data[8])
+{
+    int fd = g_sim_socketcan_fd[can_bus - 1];
+    if (fd < 0)
+    {
+        return -1;
+    }
+    struct can_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = can_id;
+    frame.can_dlc = 8;
+    memcpy(frame.data, data, 8);
+    return write(fd, &frame, sizeof(frame)) == sizeof(frame) ? 0 : -1;
+}
+
+/**
+ * @brief Hand every frame waiting on either bus to on_frame, never blocks.
+ * @return number of frames received
+ */
+int Sim_SocketCAN_Poll(Sim_CAN_Frame_Callback_t on_frame)
+{
+    int received = 0;
+    for (int bus_index = 0; bus_index < SIM_MAX_CAN_BUS; bus_index++)
+    {
+        struct can_frame frame;
+        while (g_sim_socketcan_fd[bus_index] >= 0 &&
+               read(g_sim_socketcan_fd[bus_index], &frame, sizeof(frame)) == sizeof(frame))
+        {
+            if (frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG))
+            {
+                continue; // only standard data frames are used
+            }
+            uint8_t data[8] = {0};
+            memcpy(data, frame.data, frame.can_dlc > 8 ? 8 : frame.can_dlc);
+            on_frame(bus_index + 1, (uint16_t)frame.can_id, data);
+            received++;
+        }
+    }
+    return received;
+}
+
+#else
+
+int Sim_SocketCAN_Open(const char *prefix)
+{
+    fprintf(stderr, "[sil] SocketCAN needs Linux, %s* not opened\n", prefix);
+    return -1;
+}
+
+void Sim_SocketCAN_Close(void)
+{
+}
+
+uint8_t Sim_SocketCAN_Is_Open(void)
+{
+    return 0;
+}
+
+const char *Sim_SocketCAN_Interface(uint8_t can_bus)
+{
+    (void)can_bus;
+    return "";
+}
+
+int Sim_SocketCAN_Send(uint8_t can_bus, uint16_t can_id, const uint8_t data[8])
+{
+    (void)can_bus;
+    (void)can_id;
+    (void)data;
+    return -1;
+}
+
+int Sim_SocketCAN_Poll(Sim_CAN_Frame_Callback_t on_frame)
+{
+    (void)on_frame;
+    return 0;
+}
+
+#endif
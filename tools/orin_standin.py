@@ -0,0 +1,266 @@
+"""
+Stands in for the Jetson Orin on the MCU's Orin link (app/src/orin_link.c).
+
+Reads the huart6 stream, which carries the telemetry frames and the link's state frames,
+answers the MCU's time sync requests on this host's clock (us since the epoch, like the Orin's),
+and sends aim frames toward a target fixed in the world, computed from the latest gimbal
+attitude the MCU reported. Frames are the telemetry stream's, see telemetry_decode.py:
+    state         (0x10, MCU to Orin)  u32 time_us | i16 yaw, pitch, roll /1e4 rad | i16 gyro[3] /1e3 rad/s |
+                                       i16 v_x, v_y /1e3 m/s, omega /1e3 rad/s | u8 flags (1: time_us is ours)
+    aim           (0x11, Orin to MCU)  f32 yaw | f32 pitch, deg relative to the gimbal | u8 flags | u16 age_ms
+    sync request  (0x12, MCU to Orin)  u32 t1
+    sync response (0x13, Orin to MCU)  u32 t1 | u64 t2 | u64 t3, us
+Prints the frames, bytes and losses of each direction once a second, and how late the synced
+state frames arrive against their time stamps: sync error plus the MCU's send latency.
+
+Usage:
+    control-template-sil -s strafe -p -t 20000 &     (prints the pseudo-terminal)
+    python tools/orin_standin.py /dev/pts/N --target-yaw 20 --duration 15
+    python tools/orin_standin.py /dev/ttyUSB0 --baud 921600            (needs pyserial)
+"""
+
+import argparse
+import math
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+from telemetry_decode import HEADER, cobs_decode, crc16_ccitt_false
+
+FRAME_STATE = 0x10
+FRAME_AIM = 0x11
+FRAME_SYNC_REQUEST = 0x12
+FRAME_SYNC_RESPONSE = 0x13
+AIM_TARGET_VALID = 0x01
+STATE_SYNCED = 0x01
+
+STATE = struct.Struct("<I3h3h3hB")
+AIM = struct.Struct("<ffBH")
+SYNC_REQUEST = struct.Struct("<I")
+SYNC_RESPONSE = struct.Struct("<IQQ")
+ANGLE_SCALE = 10000.0
+
+
+def clock_us():
+    return time.time_ns() // 1000
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(int(fraction * len(ordered)), len(ordered) - 1)]
+
+
+def cobs_encode(raw):
+    out = bytearray([0])
+    code_index = 0
+    code = 1
+    for byte in raw:
+        if byte == 0:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+            continue
+        out.append(byte)
+        code += 1
+        if code == 0xFF:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+    out[code_index] = code
+    out.append(0)
+    return bytes(out)
+
+
+class Port:
+    """Non-blocking byte port on a pseudo-terminal or, with pyserial, a serial port."""
+
+    def __init__(self, path, baud):
+        self.serial = None
+        if path.startswith("/dev/pts/"):
+            self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+        else:
+            import serial  # pyserial, only needed on a real port
+            self.serial = serial.Serial(path, baud, timeout=0)
+            self.fd = self.serial.fileno()
+        # what queued up before the stand-in attached, the link statistics start from here
+        termios.tcflush(self.fd, termios.TCIFLUSH)
+
+    def read(self, timeout):
+        if not select.select([self.fd], [], [], timeout)[0]:
+            return b""
+        try:
+            return os.read(self.fd, 4096)
+        except BlockingIOError:
+            return b""
+
+    def write(self, data):
+        os.write(self.fd, data)
+
+
+class Direction:
+    def __init__(self):
+        self.frames = 0
+        self.bytes = 0
+        self.lost = 0
+        self.crc_errors = 0
+        self.framing_errors = 0
+        self.last_sequence = None
+        self.reported_frames = 0
+        self.reported_bytes = 0
+
+    def report(self, name, elapsed):
+        frame_rate = (self.frames - self.reported_frames) / elapsed
+        byte_rate = (self.bytes - self.reported_bytes) / elapsed
+        self.reported_frames = self.frames
+        self.reported_bytes = self.bytes
+        return "%s %6.0f frames/s %7.0f B/s %d lost %d crc %d framing" % (
+            name, frame_rate, byte_rate, self.lost, self.crc_errors, self.framing_errors)
+
+
+class Orin:
+    def __init__(self, port, target_yaw, target_pitch):
+        self.port = port
+        self.target_yaw = target_yaw
+        self.target_pitch = target_pitch
+        self.rx = Direction()
+        self.tx = Direction()
+        self.states = 0
+        self.state = None  # (yaw, pitch, roll) rad
+        self.state_time = None
+        self.sequence = 0
+        self.start = time.monotonic()
+        self.sync_requests = 0
+        self.lateness = []  # us, arrival minus time stamp of the synced state frames, since the last report
+        self.all_lateness = []
+        self.bytes_by_type = {}
+
+    def feed(self, frame, arrival_us):
+        self.rx.bytes += len(frame) + 1
+        try:
+            raw = cobs_decode(frame)
+        except ValueError:
+            self.rx.framing_errors += 1
+            return
+        if len(raw) < HEADER.size + 2:
+            self.rx.framing_errors += 1
+            return
+        body, crc = raw[:-2], struct.unpack_from("<H", raw, len(raw) - 2)[0]
+        if crc16_ccitt_false(body) != crc:
+            self.rx.crc_errors += 1
+            return
+        frame_type, sequence, _ = HEADER.unpack_from(body)
+        if self.rx.last_sequence is not None:
+            self.rx.lost += (sequence - self.rx.last_sequence - 1) & 0xFFFF
+        self.rx.last_sequence = sequence
+        self.rx.frames += 1
+        self.bytes_by_type[frame_type] = self.bytes_by_type.get(frame_type, 0) + len(frame) + 1
+        payload = body[HEADER.size:]
+        if frame_type == FRAME_STATE and len(payload) == STATE.size:
+            fields = STATE.unpack(payload)
+            self.state = tuple(angle / ANGLE_SCALE for angle in fields[1:4])
+            self.state_time = time.monotonic()
+            self.states += 1
+            if fields[10] & STATE_SYNCED:
+                # time_us is the low 32 bits of our clock, the frame is older than 71 minutes never
+                late = (arrival_us - fields[0]) & 0xFFFFFFFF
+                self.lateness.append(late - (1 << 32) if late >= (1 << 31) else late)
+        elif frame_type == FRAME_SYNC_REQUEST and len(payload) == SYNC_REQUEST.size:
+            self.send_sync_response(SYNC_REQUEST.unpack(payload)[0], arrival_us)
+
+    def send_frame(self, frame_type, body):
+        raw = HEADER.pack(frame_type, self.sequence, int((time.monotonic() - self.start) * 1000.0) & 0xFFFFFFFF)
+        raw += body
+        raw += struct.pack("<H", crc16_ccitt_false(raw))
+        encoded = cobs_encode(raw)
+        self.port.write(encoded)
+        self.sequence = (self.sequence + 1) & 0xFFFF
+        self.tx.frames += 1
+        self.tx.bytes += len(encoded)
+
+    def send_sync_response(self, t1, t2):
+        self.sync_requests += 1
+        self.send_frame(FRAME_SYNC_RESPONSE, SYNC_RESPONSE.pack(t1, t2, clock_us()))
+
+    def send_aim(self):
+        if self.state is None:
+            return
+        yaw, pitch, _ = self.state
+        # the MCU's yaw wraps, the offset is the short way round
+        yaw_offset = math.remainder(self.target_yaw - yaw, 2.0 * math.pi)
+        pitch_offset = self.target_pitch - pitch
+        age_ms = min(int((time.monotonic() - self.state_time) * 1000.0), 0xFFFF)
+        self.send_frame(FRAME_AIM, AIM.pack(math.degrees(yaw_offset), math.degrees(pitch_offset),
+                                            AIM_TARGET_VALID, age_ms))
+
+    def report_lateness(self):
+        if not self.lateness:
+            return "no synced states"
+        self.all_lateness += self.lateness
+        text = "state late %d..%d us median %d" % (min(self.lateness), max(self.lateness),
+                                                   percentile(self.lateness, 0.5))
+        self.lateness = []
+        return text
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Jetson Orin stand-in for the MCU's Orin link")
+    parser.add_argument("port", help="pseudo-terminal from control-template-sil -p, or a serial port")
+    parser.add_argument("--baud", type=int, default=921600, help="serial baud rate")
+    parser.add_argument("--rate", type=float, default=100.0, help="aim frames per second")
+    parser.add_argument("--target-yaw", type=float, default=20.0, help="deg, world yaw of the target")
+    parser.add_argument("--target-pitch", type=float, default=0.0, help="deg, world pitch of the target")
+    parser.add_argument("--duration", type=float, default=10.0, help="s to run, 0 for until interrupted")
+    args = parser.parse_args()
+
+    orin = Orin(Port(args.port, args.baud), math.radians(args.target_yaw), math.radians(args.target_pitch))
+    period = 1.0 / args.rate
+    next_aim = time.monotonic()
+    next_report = next_aim + 1.0
+    end = next_aim + args.duration if args.duration > 0 else None
+    pending = bytearray()
+    synced = False  # the first bytes may be the tail of a frame
+    try:
+        while end is None or time.monotonic() < end:
+            pending += orin.port.read(max(0.0, min(next_aim, next_report) - time.monotonic()))
+            arrival_us = clock_us()
+            *frames, rest = pending.split(b"\x00")
+            pending = bytearray(rest)
+            if frames and not synced:
+                frames = frames[1:]
+                synced = True
+            for frame in frames:
+                if frame:
+                    orin.feed(frame, arrival_us)
+            now = time.monotonic()
+            if now >= next_aim:
+                orin.send_aim()
+                next_aim += period
+            if now >= next_report:
+                state = "no state yet" if orin.state is None else "yaw %+.3f rad" % orin.state[0]
+                print("%s | %s | %d states, %s | %s" % (orin.rx.report("rx", 1.0), orin.tx.report("tx", 1.0),
+                                                        orin.states, orin.report_lateness(), state))
+                sys.stdout.flush()
+                next_report += 1.0
+    except KeyboardInterrupt:
+        pass
+
+    elapsed = time.monotonic() - orin.start
+    sys.stderr.write("rx %d frames %d bytes (%.0f B/s) %d lost %d crc errors %d framing errors, %d states\n" % (
+        orin.rx.frames, orin.rx.bytes, orin.rx.bytes / elapsed, orin.rx.lost, orin.rx.crc_errors,
+        orin.rx.framing_errors, orin.states))
+    sys.stderr.write("tx %d frames %d bytes (%.0f B/s), %d sync requests answered\n" % (
+        orin.tx.frames, orin.tx.bytes, orin.tx.bytes / elapsed, orin.sync_requests))
+    for frame_type, count in sorted(orin.bytes_by_type.items()):
+        sys.stderr.write("rx type 0x%02x %.0f B/s\n" % (frame_type, count / elapsed))
+    if orin.all_lateness:
+        sys.stderr.write("synced state frames late by %d us min, %d median, %d p99\n" % (
+            min(orin.all_lateness), percentile(orin.all_lateness, 0.5), percentile(orin.all_lateness, 0.99)))
+
+
+if __name__ == "__main__":
+    main()
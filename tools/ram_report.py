@@ -0,0 +1,170 @@
+"""
+Prints the RAM budget of the firmware build: use per memory region and the largest
+RAM symbols from the linker map, and per task worst case stack depth against the
+stack sizes in app/inc/robot_tasks.h using the -fcallgraph-info=su call graphs.
+
+Usage (normally through `make ram_report`):
+    python tools/ram_report.py --map build/control-template.map --build-dir build --tasks app/inc/robot_tasks.h
+
+Stack depth is a static estimate: callees without a .ci node (newlib, precompiled
+libraries) count as 0 bytes and indirect calls are not followed, both are flagged.
+"""
+
+import argparse
+import re
+from pathlib import Path
+
+# worst case FreeRTOS context on the task stack with the FPU in use:
+# 26 word exception frame + r4-r11, lr + s16-s31
+CONTEXT_SWITCH_BYTES = (26 + 9 + 16) * 4
+
+MEMORY_LINE = re.compile(r"^(\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+OUTPUT_SECTION = re.compile(r"^(\.[\w.]+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+INPUT_SECTION = re.compile(r"^ (\.(?:bss|data)\.[\w.$]+|COMMON)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+)")
+TASK_DEF = re.compile(r"ROBOT_TASK_DEF\(\s*(\w+)\s*,\s*(\w+)\s*,\s*[^,]+,\s*\d+\s*,\s*(\d+)\s*\)")
+CI_NODE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"\\]*)\\n[^"]*?\\n(\d+) bytes \(([^)]*)\)')
+CI_EDGE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+
+
+def parse_map(path):
+    """
+    Returns the RAM regions [(name, origin, length)] and the output and input sections
+    [(name, address, size, object)] from a GNU ld map file.
+    """
+    regions, outputs, inputs = [], [], []
+    lines = Path(path).read_text(errors="replace").splitlines()
+    state = None
+    pending = None
+    for line in lines:
+        if line.startswith("Memory Configuration"):
+            state = "memory"
+            continue
+        if line.startswith("Linker script and memory map"):
+            state = "map"
+            continue
+        if state == "memory":
+            match = MEMORY_LINE.match(line)
+            if match and match.group(1) != "Name":
+                regions.append((match.group(1), int(match.group(2), 16), int(match.group(3), 16)))
+            continue
+        if state != "map":
+            continue
+
+        # long section names put the address and size on the next line
+        if pending is not None:
+            line = pending + line
+            pending = None
+        if re.match(r"^ ?\.[\w.$]+$", line) or line.strip() == "COMMON":
+            pending = line
+            continue
+        match = OUTPUT_SECTION.match(line)
+        if match and match.group(1):
+            outputs.append((match.group(1), int(match.group(2), 16), int(match.group(3), 16), None))
+            continue
+        match = INPUT_SECTION.match(line)
+        if match and match.group(1):
+            inputs.append((match.group(1), int(match.group(2), 16), int(match.group(3), 16), match.group(4)))
+    return regions, outputs, inputs
+
+
+def parse_call_graph(build_dir):
+    """
+    Returns {function: frame bytes}, {function: set(callees)} and the functions with dynamic frames.
+    """
+    frames, calls, dynamic = {}, {}, set()
+    for ci in Path(build_dir).glob("*.ci"):
+        text = ci.read_text(errors="replace")
+        for title, name, size, kind in CI_NODE.findall(text):
+            # static and weak functions are titled "file:name", also index them by bare name
+            for key in {title, name}:
+                frames[key] = max(frames.get(key, 0), int(size))
+                if "dynamic" in kind and "bounded" not in kind:
+                    dynamic.add(key)
+        for source, target in CI_EDGE.findall(text):
+            calls.setdefault(source, set()).add(target)
+            calls.setdefault(source.rsplit(":", 1)[-1], set()).add(target)
+    return frames, calls, dynamic
+
+
+class StackEstimate:
+    def __init__(self, frames, calls, dynamic):
+        self.frames = frames
+        self.calls = calls
+        self.dynamic = dynamic
+        self.memo = {}
+
+    def depth(self, function, notes, active=()):
+        if function in active:
+            notes.add("recursion in " + function)
+            return 0
+        if function == "__indirect_call":
+            notes.add("indirect calls")
+            return 0
+        if function not in self.frames:
+            notes.add("unknown " + function)
+            return 0
+        if function in self.memo:
+            depth, callee_notes = self.memo[function]
+            notes.update(callee_notes)
+            return depth
+        if function in self.dynamic:
+            notes.add("dynamic frame in " + function)
+
+        own_notes = set()
+        deepest = 0
+        for callee in self.calls.get(function, ()):
+            deepest = max(deepest, self.depth(callee, own_notes, active + (function,)))
+        depth = self.frames[function] + deepest
+        self.memo[function] = (depth, own_notes)
+        notes.update(own_notes)
+        return depth
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RAM and task stack budget from the firmware build")
+    parser.add_argument("--map", required=True, help="linker map file")
+    parser.add_argument("--build-dir", required=True, help="directory with the .ci call graph files")
+    parser.add_argument("--tasks", required=True, help="header with the ROBOT_TASK_DEF task table")
+    parser.add_argument("--top", type=int, default=15, help="number of largest RAM symbols to list")
+    args = parser.parse_args()
+
+    regions, outputs, inputs = parse_map(args.map)
+    ram_regions = [region for region in regions if "RAM" in region[0].upper()]
+
+    print("RAM by region")
+    for name, origin, length in ram_regions:
+        sections = [(section, size) for section, address, size, _ in outputs
+                    if size and origin <= address < origin + length]
+        used = sum(size for _, size in sections)
+        print("  %-8s %7d / %7d bytes (%5.1f%%)  %s" % (
+            name, used, length, 100.0 * used / length if length else 0.0,
+            ", ".join("%s %d" % section for section in sections)))
+
+    def in_ram(address):
+        return any(origin <= address < origin + length for _, origin, length in ram_regions)
+
+    symbols = sorted((entry for entry in inputs if entry[2] and in_ram(entry[1])), key=lambda entry: -entry[2])
+    print("\nLargest RAM symbols")
+    for section, _, size, obj in symbols[:args.top]:
+        print("  %7d  %-40s %s" % (size, re.sub(r"^\.(bss|data)\.", "", section), Path(obj).name))
+
+    frames, calls, dynamic = parse_call_graph(args.build_dir)
+    estimate = StackEstimate(frames, calls, dynamic)
+    tasks = TASK_DEF.findall(Path(args.tasks).read_text())
+    print("\nTask stacks (worst case frames + %d bytes context switch)" % CONTEXT_SWITCH_BYTES)
+    print("  %-20s %8s %8s %9s  notes" % ("task", "stack", "used", "headroom"))
+    for name, entry, words in tasks:
+        notes = set()
+        used = estimate.depth(entry, notes) + CONTEXT_SWITCH_BYTES
+        size = int(words) * 4
+        unknown = sorted(note[len("unknown "):] for note in notes if note.startswith("unknown "))
+        flags = sorted(note for note in notes if not note.startswith("unknown "))
+        if unknown:
+            flags.append("%d callees without stack info (%s%s)" % (
+                len(unknown), ", ".join(unknown[:4]), ", ..." if len(unknown) > 4 else ""))
+        print("  %-20s %8d %8d %9d  %s%s" % (name, size, used, size - used,
+                                             "OVERFLOW " if used > size else "", "; ".join(flags)))
+
+
+if __name__ == "__main__":
+    main()
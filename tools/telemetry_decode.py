@@ -0,0 +1,162 @@
+"""
+Decodes the binary telemetry stream from app/src/telemetry.c into CSV.
+
+Frames are COBS encoded and zero delimited. Decoded, each frame is
+    u8 type | u16 sequence | u32 tick_ms | body | u16 CRC-16/CCITT-FALSE
+all little endian. Schema frames describe the channels of the sample frames,
+log frames carry text (printed to stderr here).
+
+Usage:
+    python tools/telemetry_decode.py capture.bin -o capture.csv
+    python tools/telemetry_decode.py /dev/ttyUSB0 --baud 921600 -o live.csv   (needs pyserial)
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+FRAME_SAMPLE = 1
+FRAME_SCHEMA = 2
+FRAME_LOG = 3
+
+HEADER = struct.Struct("<BHI")
+
+# Telemetry_Type_e -> struct format
+TYPE_FORMATS = ["B", "b", "H", "h", "I", "i", "f"]
+
+
+def crc16_ccitt_false(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(encoded):
+    out = bytearray()
+    i = 0
+    while i < len(encoded):
+        code = encoded[i]
+        if code == 0 or i + code > len(encoded):
+            raise ValueError("bad COBS code")
+        out += encoded[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(encoded):
+            out.append(0)
+    return bytes(out)
+
+
+def read_chunks(source, baud):
+    if source == "-":
+        stream = sys.stdin.buffer
+    elif source.startswith("/dev/") or source.upper().startswith("COM"):
+        import serial  # pyserial, only needed for live capture
+        stream = serial.Serial(source, baud, timeout=1)
+    else:
+        stream = open(source, "rb")
+    with stream:
+        while True:
+            chunk = stream.read(4096)
+            if not chunk:
+                if source.startswith("/dev/") or source.upper().startswith("COM"):
+                    continue
+                return
+            yield chunk
+
+
+class Decoder:
+    def __init__(self, writer):
+        self.writer = writer
+        self.channels = None
+        self.sample = None
+        self.last_sequence = None
+        self.frames = 0
+        self.crc_errors = 0
+        self.framing_errors = 0
+        self.lost_frames = 0
+        self.skipped_samples = 0
+
+    def feed(self, frame):
+        try:
+            raw = cobs_decode(frame)
+        except ValueError:
+            self.framing_errors += 1
+            return
+        if len(raw) < HEADER.size + 2:
+            self.framing_errors += 1
+            return
+        body, crc = raw[:-2], struct.unpack_from("<H", raw, len(raw) - 2)[0]
+        if crc16_ccitt_false(body) != crc:
+            self.crc_errors += 1
+            return
+
+        frame_type, sequence, tick = HEADER.unpack_from(body)
+        payload = body[HEADER.size:]
+        if self.last_sequence is not None:
+            self.lost_frames += (sequence - self.last_sequence - 1) & 0xFFFF
+        self.last_sequence = sequence
+        self.frames += 1
+
+        if frame_type == FRAME_SCHEMA:
+            self.on_schema(payload)
+        elif frame_type == FRAME_LOG:
+            sys.stderr.write("[%d ms] %s" % (tick, payload.decode("ascii", "replace")))
+        elif frame_type == FRAME_SAMPLE:
+            if self.sample is None:
+                self.skipped_samples += 1  # no schema yet, one arrives every TELEMETRY_SCHEMA_INTERVAL samples
+                return
+            if len(payload) != self.sample.size:
+                self.framing_errors += 1
+                return
+            self.writer.writerow([tick, sequence] + list(self.sample.unpack(payload)))
+
+    def on_schema(self, payload):
+        count = payload[0]
+        offset = 1
+        channels = []
+        for _ in range(count):
+            channel_type, name_length = payload[offset], payload[offset + 1]
+            name = payload[offset + 2:offset + 2 + name_length].decode("ascii", "replace")
+            channels.append((name, TYPE_FORMATS[channel_type]))
+            offset += 2 + name_length
+        if channels == self.channels:
+            return
+        self.channels = channels
+        self.sample = struct.Struct("<" + "".join(fmt for _, fmt in channels))
+        self.writer.writerow(["tick_ms", "sequence"] + [name for name, _ in channels])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the huart6 binary telemetry stream to CSV")
+    parser.add_argument("source", help="capture file, serial port, or - for stdin")
+    parser.add_argument("-o", "--output", help="CSV output path (default stdout)")
+    parser.add_argument("--baud", type=int, default=921600, help="serial baud rate for live capture")
+    args = parser.parse_args()
+
+    output = open(args.output, "w", newline="") if args.output else sys.stdout
+    decoder = Decoder(csv.writer(output))
+    pending = bytearray()
+    try:
+        for chunk in read_chunks(args.source, args.baud):
+            pending += chunk
+            *frames, pending = pending.split(b"\x00")
+            pending = bytearray(pending)
+            for frame in frames:
+                if frame:
+                    decoder.feed(frame)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if output is not sys.stdout:
+            output.close()
+
+    sys.stderr.write("%d frames, %d lost, %d crc errors, %d framing errors, %d samples before schema\n" % (
+        decoder.frames, decoder.lost_frames, decoder.crc_errors, decoder.framing_errors, decoder.skipped_samples))
+
+
+if __name__ == "__main__":
+    main()